@@ -2,6 +2,7 @@
 
 #include <algorithm>
 
+#include "bus/io_profiler.h"
 #include "bus/system.h"
 
 namespace {
@@ -21,6 +22,20 @@ void PushTable(lua_State *L, const std::string &label, bool val) {
   lua_settable(L, -3);
 }
 
+void PushInteger(lua_State *L, const std::string &label, lua_Integer val) {
+  lua_pushstring(L, label.c_str());
+  lua_pushinteger(L, val);
+  lua_settable(L, -3);
+}
+
+// Adds |counts| to the table on top of the stack.
+void PushCounts(lua_State *L, const IoProfiler::Counts &counts) {
+  PushInteger(L, "reads", static_cast<lua_Integer>(counts.reads));
+  PushInteger(L, "writes", static_cast<lua_Integer>(counts.writes));
+  PushInteger(L, "first_cycle", static_cast<lua_Integer>(counts.first_cycle));
+  PushInteger(L, "last_cycle", static_cast<lua_Integer>(counts.last_cycle));
+}
+
 }  // namespace
 
 // static
@@ -41,6 +56,8 @@ const ::luaL_Reg Automation::c256emu_methods[] = {
     {"load_bin", Automation::LuaLoadBin},
     {"sys", Automation::LuaSys},
     {"trace_log", Automation::LuaTraceLog},
+    {"io_profile", Automation::LuaIoProfile},
+    {"io_profile_reset", Automation::LuaIoProfileReset},
     {0, 0}};
 
 Automation::Automation(WDC65C816 *cpu, DebugInterface *debug_interface)
@@ -225,11 +242,8 @@ int Automation::LuaPeekBuf(lua_State *L) {
   uint32_t start_addr = lua_tointeger(L, -2);
   uint32_t buf_size = lua_tointeger(L, -1);
 
-  uint32_t end_addr(start_addr + buf_size);
-  std::vector<uint8_t> buffer;
-  for (auto i = start_addr; i < end_addr; i++) {
-    buffer.push_back(sys->ReadByte(i));
-  }
+  std::vector<uint8_t> buffer(buf_size);
+  sys->ReadBlock(start_addr, buffer.data(), buf_size);
 
   lua_pushlstring(L, (const char *)buffer.data(), buf_size);
 
@@ -265,6 +279,50 @@ int Automation::LuaSys(lua_State *L) {
   return 0;
 }
 
+// static
+int Automation::LuaIoProfile(lua_State *L) {
+  IoProfiler *profiler = GetSystem(L)->io_profiler();
+  if (!profiler) {
+    lua_pushnil(L);
+    return 1;
+  }
+
+  // { devices = { name = counts, ... }, registers = { counts, ... } }, where
+  // each register's counts also have its addr and device.
+  lua_createtable(L, 0, 2);
+  lua_pushstring(L, "devices");
+  const auto devices = profiler->Devices();
+  lua_createtable(L, 0, devices.size());
+  for (const auto &device : devices) {
+    lua_pushstring(L, device.first.c_str());
+    lua_createtable(L, 0, 4);
+    PushCounts(L, device.second);
+    lua_settable(L, -3);
+  }
+  lua_settable(L, -3);
+
+  lua_pushstring(L, "registers");
+  const auto registers = profiler->Registers();
+  lua_createtable(L, registers.size(), 0);
+  for (size_t i = 0; i < registers.size(); i++) {
+    lua_createtable(L, 0, 6);
+    PushInteger(L, "addr", static_cast<lua_Integer>(registers[i].addr));
+    lua_pushstring(L, "device");
+    lua_pushstring(L, registers[i].device.c_str());
+    lua_settable(L, -3);
+    PushCounts(L, registers[i].counts);
+    lua_rawseti(L, -2, i + 1);
+  }
+  lua_settable(L, -3);
+  return 1;
+}
+
+// static
+int Automation::LuaIoProfileReset(lua_State *L) {
+  if (IoProfiler *profiler = GetSystem(L)->io_profiler()) profiler->Reset();
+  return 0;
+}
+
 // static
 int Automation::LuaTraceLog(lua_State *L) {
   // System *sys = GetSystem(L);
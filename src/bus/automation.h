@@ -61,6 +61,8 @@ class Automation {
   static int LuaLoadBin(lua_State *L);
   static int LuaSys(lua_State *L);
   static int LuaTraceLog(lua_State *L);
+  static int LuaIoProfile(lua_State *L);
+  static int LuaIoProfileReset(lua_State *L);
 
   static const ::luaL_Reg c256emu_methods[];
 
@@ -0,0 +1,61 @@
+#include "bus/guest_memory.h"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+DEFINE_bool(huge_pages, false,
+            "Back guest RAM and VRAM with huge pages, to cut TLB misses");
+
+namespace {
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+size_t RoundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+void *MapAnonymous(size_t size, int flags) {
+  return mmap(nullptr, size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+}
+
+}  // namespace
+
+GuestMemory::GuestMemory(size_t size) : size_(size) {
+  mapped_size_ = RoundUp(size, sysconf(_SC_PAGESIZE));
+  if (!FLAGS_huge_pages) {
+    void *mem = MapAnonymous(mapped_size_, 0);
+    CHECK(mem != MAP_FAILED) << strerror(errno);
+    data_ = static_cast<uint8_t *>(mem);
+    return;
+  }
+
+  const size_t huge_size = RoundUp(size, kHugePageSize);
+  void *mem = MapAnonymous(huge_size, MAP_HUGETLB);
+  if (mem != MAP_FAILED) {
+    mapped_size_ = huge_size;
+    data_ = static_cast<uint8_t *>(mem);
+    return;
+  }
+
+  // No hugetlbfs pages to be had, so ask for transparent huge pages, which
+  // only back ranges aligned to a huge page. Over-allocate and trim.
+  mem = MapAnonymous(mapped_size_ + kHugePageSize, 0);
+  CHECK(mem != MAP_FAILED) << strerror(errno);
+  uint8_t *start = static_cast<uint8_t *>(mem);
+  uint8_t *end = start + mapped_size_ + kHugePageSize;
+  data_ = reinterpret_cast<uint8_t *>(
+      RoundUp(reinterpret_cast<uintptr_t>(start), kHugePageSize));
+  if (data_ > start) munmap(start, data_ - start);
+  if (end > data_ + mapped_size_)
+    munmap(data_ + mapped_size_, end - (data_ + mapped_size_));
+  if (madvise(data_, mapped_size_, MADV_HUGEPAGE) != 0)
+    LOG(WARNING) << "No huge pages: " << strerror(errno);
+}
+
+GuestMemory::~GuestMemory() { munmap(data_, mapped_size_); }
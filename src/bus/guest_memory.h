@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Zeroed memory for guest RAM and VRAM, straight from mmap. The host commits
+// it a page at a time as it is first touched, so untouched memory costs
+// nothing. With --huge_pages it comes in 2MB pages, from hugetlbfs if pages
+// are reserved there and transparent huge pages otherwise.
+class GuestMemory {
+ public:
+  explicit GuestMemory(size_t size);
+  ~GuestMemory();
+
+  GuestMemory(const GuestMemory &) = delete;
+  GuestMemory &operator=(const GuestMemory &) = delete;
+
+  uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  uint8_t *data_;
+  size_t size_;
+  size_t mapped_size_;
+};
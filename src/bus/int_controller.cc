@@ -88,6 +88,13 @@ void InterruptController::LowerCH376() {
   }
 }
 
+void InterruptController::RaiseGavinDma() {
+  if (!pending_reg2_.ints.gavin_dma) {
+    pending_reg2_.ints.gavin_dma = true;
+    sys_->RaiseIRQ();
+  }
+}
+
 void InterruptController::StoreByte(uint32_t addr, uint8_t v) {
   if (addr == kIntPendingReg0) {
     pending_reg0_.val &= ~v;
@@ -15,6 +15,7 @@ public:
   void LowerKeyboard();
   void RaiseCH376();
   void LowerCH376();
+  void RaiseGavinDma();
 
   // SystemBusDevice implementation.
   void StoreByte(uint32_t addr, uint8_t v);
@@ -0,0 +1,284 @@
+#include "bus/intel_hex.h"
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "bus/loader.h"
+
+DEFINE_bool(hex_cache, true, "Cache parsed kernel and program HEX files");
+DEFINE_string(hex_cache_dir, "",
+              "Where to cache parsed HEX files; defaults to "
+              "$XDG_CACHE_HOME/c256emu or ~/.cache/c256emu");
+
+namespace {
+
+constexpr uint64_t kOnes = 0x0101010101010101ULL;
+constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+
+// Sets the top bit of each byte of |x| in [lo, hi]. Bytes must be < 0x80.
+uint64_t BytesInRange(uint64_t x, uint8_t lo, uint8_t hi) {
+  const uint64_t at_least_lo = x + (0x80 - lo) * kOnes;
+  const uint64_t above_hi = x + (0x7F - hi) * kOnes;
+  return at_least_lo & ~above_hi & kHighBits;
+}
+
+// Decodes 8 hex digits at |text| into 4 bytes at |out|, eight digits per
+// step rather than one.
+bool DecodeHex8(const char *text, uint8_t *out) {
+  uint64_t x;
+  memcpy(&x, text, sizeof(x));
+  if (x & kHighBits) return false;
+  const uint64_t digits = BytesInRange(x, '0', '9');
+  const uint64_t letters = BytesInRange(x | 0x20 * kOnes, 'a', 'f');
+  if ((digits | letters) != kHighBits) return false;
+
+  // '0'-'9' give 0-9 from the low nibble; 'A'-'F' and 'a'-'f' give 1-6 and
+  // have bit 6 set, which adds the missing 9.
+  const uint64_t nibbles = (x & 0x0F * kOnes) + ((x >> 6) & kOnes) * 9;
+  // The first digit of each pair is the high nibble.
+  uint64_t w = ((nibbles & 0x000F000F000F000FULL) << 4) |
+               ((nibbles >> 8) & 0x000F000F000F000FULL);
+  w = (w | (w >> 8)) & 0x0000FFFF0000FFFFULL;
+  w = (w | (w >> 16)) & 0xFFFFFFFFULL;
+  const uint32_t bytes = w;
+  memcpy(out, &bytes, sizeof(bytes));
+  return true;
+}
+
+int HexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Decodes |count| bytes of hex digits at |text| into |out|.
+bool DecodeHex(const char *text, size_t count, uint8_t *out) {
+  for (; count >= 4; count -= 4, text += 8, out += 4) {
+    if (!DecodeHex8(text, out)) return false;
+  }
+  for (; count > 0; count--, text += 2, out++) {
+    const int high = HexDigit(text[0]), low = HexDigit(text[1]);
+    if (high < 0 || low < 0) return false;
+    *out = high << 4 | low;
+  }
+  return true;
+}
+
+uint64_t HashBytes(const uint8_t *data, size_t size) {
+  uint64_t hash = 0x9E3779B97F4A7C15ULL ^ size;
+  for (; size >= 8; size -= 8, data += 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 32;
+  }
+  for (; size > 0; size--, data++) {
+    hash = (hash ^ *data) * 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+// Starts every cached image, followed by each segment's address and length
+// as uint32_t and its data.
+struct CacheHeader {
+  static constexpr char kMagic[8] = {'C', '2', '5', '6', 'H', 'E', 'X', '\0'};
+  static constexpr uint32_t kVersion = 2;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t segment_count;
+  uint64_t file_size;
+  int64_t mtime_ns;
+  // Of the HEX file's canonical path, which also names the cache file.
+  uint64_t path_hash;
+};
+
+std::string CacheDir() {
+  if (!FLAGS_hex_cache_dir.empty()) return FLAGS_hex_cache_dir;
+  if (const char *xdg = getenv("XDG_CACHE_HOME")) {
+    if (*xdg) return std::string(xdg) + "/c256emu";
+  }
+  if (const char *home = getenv("HOME"))
+    return std::string(home) + "/.cache/c256emu";
+  return "";
+}
+
+// Makes |dir| and any missing parents.
+bool MakeDirs(const std::string &dir) {
+  for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+    const std::string prefix = dir.substr(0, slash);
+    if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    if (slash == std::string::npos) return true;
+  }
+}
+
+bool ReadCache(const std::string &path, const CacheHeader &expected,
+               std::vector<HexSegment> *segments) {
+  std::ifstream in(path, std::ios::binary);
+  CacheHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      memcmp(header.magic, expected.magic, sizeof(header.magic)) ||
+      header.version != expected.version ||
+      header.file_size != expected.file_size ||
+      header.mtime_ns != expected.mtime_ns ||
+      header.path_hash != expected.path_hash) {
+    return false;
+  }
+  segments->clear();
+  for (uint32_t i = 0; i < header.segment_count; i++) {
+    uint32_t address, length;
+    if (!in.read(reinterpret_cast<char *>(&address), sizeof(address)) ||
+        !in.read(reinterpret_cast<char *>(&length), sizeof(length))) {
+      return false;
+    }
+    segments->push_back({address, std::vector<uint8_t>(length)});
+    if (!in.read(reinterpret_cast<char *>(segments->back().data.data()),
+                 length)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void WriteCache(const std::string &path, CacheHeader header,
+                const std::vector<HexSegment> &segments) {
+  // Written aside and renamed into place, so a concurrent boot never reads
+  // half a file.
+  const std::string temp = path + "." + std::to_string(getpid());
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    header.segment_count = segments.size();
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const HexSegment &segment : segments) {
+      const uint32_t length = segment.data.size();
+      out.write(reinterpret_cast<const char *>(&segment.address),
+                sizeof(segment.address));
+      out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+      out.write(reinterpret_cast<const char *>(segment.data.data()), length);
+    }
+    if (!out) {
+      LOG(WARNING) << "Cannot write " << temp;
+      unlink(temp.c_str());
+      return;
+    }
+  }
+  if (rename(temp.c_str(), path.c_str()) != 0) unlink(temp.c_str());
+}
+
+}  // namespace
+
+bool ParseIntelHex(const char *text, size_t size,
+                   std::vector<HexSegment> *segments, std::string *error) {
+  segments->clear();
+  uint32_t base = 0;
+  int line = 1;
+  uint8_t record[5 + 255];
+  const char *end = text + size;
+  for (const char *p = text; p < end;) {
+    if (*p == '\n' || *p == '\r' || *p == ' ' || *p == '\t') {
+      line += *p == '\n';
+      p++;
+      continue;
+    }
+    if (*p != ':' || end - p < 11 || !DecodeHex(p + 1, 1, record)) {
+      *error = "bad record on line " + std::to_string(line);
+      return false;
+    }
+    // Length, address, type, data and checksum.
+    const size_t length = 5 + record[0];
+    if (static_cast<size_t>(end - p - 1) < 2 * length ||
+        !DecodeHex(p + 1, length, record)) {
+      *error = "bad record on line " + std::to_string(line);
+      return false;
+    }
+    p += 1 + 2 * length;
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < length; i++) checksum += record[i];
+    if (checksum != 0) {
+      *error = "bad checksum on line " + std::to_string(line);
+      return false;
+    }
+
+    const uint8_t *data = &record[4];
+    const uint8_t count = record[0];
+    const uint32_t offset = record[1] << 8 | record[2];
+    switch (record[3]) {
+      case 0x00: {  // Data
+        const uint32_t address = base + offset;
+        if (segments->empty() ||
+            segments->back().address + segments->back().data.size() !=
+                address) {
+          segments->push_back({address, {}});
+        }
+        std::vector<uint8_t> &out = segments->back().data;
+        out.insert(out.end(), data, data + count);
+        break;
+      }
+      case 0x01:  // End of file
+        return true;
+      case 0x02:  // Extended segment address
+        if (count != 2) break;
+        base = (data[0] << 8 | data[1]) << 4;
+        break;
+      case 0x04:  // Extended linear address
+        if (count != 2) break;
+        base = (data[0] << 8 | data[1]) << 16;
+        break;
+      default:  // Start addresses mean nothing to us.
+        break;
+    }
+  }
+  return true;
+}
+
+bool LoadIntelHex(const std::string &filename,
+                  std::vector<HexSegment> *segments, std::string *error) {
+  std::string cache_path;
+  CacheHeader header;
+  if (FLAGS_hex_cache) {
+    // One entry per source file, which a rebuilt file replaces.
+    std::string canonical;
+    if (char *resolved = realpath(filename.c_str(), nullptr)) {
+      canonical = resolved;
+      free(resolved);
+    }
+    struct stat st;
+    const std::string dir = CacheDir();
+    if (!dir.empty() && !canonical.empty() &&
+        stat(canonical.c_str(), &st) == 0) {
+      memcpy(header.magic, CacheHeader::kMagic, sizeof(header.magic));
+      header.version = CacheHeader::kVersion;
+      header.segment_count = 0;
+      header.file_size = st.st_size;
+      header.mtime_ns = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+      header.path_hash =
+          HashBytes(reinterpret_cast<const uint8_t *>(canonical.data()),
+                    canonical.size());
+      char name[32];
+      snprintf(name, sizeof(name), "%016llx.bin",
+               static_cast<unsigned long long>(header.path_hash));
+      cache_path = dir + "/" + name;
+      if (ReadCache(cache_path, header, segments)) {
+        LOG(INFO) << "Using cached image of " << filename;
+        return true;
+      }
+    }
+  }
+
+  const MappedImage text(filename);
+  const char *chars = reinterpret_cast<const char *>(text.data());
+  if (!ParseIntelHex(chars, text.file_size(), segments, error)) return false;
+  if (!cache_path.empty() && MakeDirs(CacheDir()))
+    WriteCache(cache_path, header, *segments);
+  return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A run of contiguous bytes from a HEX file.
+struct HexSegment {
+  uint32_t address;
+  std::vector<uint8_t> data;
+};
+
+// Parses Intel HEX |text| into segments, merging records which follow on
+// from each other. Returns false, with |error| set, on malformed input.
+bool ParseIntelHex(const char *text, size_t size,
+                   std::vector<HexSegment> *segments, std::string *error);
+
+// Parses the Intel HEX file |filename|, or if it has been parsed before,
+// reads the result back from the image cache instead. The cache holds one
+// image per file, by canonical path, which is used while the file's size
+// and modification time are as they were when it was parsed.
+bool LoadIntelHex(const std::string &filename,
+                  std::vector<HexSegment> *segments, std::string *error);
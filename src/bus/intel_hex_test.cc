@@ -0,0 +1,85 @@
+#include <dirent.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+
+#include "bus/intel_hex.h"
+
+DECLARE_string(hex_cache_dir);
+
+namespace {
+
+std::vector<HexSegment> Parse(const std::string &text) {
+  std::vector<HexSegment> segments;
+  std::string error;
+  EXPECT_TRUE(ParseIntelHex(text.data(), text.size(), &segments, &error))
+      << error;
+  return segments;
+}
+
+}  // namespace
+
+TEST(IntelHexTest, MergesContiguousRecords) {
+  const std::vector<HexSegment> segments = Parse(
+      ":020000040018E2\r\n"
+      ":10000000000102030405060708090A0B0C0D0E0F78\r\n"
+      ":03001000aabbccbc\r\n"
+      ":02FFFC000010F3\r\n"
+      ":00000001FF\r\n"
+      ":0100000099\n");
+  ASSERT_EQ(segments.size(), 2u);
+  EXPECT_EQ(segments[0].address, 0x180000u);
+  ASSERT_EQ(segments[0].data.size(), 19u);
+  for (int i = 0; i < 16; i++) EXPECT_EQ(segments[0].data[i], i);
+  EXPECT_EQ(segments[0].data[16], 0xAA);
+  EXPECT_EQ(segments[0].data[18], 0xCC);
+  EXPECT_EQ(segments[1].address, 0x18FFFCu);
+  EXPECT_EQ(segments[1].data, std::vector<uint8_t>({0x00, 0x10}));
+}
+
+TEST(IntelHexTest, RejectsBadRecords) {
+  std::vector<HexSegment> segments;
+  std::string error;
+  for (const std::string text :
+       {":03001000AABBCCBD\n", ":03001000AABBCGBC\n", ":03001000AABB\n",
+        "03001000AABBCCBC\n"}) {
+    EXPECT_FALSE(ParseIntelHex(text.data(), text.size(), &segments, &error))
+        << text;
+  }
+  EXPECT_EQ(error, "bad record on line 1");
+}
+
+TEST(IntelHexTest, CachesParsedImages) {
+  char dir[] = "/tmp/intel_hex_test.XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  FLAGS_hex_cache_dir = std::string(dir) + "/cache";
+  const std::string path = std::string(dir) + "/kernel.hex";
+  std::ofstream(path) << ":03001000AABBCCBC\n:00000001FF\n";
+
+  std::vector<HexSegment> parsed, cached;
+  std::string error;
+  ASSERT_TRUE(LoadIntelHex(path, &parsed, &error)) << error;
+  ASSERT_TRUE(LoadIntelHex(path, &cached, &error)) << error;
+  ASSERT_EQ(cached.size(), 1u);
+  EXPECT_EQ(cached[0].address, parsed[0].address);
+  EXPECT_EQ(cached[0].data, parsed[0].data);
+
+  // A changed file is parsed again.
+  std::ofstream(path) << ":01002000558A\n";
+  ASSERT_TRUE(LoadIntelHex(path, &cached, &error)) << error;
+  ASSERT_EQ(cached.size(), 1u);
+  EXPECT_EQ(cached[0].address, 0x20u);
+  // And replaces the file's entry.
+  int entries = 0;
+  if (DIR *cache = opendir(FLAGS_hex_cache_dir.c_str())) {
+    while (const dirent *entry = readdir(cache))
+      entries += entry->d_name[0] != '.';
+    closedir(cache);
+  }
+  EXPECT_EQ(entries, 1);
+
+  system(("rm -rf " + std::string(dir)).c_str());
+}
@@ -0,0 +1,67 @@
+#include "bus/io_dispatch.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+IoDispatch::IoDispatch() {
+  handlers_.push_back(
+      {nullptr, [](void *, uint32_t) -> uint8_t { return 0; },
+       [](void *, uint32_t, uint8_t) {}, nullptr, nullptr});
+  memset(index_, 0, sizeof(index_));
+}
+
+void IoDispatch::Claim(uint32_t first, uint32_t last, void *context,
+                       ReadHandler read, WriteHandler write,
+                       ReadBlockHandler read_block,
+                       WriteBlockHandler write_block) {
+  CHECK(IsIoAddress(first) && IsIoAddress(last) && first <= last &&
+        (first & 0xFF0000) == (last & 0xFF0000))
+      << "Not an I/O register range: " << std::hex << first << "-" << last;
+  CHECK_LT(handlers_.size(), 0x100u) << "Too many I/O handlers";
+  const uint8_t index = handlers_.size();
+  handlers_.push_back({context, read, write, read_block, write_block});
+  for (uint32_t addr = first; addr <= last; addr++)
+    index_[Slot(addr)] = index;
+}
+
+uint32_t IoDispatch::RunLength(uint32_t addr, uint32_t size) const {
+  const uint8_t index = index_[Slot(addr)];
+  uint32_t length = 1;
+  while (length < size && index_[Slot(addr + length)] == index)
+    length++;
+  return length;
+}
+
+void IoDispatch::ReadBlock(uint32_t addr, uint8_t *data, uint32_t size) const {
+  while (size > 0) {
+    const Handler &handler = handlers_[index_[Slot(addr)]];
+    const uint32_t length = RunLength(addr, size);
+    if (handler.read_block) {
+      handler.read_block(handler.context, addr & 0xFFFF, data, length);
+    } else {
+      for (uint32_t i = 0; i < length; i++)
+        data[i] = handler.read(handler.context, (addr + i) & 0xFFFF);
+    }
+    addr += length;
+    data += length;
+    size -= length;
+  }
+}
+
+void IoDispatch::WriteBlock(uint32_t addr, const uint8_t *data,
+                            uint32_t size) const {
+  while (size > 0) {
+    const Handler &handler = handlers_[index_[Slot(addr)]];
+    const uint32_t length = RunLength(addr, size);
+    if (handler.write_block) {
+      handler.write_block(handler.context, addr & 0xFFFF, data, length);
+    } else {
+      for (uint32_t i = 0; i < length; i++)
+        handler.write(handler.context, (addr + i) & 0xFFFF, data[i]);
+    }
+    addr += length;
+    data += length;
+    size -= length;
+  }
+}
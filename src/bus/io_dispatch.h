@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+// Routes accesses to the C256's I/O registers, at 00:0100-01FF and
+// AF:0000-FFFF, to whichever device claimed them. Every address has a one
+// byte index into the handler table, so an access costs two loads and an
+// indirect call however many devices and register ranges there are.
+class IoDispatch {
+ public:
+  // Handlers get the address within its bank.
+  using ReadHandler = uint8_t (*)(void *context, uint32_t addr);
+  using WriteHandler = void (*)(void *context, uint32_t addr, uint8_t v);
+  // Optional bulk versions, for devices that can do better than a byte at a
+  // time. |addr| is the first address, and the block never leaves the range
+  // the handler claimed.
+  using ReadBlockHandler = void (*)(void *context, uint32_t addr,
+                                    uint8_t *data, uint32_t size);
+  using WriteBlockHandler = void (*)(void *context, uint32_t addr,
+                                     const uint8_t *data, uint32_t size);
+
+  IoDispatch();
+
+  static bool IsIoAddress(uint32_t addr) {
+    return (addr & 0xFF0000) == 0xAF0000 || (addr >= 0x100 && addr <= 0x1FF);
+  }
+
+  // Sends accesses to the 24-bit addresses [first, last] to |read| and
+  // |write|. Claims made later take precedence where they overlap.
+  void Claim(uint32_t first, uint32_t last, void *context, ReadHandler read,
+             WriteHandler write, ReadBlockHandler read_block = nullptr,
+             WriteBlockHandler write_block = nullptr);
+
+  // Claims [first, last] for a pair of |device|'s member functions.
+  template <auto kRead, auto kWrite, class Device>
+  void Claim(uint32_t first, uint32_t last, Device *device) {
+    Claim(
+        first, last, device,
+        [](void *context, uint32_t addr) -> uint8_t {
+          return (static_cast<Device *>(context)->*kRead)(addr);
+        },
+        [](void *context, uint32_t addr, uint8_t v) {
+          (static_cast<Device *>(context)->*kWrite)(addr, v);
+        });
+  }
+
+  // Claims [first, last] for |device|'s ReadByte() and StoreByte().
+  template <class Device>
+  void Claim(uint32_t first, uint32_t last, Device *device) {
+    Claim<&Device::ReadByte, &Device::StoreByte>(first, last, device);
+  }
+
+  // Unclaimed registers read as 0 and ignore writes.
+  uint8_t Read(uint32_t addr) const {
+    const Handler &handler = handlers_[index_[Slot(addr)]];
+    return handler.read(handler.context, addr & 0xFFFF);
+  }
+  void Write(uint32_t addr, uint8_t v) const {
+    const Handler &handler = handlers_[index_[Slot(addr)]];
+    handler.write(handler.context, addr & 0xFFFF, v);
+  }
+
+  // Accesses |size| registers from |addr| on, which must all be I/O
+  // addresses in the same bank.
+  void ReadBlock(uint32_t addr, uint8_t *data, uint32_t size) const;
+  void WriteBlock(uint32_t addr, const uint8_t *data, uint32_t size) const;
+
+  // The context of the handler for |addr|, which identifies its device.
+  void *context(uint32_t addr) const {
+    return handlers_[index_[Slot(addr)]].context;
+  }
+
+  // Every I/O address has a slot numbered below kNumSlots. Bank AF takes the
+  // first 64k, 00:01xx the last 256.
+  static constexpr uint32_t kNumSlots = 0x10000 + 0x100;
+  static uint32_t Slot(uint32_t addr) {
+    return (addr & 0xFF0000) ? addr & 0xFFFF : 0x10000 + (addr & 0xFF);
+  }
+  static uint32_t SlotAddress(uint32_t slot) {
+    return slot < 0x10000 ? 0xAF0000 | slot : 0x100 | (slot & 0xFF);
+  }
+
+ private:
+  struct Handler {
+    void *context;
+    ReadHandler read;
+    WriteHandler write;
+    ReadBlockHandler read_block;
+    WriteBlockHandler write_block;
+  };
+
+  // Number of registers from |addr| on, up to |size|, sharing its handler.
+  uint32_t RunLength(uint32_t addr, uint32_t size) const;
+
+  std::vector<Handler> handlers_;
+  uint8_t index_[kNumSlots];
+};
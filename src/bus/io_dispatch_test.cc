@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "bus/io_dispatch.h"
+
+namespace {
+
+// Remembers the last write and reads back |id|.
+class Register {
+ public:
+  explicit Register(uint8_t id) : id_(id) {}
+
+  uint8_t ReadByte(uint32_t addr) { return id_; }
+  void StoreByte(uint32_t addr, uint8_t v) {
+    last_addr = addr;
+    last_value = v;
+  }
+  void StoreTwice(uint32_t addr, uint8_t v) { StoreByte(addr, v * 2); }
+
+  uint32_t last_addr = 0;
+  uint8_t last_value = 0;
+
+ private:
+  uint8_t id_;
+};
+
+}  // namespace
+
+TEST(IoDispatchTest, RoutesToClaimingDevice) {
+  IoDispatch io;
+  Register vicky(1), keyboard(2), math(3);
+  io.Claim(0xAF0000, 0xAFFFFF, &vicky);
+  io.Claim(0xAF1060, 0xAF1060, &keyboard);
+  io.Claim(0x000100, 0x00012F, &math);
+
+  EXPECT_EQ(io.Read(0xAF0000), 1);
+  EXPECT_EQ(io.Read(0xAF1060), 2);
+  EXPECT_EQ(io.Read(0xAF1061), 1);
+  EXPECT_EQ(io.Read(0x000100), 3);
+  EXPECT_EQ(io.Read(0x00012F), 3);
+  // Unclaimed registers read as 0, and bank 0 doesn't alias bank AF.
+  EXPECT_EQ(io.Read(0x000130), 0);
+  io.Write(0x000130, 0x55);
+  EXPECT_EQ(vicky.last_value, 0);
+
+  io.Write(0xAF1060, 0x12);
+  EXPECT_EQ(keyboard.last_addr, 0x1060u);
+  EXPECT_EQ(keyboard.last_value, 0x12);
+  io.Write(0x000120, 0x34);
+  EXPECT_EQ(math.last_addr, 0x120u);
+  EXPECT_EQ(math.last_value, 0x34);
+}
+
+TEST(IoDispatchTest, MemberFunctionHandlers) {
+  IoDispatch io;
+  Register sprites(7);
+  io.Claim<&Register::ReadByte, &Register::StoreTwice>(0xAF0200, 0xAF02FF,
+                                                        &sprites);
+  io.Write(0xAF0208, 0x21);
+  EXPECT_EQ(sprites.last_addr, 0x208u);
+  EXPECT_EQ(sprites.last_value, 0x42);
+  EXPECT_EQ(io.Read(0xAF02FF), 7);
+  EXPECT_EQ(io.Read(0xAF0300), 0);
+}
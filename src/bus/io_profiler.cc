@@ -0,0 +1,77 @@
+#include "bus/io_profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+IoProfiler::IoProfiler(const IoDispatch *io)
+    : io_(io), counts_(IoDispatch::kNumSlots) {}
+
+void IoProfiler::NameDevice(const void *context, const std::string &name) {
+  names_[context] = name;
+}
+
+std::vector<IoProfiler::Register> IoProfiler::Registers() const {
+  std::vector<Register> registers;
+  for (uint32_t slot = 0; slot < counts_.size(); slot++) {
+    const Counts &counts = counts_[slot];
+    if (counts.reads + counts.writes == 0) continue;
+    const uint32_t addr = IoDispatch::SlotAddress(slot);
+    const auto name = names_.find(io_->context(addr));
+    registers.push_back(
+        {addr, name == names_.end() ? "unclaimed" : name->second, counts});
+  }
+  // Bank 0's registers come last in slot order.
+  std::stable_partition(registers.begin(), registers.end(),
+                        [](const Register &r) { return r.addr < 0x10000; });
+  return registers;
+}
+
+std::map<std::string, IoProfiler::Counts> IoProfiler::Devices() const {
+  std::map<std::string, Counts> devices;
+  for (const Register &r : Registers()) {
+    auto inserted = devices.insert({r.device, r.counts});
+    if (inserted.second) continue;
+    Counts &device = inserted.first->second;
+    device.reads += r.counts.reads;
+    device.writes += r.counts.writes;
+    device.first_cycle = std::min(device.first_cycle, r.counts.first_cycle);
+    device.last_cycle = std::max(device.last_cycle, r.counts.last_cycle);
+  }
+  return devices;
+}
+
+void IoProfiler::Reset() {
+  std::fill(counts_.begin(), counts_.end(), Counts());
+}
+
+void IoProfiler::Report(std::ostream &out, size_t max_registers) const {
+  auto row = [&out](const std::string &what, const Counts &counts) {
+    out << std::left << std::setw(16) << what << std::right << std::setw(12)
+        << counts.reads << std::setw(12) << counts.writes << std::setw(16)
+        << counts.first_cycle << std::setw(16) << counts.last_cycle << "\n";
+  };
+  auto header = [&out](const std::string &what) {
+    out << std::left << std::setw(16) << what << std::right << std::setw(12)
+        << "reads" << std::setw(12) << "writes" << std::setw(16)
+        << "first cycle" << std::setw(16) << "last cycle" << "\n";
+  };
+
+  header("device");
+  for (const auto &device : Devices()) row(device.first, device.second);
+
+  std::vector<Register> registers = Registers();
+  std::stable_sort(registers.begin(), registers.end(),
+                   [](const Register &a, const Register &b) {
+                     return a.counts.reads + a.counts.writes >
+                            b.counts.reads + b.counts.writes;
+                   });
+  if (registers.size() > max_registers) registers.resize(max_registers);
+  header("register");
+  for (const Register &r : registers) {
+    std::ostringstream label;
+    label << std::hex << std::uppercase << std::setfill('0') << std::setw(6)
+          << r.addr << " " << r.device;
+    row(label.str(), r.counts);
+  }
+}
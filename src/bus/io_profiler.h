@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "bus/io_dispatch.h"
+
+// Counts the CPU's reads and writes of each I/O register, with the cycles
+// of the first and last, to find the registers a guest hammers. Registers
+// are attributed to devices through the contexts they were claimed with.
+class IoProfiler {
+ public:
+  struct Counts {
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t first_cycle = 0;
+    uint64_t last_cycle = 0;
+  };
+  struct Register {
+    uint32_t addr;
+    std::string device;
+    Counts counts;
+  };
+
+  explicit IoProfiler(const IoDispatch *io);
+
+  // Names the device whose handlers were claimed with |context|.
+  void NameDevice(const void *context, const std::string &name);
+
+  void NoteRead(uint32_t addr, uint64_t cycle) { Note(addr, cycle)->reads++; }
+  void NoteWrite(uint32_t addr, uint64_t cycle) {
+    Note(addr, cycle)->writes++;
+  }
+
+  // The registers accessed since the last Reset(), in address order.
+  std::vector<Register> Registers() const;
+  // Totals for each device accessed.
+  std::map<std::string, Counts> Devices() const;
+  void Reset();
+
+  // Writes the device totals, then the |max_registers| busiest registers.
+  void Report(std::ostream &out, size_t max_registers) const;
+
+ private:
+  Counts *Note(uint32_t addr, uint64_t cycle) {
+    Counts *counts = &counts_[IoDispatch::Slot(addr)];
+    if (counts->reads + counts->writes == 0) counts->first_cycle = cycle;
+    counts->last_cycle = cycle;
+    return counts;
+  }
+
+  const IoDispatch *io_;
+  std::map<const void *, std::string> names_;
+  std::vector<Counts> counts_;
+};
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "bus/io_profiler.h"
+
+namespace {
+
+class Device {
+ public:
+  uint8_t ReadByte(uint32_t addr) { return 0; }
+  void StoreByte(uint32_t addr, uint8_t v) {}
+};
+
+}  // namespace
+
+TEST(IoProfilerTest, CountsRegistersAndDevices) {
+  IoDispatch io;
+  Device vicky, math;
+  io.Claim(0xAF0000, 0xAFFFFF, &vicky);
+  io.Claim(0x000100, 0x00012F, &math);
+  IoProfiler profiler(&io);
+  profiler.NameDevice(&vicky, "vicky");
+  profiler.NameDevice(&math, "math");
+
+  profiler.NoteRead(0xAF1064, 10);
+  profiler.NoteRead(0xAF1064, 20);
+  profiler.NoteWrite(0xAF1064, 30);
+  profiler.NoteWrite(0x000100, 5);
+  profiler.NoteRead(0x000130, 7);
+
+  const std::vector<IoProfiler::Register> registers = profiler.Registers();
+  ASSERT_EQ(registers.size(), 3u);
+  EXPECT_EQ(registers[0].addr, 0x100u);
+  EXPECT_EQ(registers[0].device, "math");
+  EXPECT_EQ(registers[1].addr, 0x130u);
+  EXPECT_EQ(registers[1].device, "unclaimed");
+  EXPECT_EQ(registers[2].addr, 0xAF1064u);
+  EXPECT_EQ(registers[2].counts.reads, 2u);
+  EXPECT_EQ(registers[2].counts.writes, 1u);
+  EXPECT_EQ(registers[2].counts.first_cycle, 10u);
+  EXPECT_EQ(registers[2].counts.last_cycle, 30u);
+
+  const auto devices = profiler.Devices();
+  EXPECT_EQ(devices.at("vicky").reads, 2u);
+  EXPECT_EQ(devices.at("math").writes, 1u);
+
+  std::ostringstream report;
+  profiler.Report(report, 1);
+  EXPECT_NE(report.str().find("AF1064 vicky"), std::string::npos);
+  EXPECT_EQ(report.str().find("000100 math"), std::string::npos);
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.Registers().empty());
+}
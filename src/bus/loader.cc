@@ -1,11 +1,38 @@
 #include "loader.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <vector>
 
 #include <srecord/input/file.h>
 #include <srecord/record.h>
 
-void LoadFromHex(const std::string &filename, SystemBus *system_bus) {
+#include "bus/intel_hex.h"
+#include "bus/system.h"
+
+void LoadFromHex(const std::string &filename, System *system) {
+  char first = 0;
+  std::ifstream(filename).get(first);
+  if (first == ':') {
+    // Intel HEX, which is what the C256 toolchains produce.
+    LOG(INFO) << "Loading: " << filename << " (Intel HEX)";
+    std::vector<HexSegment> segments;
+    std::string error;
+    CHECK(LoadIntelHex(filename, &segments, &error)) << filename << ": "
+                                                     << error;
+    for (const HexSegment &segment : segments)
+      system->WriteBlock(segment.address, segment.data.data(),
+                         segment.data.size());
+    return;
+  }
+
   try {
     auto input = srecord::input_file::guess(filename);
     CHECK(input.get());
@@ -13,13 +40,8 @@ void LoadFromHex(const std::string &filename, SystemBus *system_bus) {
               << input->get_file_format_name() << ")";
     srecord::record record;
     while (input->read(record)) {
-      uint32_t address = record.get_address();
-      size_t num_bytes = record.get_length();
-      const srecord::record::data_t *v = record.get_data();
-      while (num_bytes--) {
-        system_bus->WriteByte(address, *v++);
-        address++;
-      }
+      system->WriteBlock(record.get_address(), record.get_data(),
+                         record.get_length());
     }
   } catch (std::exception e) {
     CHECK(false) << e.what();
@@ -28,14 +50,36 @@ void LoadFromHex(const std::string &filename, SystemBus *system_bus) {
 }
 
 void LoadFromBin(const std::string &filename, uint32_t base_address,
-                 SystemBus *system_bus) {
-  std::ifstream in_file(filename);
-  CHECK(in_file.is_open());
-  uint32_t address = base_address;
-  char byte;
-  while (in_file.get(byte)) {
-    system_bus->WriteByte(address, byte);
-    address++;
+                 System *system) {
+  const MappedImage image(filename);
+  system->WriteBlock(base_address, image.data(), image.file_size());
+  LOG(INFO) << "Done @ " << base_address + image.file_size();
+}
+
+MappedImage::MappedImage(const std::string &filename, size_t min_size) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  CHECK(fd >= 0) << filename << ": " << strerror(errno);
+  struct stat st;
+  CHECK(fstat(fd, &st) == 0) << filename << ": " << strerror(errno);
+  file_size_ = st.st_size;
+
+  // Reserve zeroed memory for the whole image, then put the file over the
+  // start of it; touching pages of a file mapping beyond the end of the file
+  // would fault.
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  mapped_size_ = std::max<size_t>(
+      (std::max(file_size_, min_size) + page_size - 1) & ~(page_size - 1),
+      page_size);
+  void *mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  CHECK(mem != MAP_FAILED) << filename << ": " << strerror(errno);
+  if (file_size_ > 0) {
+    CHECK(mmap(mem, file_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+               fd, 0) != MAP_FAILED)
+        << filename << ": " << strerror(errno);
   }
-  LOG(INFO) << "Done @ " << address;
-}
\ No newline at end of file
+  close(fd);
+  data_ = static_cast<uint8_t *>(mem);
+}
+
+MappedImage::~MappedImage() { munmap(data_, mapped_size_); }
@@ -3,8 +3,28 @@
 #include <string>
 #include <glog/logging.h>
 
-#include "cpu.h"
+class System;
 
-extern void LoadFromHex(const std::string &filename, SystemBus *system_bus);
+extern void LoadFromHex(const std::string &filename, System *system);
 extern void LoadFromBin(const std::string &filename,
-                        uint32_t base_address, SystemBus *system_bus);
+                        uint32_t base_address, System *system);
+
+// A file mapped copy-on-write: the pages come straight from the page cache
+// until written, and writes never reach the file. The mapping is at least
+// |min_size| bytes, zero filled past the end of the file.
+class MappedImage {
+ public:
+  explicit MappedImage(const std::string &filename, size_t min_size = 0);
+  ~MappedImage();
+
+  MappedImage(const MappedImage &) = delete;
+  MappedImage &operator=(const MappedImage &) = delete;
+
+  uint8_t *data() const { return data_; }
+  size_t file_size() const { return file_size_; }
+
+ private:
+  uint8_t *data_;
+  size_t file_size_;
+  size_t mapped_size_;
+};
@@ -3,8 +3,9 @@
 RAMDevice::RAMDevice(const Address &base_address, const Address &end_address)
     : region_(SystemBusDevice::MemoryRegion{
           base_address.AsInt(), end_address.AsInt(),
-          new uint8_t[Address::Size(base_address, end_address)]}) {
-  bzero(region_.mem, region_.end_address - region_.start_address);
+          // end_address is inclusive.
+          new uint8_t[Address::Size(base_address, end_address) + 1]}) {
+  bzero(region_.mem, Size() + 1);
 }
 
 void RAMDevice::StoreByte(const Address &addr, uint8_t v, uint8_t **address) {
@@ -48,4 +49,10 @@ std::vector<SystemBusDevice::MemoryRegion> RAMDevice::GetMemoryRegions() {
   return {region_};
 }
 
+bool RAMDevice::GetDecodedRanges(std::vector<AddressRange> *ranges) {
+  // All memory, which the bus reaches through the memory regions.
+  ranges->clear();
+  return true;
+}
+
 SystemBusDevice::MemoryRegion RAMDevice::region() const { return region_; }
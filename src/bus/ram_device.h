@@ -13,6 +13,7 @@ public:
 
   // SystemBusDevice implementation
   std::vector<MemoryRegion> GetMemoryRegions() override;
+  bool GetDecodedRanges(std::vector<AddressRange> *ranges) override;
   void StoreByte(const Address &addr, uint8_t v, uint8_t **address) override;
   uint8_t ReadByte(const Address &addr, uint8_t **address) override;
   bool DecodeAddress(const Address &from_addr, Address &to_addr) override;
@@ -40,4 +40,4 @@ TEST(MemoryTest, AddressRead) {
   bus.StoreWord(Address(0x0, 0x00), 0xfeba);
   bus.StoreByte(Address(0x0, 0x02), 0xca);
   EXPECT_EQ(bus.ReadAddressAt(Address(0x0, 0x00)), Address(0xca, 0xfeba));
-}
\ No newline at end of file
+}
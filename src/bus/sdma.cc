@@ -0,0 +1,157 @@
+#include "bus/sdma.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t kSdmaCtrlReg0 = 0x180;
+constexpr uint32_t kSdmaSrcAddr = 0x182;
+constexpr uint32_t kSdmaDstAddr = 0x185;
+// 24 bits in 1D mode.
+constexpr uint32_t kSdmaSize = 0x188;
+// 16 bits each in 2D mode.
+constexpr uint32_t kSdmaXSize = 0x188;
+constexpr uint32_t kSdmaYSize = 0x18A;
+constexpr uint32_t kSdmaSrcStride = 0x18C;
+constexpr uint32_t kSdmaDstStride = 0x18E;
+constexpr uint32_t kSdmaByteToWrite = 0x190;
+constexpr uint32_t kSdmaStatusReg = 0x191;
+
+constexpr uint8_t kCtrl0Enable = 0x01;
+constexpr uint8_t kCtrl02D = 0x02;
+constexpr uint8_t kCtrl0Fill = 0x04;
+constexpr uint8_t kCtrl0IntEnable = 0x08;
+constexpr uint8_t kCtrl0SysRamSrc = 0x10;
+constexpr uint8_t kCtrl0SysRamDst = 0x20;
+constexpr uint8_t kCtrl0Start = 0x80;
+
+constexpr uint8_t kStatusSizeError = 0x01;
+constexpr uint8_t kStatusDstAddrError = 0x02;
+constexpr uint8_t kStatusSrcAddrError = 0x04;
+// Our own: set while a transfer is in flight, as VDMA does.
+constexpr uint8_t kStatusBusy = 0x80;
+
+// Both system RAM and VRAM addresses are 22 bits; VRAM's are from its base.
+constexpr uint32_t kMemorySize = 0x400000;
+constexpr uint32_t kVramBase = 0xB00000;
+
+// GAVIN moves a byte per CPU clock.
+constexpr uint64_t kCyclesPerByte = 1;
+
+}  // namespace
+
+Sdma::Sdma(Host *host) : host_(host) {}
+
+void Sdma::Reset() {
+  memset(regs_, 0, sizeof(regs_));
+  status_ = 0;
+  busy_ = false;
+  epoch_++;
+}
+
+uint32_t Sdma::Register16(uint32_t addr) const {
+  const uint8_t *r = &regs_[addr - kSdmaCtrlReg0];
+  return r[0] | r[1] << 8;
+}
+
+uint32_t Sdma::Register24(uint32_t addr) const {
+  const uint8_t *r = &regs_[addr - kSdmaCtrlReg0];
+  return r[0] | r[1] << 8 | r[2] << 16;
+}
+
+void Sdma::StoreByte(uint32_t addr, uint8_t v) {
+  if (addr < kSdmaCtrlReg0 || addr >= kSdmaCtrlReg0 + sizeof(regs_)) return;
+  // Registers are latched for the length of a transfer.
+  if (busy_ || addr == kSdmaStatusReg) return;
+  const uint8_t previous = regs_[addr - kSdmaCtrlReg0];
+  regs_[addr - kSdmaCtrlReg0] = v;
+  // Starts on the rising edge of the start bit.
+  if (addr == kSdmaCtrlReg0 && (v & kCtrl0Enable) && (v & kCtrl0Start) &&
+      !(previous & kCtrl0Start)) {
+    Start();
+  }
+}
+
+uint8_t Sdma::ReadByte(uint32_t addr) {
+  if (addr == kSdmaStatusReg) return status_ | (busy_ ? kStatusBusy : 0);
+  if (addr < kSdmaCtrlReg0 || addr >= kSdmaCtrlReg0 + sizeof(regs_)) return 0;
+  return regs_[addr - kSdmaCtrlReg0];
+}
+
+void Sdma::Start() {
+  const uint8_t ctrl = regs_[0];
+  Transfer &t = transfer_;
+  if (ctrl & kCtrl02D) {
+    t.width = Register16(kSdmaXSize);
+    t.height = Register16(kSdmaYSize);
+    // The engine ignores the bottom bit of strides.
+    t.src_stride = Register16(kSdmaSrcStride) & ~1;
+    t.dst_stride = Register16(kSdmaDstStride) & ~1;
+  } else {
+    t.width = Register24(kSdmaSize);
+    t.height = 1;
+    t.src_stride = t.dst_stride = 0;
+  }
+  t.src = Register24(kSdmaSrcAddr);
+  t.dst = Register24(kSdmaDstAddr);
+  t.fill = ctrl & kCtrl0Fill;
+  t.fill_byte = regs_[kSdmaByteToWrite - kSdmaCtrlReg0];
+  t.interrupt = ctrl & kCtrl0IntEnable;
+
+  status_ = 0;
+  const uint64_t size = static_cast<uint64_t>(t.width) * t.height;
+  auto end = [&t](uint32_t addr, uint32_t stride) {
+    return addr + static_cast<uint64_t>(stride) * (t.height - 1) + t.width;
+  };
+  if (size == 0 || size > kMemorySize) {
+    status_ |= kStatusSizeError;
+  } else {
+    if (!t.fill && end(t.src, t.src_stride) > kMemorySize)
+      status_ |= kStatusSrcAddrError;
+    if (end(t.dst, t.dst_stride) > kMemorySize)
+      status_ |= kStatusDstAddrError;
+  }
+  if (status_) {
+    LOG(WARNING) << "SDMA transfer refused, status " << std::hex
+                 << static_cast<int>(status_);
+    return;
+  }
+  if (!(ctrl & kCtrl0SysRamSrc)) t.src += kVramBase;
+  if (!(ctrl & kCtrl0SysRamDst)) t.dst += kVramBase;
+
+  busy_ = true;
+  host_->ScheduleEvent(host_->cycle() + size * kCyclesPerByte,
+                       [this, epoch = epoch_]() {
+                         if (epoch == epoch_) Finish();
+                       });
+}
+
+void Sdma::Finish() {
+  const Transfer &t = transfer_;
+  for (uint32_t row = 0; row < t.height; row++) {
+    if (t.fill)
+      FillRow(t.dst + row * t.dst_stride, t.width);
+    else
+      CopyRow(t.src + row * t.src_stride, t.dst + row * t.dst_stride, t.width);
+  }
+  busy_ = false;
+  if (t.interrupt) host_->RaiseInterrupt();
+}
+
+void Sdma::CopyRow(uint32_t src, uint32_t dst, uint32_t size) {
+  // Straight between the memories, as GAVIN does. A row which runs into
+  // unmapped memory reads as 0 or isn't written, as a whole.
+  uint8_t *to = host_->Memory(dst, size);
+  if (!to) return;
+  if (const uint8_t *from = host_->Memory(src, size))
+    memmove(to, from, size);
+  else
+    memset(to, 0, size);
+}
+
+void Sdma::FillRow(uint32_t dst, uint32_t size) {
+  if (uint8_t *to = host_->Memory(dst, size))
+    memset(to, transfer_.fill_byte, size);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+// GAVIN's system DMA controller at 00:0180-019F. Copies or fills linear
+// (1D) or strided rectangular (2D) blocks between system RAM and VRAM. The
+// transfer happens a block at a time when it completes, at the emulated
+// cycle its length implies, which is also when the gavin_dma interrupt is
+// raised.
+class Sdma {
+ public:
+  // The rest of the machine, as the controller sees it.
+  class Host {
+   public:
+    virtual ~Host() = default;
+    virtual uint64_t cycle() const = 0;
+    // Runs |event| when the CPU gets to |cycle|.
+    virtual void ScheduleEvent(uint64_t cycle,
+                               std::function<void()> event) = 0;
+    // Host memory for the |size| bytes of RAM or VRAM at bus address
+    // |addr|, or null if they aren't all mapped.
+    virtual uint8_t *Memory(uint32_t addr, uint32_t size) = 0;
+    // Raises gavin_dma.
+    virtual void RaiseInterrupt() = 0;
+  };
+
+  explicit Sdma(Host *host);
+
+  // Back to the power-on state. A transfer in flight is abandoned, and its
+  // completion event does nothing when it comes.
+  void Reset();
+
+  // SystemBusDevice implementation
+  void StoreByte(uint32_t addr, uint8_t v);
+  uint8_t ReadByte(uint32_t addr);
+
+ private:
+  // A transfer of |height| rows of |width| bytes, with bus addresses.
+  struct Transfer {
+    uint32_t src;
+    uint32_t dst;
+    uint32_t width;
+    uint32_t height;
+    uint32_t src_stride;
+    uint32_t dst_stride;
+    bool fill;
+    uint8_t fill_byte;
+    bool interrupt;
+  };
+
+  void Start();
+  void Finish();
+  void CopyRow(uint32_t src, uint32_t dst, uint32_t size);
+  void FillRow(uint32_t dst, uint32_t size);
+
+  uint32_t Register16(uint32_t addr) const;
+  uint32_t Register24(uint32_t addr) const;
+
+  Host *host_;
+
+  uint8_t regs_[0x20] = {};
+  uint8_t status_ = 0;
+  bool busy_ = false;
+  // Bumped by Reset(), so that completions scheduled before it are ignored.
+  uint32_t epoch_ = 0;
+  Transfer transfer_;
+};
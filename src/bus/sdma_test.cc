@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "bus/sdma.h"
+
+namespace {
+
+constexpr uint32_t kCtrl = 0x180;
+constexpr uint32_t kSrc = 0x182;
+constexpr uint32_t kDst = 0x185;
+constexpr uint32_t kSize = 0x188;
+constexpr uint32_t kYSize = 0x18A;
+constexpr uint32_t kSrcStride = 0x18C;
+constexpr uint32_t kDstStride = 0x18E;
+constexpr uint32_t kFillByte = 0x190;
+constexpr uint32_t kStatus = 0x191;
+
+constexpr uint8_t kEnable = 0x01;
+constexpr uint8_t k2D = 0x02;
+constexpr uint8_t kFill = 0x04;
+constexpr uint8_t kIntEnable = 0x08;
+constexpr uint8_t kSysRamSrc = 0x10;
+constexpr uint8_t kSysRamDst = 0x20;
+constexpr uint8_t kStart = 0x80;
+
+constexpr uint32_t kVram = 0xB00000;
+
+// 16MB of memory, partly mapped, and an event queue run by hand.
+class FakeHost : public Sdma::Host {
+ public:
+  FakeHost() : memory(0x1000000) {}
+
+  uint64_t cycle() const override { return cycle_; }
+  void ScheduleEvent(uint64_t cycle, std::function<void()> event) override {
+    events_.emplace(cycle, std::move(event));
+  }
+  uint8_t *Memory(uint32_t addr, uint32_t size) override {
+    // The top half of VRAM stands in for unmapped memory.
+    if (addr + size > kVram + 0x200000) return nullptr;
+    return &memory[addr];
+  }
+  void RaiseInterrupt() override { interrupts++; }
+
+  // Runs the events due up to |cycle|.
+  void RunTo(uint64_t cycle) {
+    while (!events_.empty() && events_.begin()->first <= cycle) {
+      cycle_ = events_.begin()->first;
+      std::function<void()> event = std::move(events_.begin()->second);
+      events_.erase(events_.begin());
+      event();
+    }
+    cycle_ = cycle;
+  }
+
+  std::vector<uint8_t> memory;
+  int interrupts = 0;
+
+ private:
+  uint64_t cycle_ = 1000;
+  std::multimap<uint64_t, std::function<void()>> events_;
+};
+
+}  // namespace
+
+class SdmaTest : public ::testing::Test {
+ protected:
+  void Store(uint32_t addr, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) sdma.StoreByte(addr + i, v >> (8 * i));
+  }
+
+  FakeHost host;
+  Sdma sdma{&host};
+};
+
+TEST_F(SdmaTest, CopiesLinearBlockWhenDone) {
+  for (int i = 0; i < 0x1000; i++) host.memory[0x10000 + i] = i * 5;
+  Store(kSrc, 0x10000, 3);
+  Store(kDst, 0x100, 3);
+  Store(kSize, 0x1000, 3);
+  sdma.StoreByte(kCtrl, kEnable | kIntEnable | kSysRamSrc | kStart);
+
+  // Busy for a cycle per byte, and nothing moves until then.
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0x80);
+  host.RunTo(1000 + 0xFFF);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0x80);
+  EXPECT_EQ(host.memory[kVram + 0x100], 0);
+  EXPECT_EQ(host.interrupts, 0);
+  // Registers are latched meanwhile.
+  Store(kDst, 0x200, 3);
+  EXPECT_EQ(sdma.ReadByte(kDst + 1), 0x01);
+
+  host.RunTo(1000 + 0x1000);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0);
+  EXPECT_EQ(host.interrupts, 1);
+  EXPECT_EQ(memcmp(&host.memory[kVram + 0x100], &host.memory[0x10000], 0x1000),
+            0);
+
+  // Another transfer needs the start bit to go low first.
+  sdma.StoreByte(kCtrl, kEnable | kSysRamSrc | kStart);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0);
+}
+
+TEST_F(SdmaTest, CopiesRectangleWithStrides) {
+  for (int i = 0; i < 0x100; i++) host.memory[kVram + i] = i;
+  Store(kSrc, 0, 3);
+  Store(kDst, 0x20000, 3);
+  Store(kSize, 4, 2);
+  Store(kYSize, 3, 2);
+  // The bottom bit of strides is ignored.
+  Store(kSrcStride, 0x11, 2);
+  Store(kDstStride, 8, 2);
+  sdma.StoreByte(kCtrl, kEnable | k2D | kSysRamDst | kStart);
+  host.RunTo(1000 + 12);
+
+  for (int row = 0; row < 3; row++) {
+    for (int col = 0; col < 8; col++) {
+      EXPECT_EQ(host.memory[0x20000 + row * 8 + col],
+                col < 4 ? row * 0x10 + col : 0)
+          << row << "," << col;
+    }
+  }
+  EXPECT_EQ(host.interrupts, 0);
+}
+
+TEST_F(SdmaTest, Fills) {
+  Store(kDst, 0x30000, 3);
+  Store(kSize, 0x20000, 3);
+  sdma.StoreByte(kFillByte, 0xAB);
+  sdma.StoreByte(kCtrl, kEnable | kFill | kSysRamDst | kStart);
+  host.RunTo(1000 + 0x20000);
+
+  EXPECT_EQ(host.memory[0x2FFFF], 0);
+  for (uint32_t i = 0x30000; i < 0x50000; i++)
+    ASSERT_EQ(host.memory[i], 0xAB) << i;
+  EXPECT_EQ(host.memory[0x50000], 0);
+}
+
+TEST_F(SdmaTest, RefusesBadTransfers) {
+  // Nothing to move.
+  sdma.StoreByte(kCtrl, kEnable | kStart);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0x01);
+
+  // Past the end of the source.
+  sdma.StoreByte(kCtrl, 0);
+  Store(kSrc, 0x3FFF00, 3);
+  Store(kSize, 0x200, 3);
+  sdma.StoreByte(kCtrl, kEnable | kStart);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0x04);
+
+  // Past the end of the destination, in 2D.
+  sdma.StoreByte(kCtrl, 0);
+  Store(kSrc, 0, 3);
+  Store(kDst, 0x3F8000, 3);
+  Store(kSize, 0x100, 2);
+  Store(kYSize, 0x100, 2);
+  Store(kDstStride, 0x100, 2);
+  sdma.StoreByte(kCtrl, kEnable | k2D | kStart);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0x02);
+
+  host.RunTo(0x10000000);
+  EXPECT_EQ(host.interrupts, 0);
+}
+
+TEST_F(SdmaTest, ResetAbandonsTransfer) {
+  host.memory[0x10000] = 0x55;
+  Store(kSrc, 0x10000, 3);
+  Store(kSize, 0x100, 3);
+  sdma.StoreByte(kCtrl, kEnable | kIntEnable | kSysRamSrc | kStart);
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0x80);
+
+  sdma.Reset();
+  EXPECT_EQ(sdma.ReadByte(kStatus), 0);
+  EXPECT_EQ(sdma.ReadByte(kSrc + 2), 0);
+  host.RunTo(1000 + 0x100);
+  EXPECT_EQ(host.memory[kVram], 0);
+  EXPECT_EQ(host.interrupts, 0);
+}
+
+TEST_F(SdmaTest, UnmappedMemory) {
+  memset(&host.memory[0x1000], 0x55, 0x200);
+  Store(kSrc, 0x1FFF00, 3);
+  Store(kDst, 0x1000, 3);
+  Store(kSize, 0x200, 3);
+  sdma.StoreByte(kCtrl, kEnable | kSysRamDst | kStart);
+  host.RunTo(1000 + 0x200);
+  // Reads as 0.
+  for (int i = 0; i < 0x200; i++) ASSERT_EQ(host.memory[0x1000 + i], 0) << i;
+
+  // Swallows writes.
+  sdma.StoreByte(kCtrl, 0);
+  Store(kSrc, 0x1000, 3);
+  Store(kDst, 0x1FFF00, 3);
+  sdma.StoreByte(kFillByte, 0xAB);
+  sdma.StoreByte(kCtrl, kEnable | kFill | kStart);
+  host.RunTo(1000 + 0x400);
+  EXPECT_EQ(host.memory[kVram + 0x1FFF00], 0);
+}
@@ -2,12 +2,21 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
 #include "bus/ch376_sd.h"
+#include "bus/guest_memory.h"
 #include "bus/int_controller.h"
+#include "bus/io_dispatch.h"
+#include "bus/io_profiler.h"
 #include "bus/keyboard.h"
 #include "bus/loader.h"
 #include "bus/math_copro.h"
 #include "bus/rtc.h"
+#include "bus/sdma.h"
 #include "bus/vicky.h"
 
 namespace {
@@ -24,28 +33,71 @@ constexpr uint64_t kTargetClockRate = 14318000;
 constexpr int kRasterLinesPerSecond = kVickyBitmapHeight * kVickyTargetFps;
 
 DEFINE_bool(turbo, false, "Enable turbo mode; do not throttle to 60fps/14mhz");
+DEFINE_bool(io_profile, false,
+            "Count accesses to each I/O register, for c256emu.io_profile() "
+            "and a report at exit");
 
 }  // namespace
 
-class C256SystemBus : public SystemBus {
+class C256SystemBus : public SystemBus, private Sdma::Host {
  public:
-  C256SystemBus(System *sys) {
+  C256SystemBus(System *sys) : sys_(sys) {
     math_co_ = std::make_unique<MathCoprocessor>();
     int_controller_ = std::make_unique<InterruptController>(sys);
     // TODO: Timers 0x160 - 0x17f
-    // TODO: SDMA: 0x180-0x19f
     keyboard_ = std::make_unique<Keyboard>(sys, int_controller_.get());
     vicky_ = std::make_unique<Vicky>(sys, int_controller_.get());
     rtc_ = std::make_unique<Rtc>();
     sd_ = std::make_unique<CH376SD>(int_controller_.get(), ".");
+    sdma_ = std::make_unique<Sdma>(this);
     InitBus();
+    if (FLAGS_io_profile) {
+      io_profiler_ = std::make_unique<IoProfiler>(&io_);
+      io_profiler_->NameDevice(math_co_.get(), "math_copro");
+      io_profiler_->NameDevice(int_controller_.get(), "int_controller");
+      io_profiler_->NameDevice(keyboard_.get(), "keyboard");
+      io_profiler_->NameDevice(vicky_.get(), "vicky");
+      io_profiler_->NameDevice(rtc_.get(), "rtc");
+      io_profiler_->NameDevice(sd_.get(), "ch376_sd");
+      io_profiler_->NameDevice(sdma_.get(), "sdma");
+    }
   }
   virtual ~C256SystemBus() = default;
 
   InterruptController *int_controller() const { return int_controller_.get(); }
   Vicky *vicky() const { return vicky_.get(); }
+  Sdma *sdma() const { return sdma_.get(); }
+  // Null unless --io_profile.
+  IoProfiler *io_profiler() const { return io_profiler_.get(); }
+
+  void ReadBlock(uint32_t addr, uint8_t *data, uint32_t size);
+  void WriteBlock(uint32_t addr, const uint8_t *data, uint32_t size);
+
+  // Maps |image| as the 512k of flash at |addr|, 0xF00000 for system flash
+  // or 0xF80000 for user flash.
+  void MapFlash(std::unique_ptr<MappedImage> image, uint32_t addr);
+
+  static constexpr uint32_t kFlashSize = 0x80000;
 
  private:
+  static constexpr uint32_t kPageBits = 12;
+  static constexpr uint32_t kPageSize = 1 << kPageBits;
+  static constexpr uint32_t kNumPages = 1 << (24 - kPageBits);
+  static constexpr uint32_t kRamSize = 0x400000;
+  // How much of the RAM is mapped at address 0, and where VRAM goes.
+  static constexpr uint32_t kMappedRamSize = 0x200000;
+  static constexpr uint32_t kVramAddr = 0xB00000;
+  static constexpr uint32_t kVramSize = 0x400000;
+
+  // Number of bytes from |addr| on, up to |size| and within its page, that
+  // are all I/O registers or all memory.
+  uint32_t RunLength(uint32_t addr, uint32_t size, bool *io) const;
+
+  // One byte of an access through the I/O path, which can run on from the
+  // registers into memory.
+  uint8_t IoReadByte(uint32_t addr);
+  void IoWriteByte(uint32_t addr, uint8_t v);
+
   void InitBus();
   static bool IsIoDeviceAddress(void *context, cpuaddr_t addr);
   static void IoRead(void *context, cpuaddr_t addr, uint8_t *data,
@@ -53,62 +105,116 @@ class C256SystemBus : public SystemBus {
   static void IoWrite(void *context, cpuaddr_t addr, const uint8_t *data,
                       uint32_t size);
 
+  // Sdma::Host implementation
+  uint64_t cycle() const override { return sys_->cpu()->cpu_state.cycle; }
+  void ScheduleEvent(uint64_t cycle, std::function<void()> event) override {
+    sys_->ScheduleEvent(cycle, std::move(event));
+  }
+  uint8_t *Memory(uint32_t addr, uint32_t size) override;
+  void RaiseInterrupt() override { int_controller_->RaiseGavinDma(); }
+
+  System *sys_;
   std::unique_ptr<MathCoprocessor> math_co_;
   std::unique_ptr<InterruptController> int_controller_;
   std::unique_ptr<Vicky> vicky_;
   std::unique_ptr<Keyboard> keyboard_;
   std::unique_ptr<Rtc> rtc_;
   std::unique_ptr<CH376SD> sd_;
-  Page pages[4096];
-  uint8_t ram_[0x400000];
+  std::unique_ptr<Sdma> sdma_;
+  std::unique_ptr<MappedImage> flash_[2];
+  IoDispatch io_;
+  std::unique_ptr<IoProfiler> io_profiler_;
+  Page pages[kNumPages];
+  // From mmap rather than inline, so untouched RAM costs nothing.
+  GuestMemory ram_{kRamSize};
 };
 
 bool C256SystemBus::IsIoDeviceAddress(void *context, cpuaddr_t addr) {
-  return ((addr & 0xFF0000) == 0xAF0000) || (addr >= 0x100 && addr <= 0x1FF);
+  return IoDispatch::IsIoAddress(addr);
 }
 void C256SystemBus::IoRead(void *context, cpuaddr_t addr, uint8_t *data,
                            uint32_t size) {
   C256SystemBus *self = (C256SystemBus *)context;
-  if ((addr & 0xFF0000) == 0xAF0000) {
-    addr &= 0xFFFF;
-    if (addr >= 0xE808 && addr <= 0xE810)
-      *data = self->sd_->ReadByte(addr);
-    else if (addr == 0x1060 || addr == 0x1064)
-      *data = self->keyboard_->ReadByte(addr);
-    else if (addr >= 0x800 && addr <= 0x80F)
-      *data = self->rtc_->ReadByte(addr);
-    else
-      *data = self->vicky_->ReadByte(addr);
-  } else if (addr >= 0x100 && addr < 0x1A0) {
-    if (addr < 0x130)
-      *data = self->math_co_->ReadByte(addr);
-    else if (addr >= 0x140 && addr <= 0x14F)
-      *data = self->int_controller_->ReadByte(addr);
-  }
+  for (uint32_t i = 0; i < size; i++)
+    data[i] = self->IoReadByte((addr + i) & 0xFFFFFF);
 }
 void C256SystemBus::IoWrite(void *context, cpuaddr_t addr, const uint8_t *data,
                             uint32_t size) {
   C256SystemBus *self = (C256SystemBus *)context;
-  if ((addr & 0xFF0000) == 0xAF0000) {
-    addr &= 0xFFFF;
-    if (addr >= 0xE808 && addr <= 0xE810)
-      self->sd_->StoreByte(addr, *data);
-    else if (addr == 0x1060 || addr == 0x1064)
-      self->keyboard_->StoreByte(addr, *data);
-    else if (addr >= 0x800 && addr <= 0x80F)
-      self->rtc_->StoreByte(addr, *data);
+  for (uint32_t i = 0; i < size; i++)
+    self->IoWriteByte((addr + i) & 0xFFFFFF, data[i]);
+}
+
+uint8_t C256SystemBus::IoReadByte(uint32_t addr) {
+  const Page &p = pages[addr >> kPageBits];
+  if ((addr & p.io_mask) != p.io_eq)
+    return p.ptr ? p.ptr[addr & (kPageSize - 1)] : 0;
+  if (io_profiler_) io_profiler_->NoteRead(addr, cycle());
+  return io_.Read(addr);
+}
+
+void C256SystemBus::IoWriteByte(uint32_t addr, uint8_t v) {
+  const Page &p = pages[addr >> kPageBits];
+  if ((addr & p.io_mask) != p.io_eq) {
+    if (p.ptr && !(p.flags & Page::kReadOnly))
+      p.ptr[addr & (kPageSize - 1)] = v;
+    return;
+  }
+  if (io_profiler_) io_profiler_->NoteWrite(addr, cycle());
+  io_.Write(addr, v);
+}
+
+uint32_t C256SystemBus::RunLength(uint32_t addr, uint32_t size,
+                                 bool *io) const {
+  const Page &p = pages[addr >> kPageBits];
+  const uint32_t in_page = std::min(size, kPageSize - (addr & (kPageSize - 1)));
+  *io = (addr & p.io_mask) == p.io_eq;
+  if (p.io_mask == 0)
+    return in_page;
+  uint32_t length = 1;
+  while (length < in_page &&
+         (((addr + length) & p.io_mask) == p.io_eq) == *io)
+    length++;
+  return length;
+}
+
+void C256SystemBus::ReadBlock(uint32_t addr, uint8_t *data, uint32_t size) {
+  while (size > 0) {
+    addr &= 0xFFFFFF;
+    bool io;
+    const uint32_t length = RunLength(addr, size, &io);
+    const Page &p = pages[addr >> kPageBits];
+    if (io)
+      io_.ReadBlock(addr, data, length);
+    else if (p.ptr)
+      memcpy(data, p.ptr + (addr & (kPageSize - 1)), length);
     else
-      self->vicky_->StoreByte(addr, *data);
-  } else if (addr >= 0x100 && addr < 0x1A0) {
-    if (addr < 0x130)
-      self->math_co_->StoreByte(addr, *data);
-    else if (addr >= 0x140 && addr <= 0x14F)
-      self->int_controller_->StoreByte(addr, *data);
+      memset(data, 0, length);
+    addr += length;
+    data += length;
+    size -= length;
+  }
+}
+
+void C256SystemBus::WriteBlock(uint32_t addr, const uint8_t *data,
+                               uint32_t size) {
+  while (size > 0) {
+    addr &= 0xFFFFFF;
+    bool io;
+    const uint32_t length = RunLength(addr, size, &io);
+    const Page &p = pages[addr >> kPageBits];
+    if (io)
+      io_.WriteBlock(addr, data, length);
+    else if (p.ptr && !(p.flags & Page::kReadOnly))
+      memcpy(p.ptr + (addr & (kPageSize - 1)), data, length);
+    addr += length;
+    data += length;
+    size -= length;
   }
 }
 
 void C256SystemBus::InitBus() {
-  Init(12, 24, pages);
+  Init(kPageBits, 24, pages);
 
   constexpr uint32_t kPagesPer64k = 16;
   // Init memory map
@@ -135,10 +241,9 @@ void C256SystemBus::InitBus() {
   }
 
   // Map the various regions
-  Map(0, ram_, 0x200000);
-  Map(0xB00000, vicky_->vram(), 0x400000);
-  // Map(sysflash.get(), 0xF00000);
-  // Map(userflash.get(), 0xF80000);
+  Map(0, ram_.data(), kMappedRamSize);
+  Map(kVramAddr, vicky_->vram(), kVramSize);
+  // Flash at 0xF00000 and 0xF80000 is mapped by MapFlash().
 
   io_devices.context = this;
   io_devices.read = &IoRead;
@@ -147,32 +252,72 @@ void C256SystemBus::InitBus() {
   // IRQ controller should be asserting and deasserting the IRQs
   io_devices.irq_taken = [](void *, uint32_t) {};
 
+  // Vicky has all of bank AF bar the other devices' registers.
+  vicky_->ClaimIo(&io_);
+  io_.Claim(0xAF0800, 0xAF080F, rtc_.get());
+  io_.Claim(0xAF1060, 0xAF1060, keyboard_.get());
+  io_.Claim(0xAF1064, 0xAF1064, keyboard_.get());
+  io_.Claim(0xAFE808, 0xAFE810, sd_.get());
+  io_.Claim(0x000100, 0x00012F, math_co_.get());
+  io_.Claim(0x000140, 0x00014F, int_controller_.get());
+  io_.Claim(0x000180, 0x00019F, sdma_.get());
+
   vicky_->InitPages(&pages[0xAF * kPagesPer64k]);
 }
 
+uint8_t *C256SystemBus::Memory(uint32_t addr, uint32_t size) {
+  if (addr + size <= kMappedRamSize) return ram_.data() + addr;
+  if (addr >= kVramAddr && addr + size <= kVramAddr + kVramSize)
+    return vicky_->vram() + (addr - kVramAddr);
+  return nullptr;
+}
+
+void C256SystemBus::MapFlash(std::unique_ptr<MappedImage> image,
+                             uint32_t addr) {
+  CHECK(addr == 0xF00000 || addr == 0xF80000);
+  if (image->file_size() > kFlashSize)
+    LOG(WARNING) << "Flash image truncated to " << kFlashSize << " bytes";
+  // The pages stay read-only to the CPU.
+  Map(addr, image->data(), kFlashSize);
+  flash_[addr == 0xF80000] = std::move(image);
+}
+
 System::System()
     : system_bus_(std::make_unique<C256SystemBus>(this)),
       cpu_(system_bus_.get()),
       debug_(&cpu_, &events_, system_bus_.get(), true) {}
 
-System::~System() {}
+System::~System() {
+  if (IoProfiler *profiler = io_profiler()) {
+    std::ostringstream report;
+    profiler->Report(report, 64);
+    LOG(INFO) << "I/O profile:\n" << report.str();
+  }
+}
 
 void System::LoadHex(const std::string &kernel_hex_file) {
   // GAVIN copies up to 512k flash mem to kernel mem.
-  LoadFromHex(kernel_hex_file, system_bus_.get());
+  LoadFromHex(kernel_hex_file, this);
 }
 
 void System::LoadBin(const std::string &kernel_bin_file, uint32_t addr) {
   // GAVIN copies up to 512k flash mem to kernel mem.
-  LoadFromBin(kernel_bin_file, addr, system_bus_.get());
+  LoadFromBin(kernel_bin_file, addr, this);
+}
+
+void System::MapFlash(const std::string &flash_bin_file, uint32_t addr) {
+  LOG(INFO) << "Mapping " << flash_bin_file << " @ " << std::hex << addr;
+  system_bus_->MapFlash(
+      std::make_unique<MappedImage>(flash_bin_file, C256SystemBus::kFlashSize),
+      addr);
 }
 
 void System::Initialize() {
   // Copy Bank 18 to Bank 0
   LOG(INFO) << "Copying flash bank 18 to bank 0...";
-  for (int i = 0; i < 1 << 16; i++) {
-    system_bus_->WriteByte(i, system_bus_->ReadByte(0x180000 + i));
-  }
+  std::vector<uint8_t> bank(1 << 16);
+  system_bus_->ReadBlock(0x180000, bank.data(), bank.size());
+  system_bus_->WriteBlock(0, bank.data(), bank.size());
 
   LOG(INFO) << "Starting Vicky...";
 
@@ -180,11 +325,22 @@ void System::Initialize() {
   system_bus_->vicky()->Start();
 
   LOG(INFO) << "Starting CPU...";
+  Reset();
+}
+
+void System::Reset() {
+  system_bus_->sdma()->Reset();
 
   // Lower the reset pin.
   cpu_.PowerOn();
 }
 
+void System::ScheduleEvent(uint64_t cycle, std::function<void()> event) {
+  events_.ScheduleNoLock(cycle, std::move(event));
+}
+
+IoProfiler *System::io_profiler() { return system_bus_->io_profiler(); }
+
 void System::Sys(uint32_t address) {
   cpu_.cpu_state.ip = address & 0xFFFF;
   cpu_.cpu_state.code_segment_base = address & 0xFF0000;
@@ -264,6 +420,14 @@ void System::StoreTwoBytes(uint32_t addr, uint16_t val) {
   system_bus_->WriteByte(addr + 1, val >> 8);
 }
 
+void System::ReadBlock(uint32_t addr, uint8_t *data, uint32_t size) {
+  system_bus_->ReadBlock(addr, data, size);
+}
+
+void System::WriteBlock(uint32_t addr, const uint8_t *data, uint32_t size) {
+  system_bus_->WriteBlock(addr, data, size);
+}
+
 void System::RaiseIRQ() { cpu_.cpu_state.SetInterruptSource(1); }
 
 void System::ClearIRQ() { cpu_.cpu_state.ClearInterruptSource(1); }
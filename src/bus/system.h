@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -10,6 +11,7 @@
 #include "debug_interface.h"
 
 class C256SystemBus;
+class IoProfiler;
 
 // Owns and configures all bus devices and the CPU.
 class System {
@@ -21,8 +23,15 @@ class System {
 
   void LoadBin(const std::string &kernel_bin_file, uint32_t addr);
 
+  // Map a .bin image copy-on-write as flash at |addr|, without copying it.
+  void MapFlash(const std::string &flash_bin_file, uint32_t addr);
+
   void Initialize();
 
+  // Resets the CPU and the devices which have state of their own, such as
+  // transfers in flight.
+  void Reset();
+
   // Launch the loop thread and run the CPU.
   void Start(bool profile);
 
@@ -35,11 +44,24 @@ class System {
   void StoreByte(uint32_t addr, uint8_t val);
   void StoreTwoBytes(uint32_t addr, uint16_t val);
 
+  // Copy blocks of any size, a page at a time: straight to or from memory,
+  // or through the devices' handlers for I/O registers. Writes to read-only
+  // pages are dropped and unmapped memory reads as 0.
+  void ReadBlock(uint32_t addr, uint8_t *data, uint32_t size);
+  void WriteBlock(uint32_t addr, const uint8_t *data, uint32_t size);
+
   // Jump to address.
   void Sys(uint32_t address);
 
   WDC65C816 *cpu() { return &cpu_; }
 
+  // Runs |event| when the CPU gets to |cycle|. Only from the CPU thread,
+  // e.g. from an I/O register handler.
+  void ScheduleEvent(uint64_t cycle, std::function<void()> event);
+
+  // Counts of I/O register accesses, or null without --io_profile.
+  IoProfiler *io_profiler();
+
   DebugInterface *GetDebugInterface();
 
  protected:
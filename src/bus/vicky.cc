@@ -5,6 +5,7 @@
 #include <thread>
 
 #include "bus/int_controller.h"
+#include "bus/io_dispatch.h"
 #include "bus/keyboard.h"
 #include "bus/sdl_to_atset_keymap.h"
 #include "bus/system.h"
@@ -53,7 +54,6 @@ Vicky::Vicky(System *system, InterruptController *int_controller)
     : sys_(system), int_controller_(int_controller) {
   memset(fg_colour_mem_, 0, sizeof(fg_colour_mem_));
   memset(bg_colour_mem_, 0, sizeof(bg_colour_mem_));
-  memset(video_ram_, 0, sizeof(video_ram_));
   memset(tile_sets_, 0, sizeof(tile_sets_));
   memset(sprites_, 0, sizeof(sprites_));
 }
@@ -100,6 +100,22 @@ Vicky::~Vicky() {
 
 uint8_t Vicky::ReadByte(uint32_t addr) { return 0; }
 
+void Vicky::ClaimIo(IoDispatch *io) {
+  io->Claim(0xAF0000, 0xAFFFFF, this);
+  io->Claim<&Vicky::ReadByte, &Vicky::StoreTileSetRegister>(
+      0xAF0000 + TL0_CONTROL_REG, 0xAF0000 + TL3_MAP_Y_STRIDE_H, this);
+  io->Claim<&Vicky::ReadByte, &Vicky::StoreSpriteRegister>(
+      0xAF0000 + SP00_CONTROL_REG, 0xAF0000 + SP31_CONTROL_REG + 7, this);
+  io->Claim<&Vicky::ReadByte, &Vicky::StoreMouseCursor>(
+      0xAF0000 + MOUSE_PTR_GRAP0_START, 0xAF0000 + MOUSE_PTR_GRAP1_END, this);
+  io->Claim<&Vicky::ReadByte, &Vicky::StoreCharacterLut>(
+      0xAF0000 + FG_CHAR_LUT_PTR, 0xAF1FBF, this);
+  io->Claim<&Vicky::ReadByte, &Vicky::StoreGammaLut>(
+      0xAF0000 + GAMMA_B_LUT_PTR, 0xAF42FF, this);
+  io->Claim<&Vicky::ReadByte, &Vicky::StoreTileMap>(
+      0xAF0000 + TILE_MAP0, 0xAF0000 + TILE_MAP3 + 0x7FF, this);
+}
+
 void Vicky::StoreByte(uint32_t addr, uint8_t v) {
   uint16_t offset = addr;
 
@@ -139,27 +155,6 @@ void Vicky::StoreByte(uint32_t addr, uint8_t v) {
       return;
   }
 
-  if (addr >= FG_CHAR_LUT_PTR && addr < BG_CHAR_LUT_PTR) {
-    memcpy((uint8_t *)fg_colour_mem_ + addr - FG_CHAR_LUT_PTR, &v, 1);
-    return;
-  } else if (addr >= BG_CHAR_LUT_PTR && addr < 0x1fc0) {
-    memcpy((uint8_t *)bg_colour_mem_ + addr - BG_CHAR_LUT_PTR, &v, 1);
-    return;
-  } else if (addr >= GAMMA_B_LUT_PTR && addr < GAMMA_G_LUT_PTR) {
-    gamma_.b[addr & 0xFF] = v;
-    return;
-  } else if (addr >= GAMMA_G_LUT_PTR && addr < GAMMA_R_LUT_PTR) {
-    gamma_.g[addr & 0xFF] = v;
-    return;
-  } else if (addr >= GAMMA_R_LUT_PTR && addr < 0x4300) {
-    gamma_.r[addr & 0xFF] = v;
-    return;
-  } else if (addr >= MOUSE_PTR_GRAP0_START && addr <= MOUSE_PTR_GRAP0_END) {
-    mouse_cursor_0_[addr - MOUSE_PTR_GRAP0_START] = v;
-  } else if (addr >= MOUSE_PTR_GRAP1_START && addr <= MOUSE_PTR_GRAP1_END) {
-    mouse_cursor_1_[addr - MOUSE_PTR_GRAP1_START] = v;
-  }
-
   if (addr == BM_CONTROL_REG) {
     bitmap_enabled_ = v & 0x01;
     bitmap_lut_ = (v & 0b01110000) >> 4;
@@ -171,80 +166,10 @@ void Vicky::StoreByte(uint32_t addr, uint8_t v) {
     return;
   }
 
-  if (addr >= TL0_CONTROL_REG && addr <= TL3_MAP_Y_STRIDE_H) {
-    uint16_t sprite_offset = offset - TL0_CONTROL_REG;
-    uint8_t tile_num = sprite_offset / 8;
-    uint8_t register_num = sprite_offset % 8;
-    if (register_num == 0) {
-      tile_sets_[tile_num].enabled = v & 0x01;
-      tile_sets_[tile_num].lut = (v & 0b00001110) >> 1;
-      tile_sets_[tile_num].tiled_sheet = (v & 0x80);
-    } else if (register_num == 1) {
-      tile_sets_[tile_num].start_addr =
-          (tile_sets_[tile_num].start_addr & 0x00ffff00) | v;
-    } else if (register_num == 2) {
-      tile_sets_[tile_num].start_addr =
-          (tile_sets_[tile_num].start_addr & 0x00ff00ff) | (v << 8);
-    } else if (register_num == 3) {
-      tile_sets_[tile_num].start_addr =
-          (tile_sets_[tile_num].start_addr & 0x0000ffff) | (v << 16);
-    } else if (register_num == 4) {
-      Binary::setLower8BitsOf16BitsValue(&tile_sets_[tile_num].stride_x, v);
-    } else if (register_num == 5) {
-      Binary::setHigher8BitsOf16BitsValue(&tile_sets_[tile_num].stride_x, v);
-    } else if (register_num == 6) {
-      Binary::setLower8BitsOf16BitsValue(&tile_sets_[tile_num].stride_y, v);
-    } else if (register_num == 7) {
-      Binary::setHigher8BitsOf16BitsValue(&tile_sets_[tile_num].stride_y, v);
-    } else {
-      LOG(ERROR) << "Unsupported tile reg: " << register_num;
-    }
-    return;
-  }
-
-  if (addr >= TILE_MAP0 && addr <= TILE_MAP3 + 2048) {
-    uint16_t tile_offset = offset - TILE_MAP0;
-    uint8_t tile_num = tile_offset / 0x800;
-    uint8_t map_offset = tile_offset % 0x800;
-    tile_sets_[tile_num].tile_map.mem[map_offset] = v;
-    return;
-  }
-
   if (Set24(addr, BACKGROUND_COLOR_B, &background_bgr_.v, v)) {
     return;
   }
 
-  if (addr >= SP00_CONTROL_REG && addr <= SP31_CONTROL_REG + 8) {
-    uint16_t sprite_offset = offset - SP00_CONTROL_REG;
-    uint16_t sprite_num = sprite_offset / 0x08;
-    uint16_t register_num = sprite_offset % 0x08;
-    Sprite &sprite = sprites_[sprite_num];
-    if (register_num == 0) /* control register */ {
-      uint8_t layer = (v & 0b01110000) >> 4;
-      sprite.layer = layer;
-      sprite.enabled = v & 0x01;
-      sprite.lut = (v & 0b00001110) >> 1;
-      sprite.tile_striding = (v & 0x80);
-    } else if (register_num == 1) {
-      sprite.start_addr = (sprite.start_addr & 0x00ffff00) | v;
-    } else if (register_num == 2) {
-      sprite.start_addr = (sprite.start_addr & 0x00ff00ff) | (v << 8);
-    } else if (register_num == 3) {
-      sprite.start_addr = (sprite.start_addr & 0x0000ffff) | (v << 16);
-    } else if (register_num == 4) {
-      Binary::setLower8BitsOf16BitsValue(&sprite.x, v);
-    } else if (register_num == 5) {
-      Binary::setHigher8BitsOf16BitsValue(&sprite.x, v);
-    } else if (register_num == 6) {
-      Binary::setLower8BitsOf16BitsValue(&sprite.y, v);
-    } else if (register_num == 7) {
-      Binary::setHigher8BitsOf16BitsValue(&sprite.y, v);
-    } else {
-      LOG(ERROR) << "Unsupported sprite reg: " << register_num;
-    }
-    return;
-  }
-
   if (addr == VKY_TXT_CURSOR_CTRL_REG) {
     cursor_reg_ = v;
     return;
@@ -270,6 +195,96 @@ void Vicky::StoreByte(uint32_t addr, uint8_t v) {
   LOG(INFO) << "Unknown Vicky register: " << addr;
 }
 
+void Vicky::StoreTileSetRegister(uint32_t addr, uint8_t v) {
+  uint16_t sprite_offset = addr - TL0_CONTROL_REG;
+  uint8_t tile_num = sprite_offset / 8;
+  uint8_t register_num = sprite_offset % 8;
+  if (register_num == 0) {
+    tile_sets_[tile_num].enabled = v & 0x01;
+    tile_sets_[tile_num].lut = (v & 0b00001110) >> 1;
+    tile_sets_[tile_num].tiled_sheet = (v & 0x80);
+  } else if (register_num == 1) {
+    tile_sets_[tile_num].start_addr =
+        (tile_sets_[tile_num].start_addr & 0x00ffff00) | v;
+  } else if (register_num == 2) {
+    tile_sets_[tile_num].start_addr =
+        (tile_sets_[tile_num].start_addr & 0x00ff00ff) | (v << 8);
+  } else if (register_num == 3) {
+    tile_sets_[tile_num].start_addr =
+        (tile_sets_[tile_num].start_addr & 0x0000ffff) | (v << 16);
+  } else if (register_num == 4) {
+    Binary::setLower8BitsOf16BitsValue(&tile_sets_[tile_num].stride_x, v);
+  } else if (register_num == 5) {
+    Binary::setHigher8BitsOf16BitsValue(&tile_sets_[tile_num].stride_x, v);
+  } else if (register_num == 6) {
+    Binary::setLower8BitsOf16BitsValue(&tile_sets_[tile_num].stride_y, v);
+  } else if (register_num == 7) {
+    Binary::setHigher8BitsOf16BitsValue(&tile_sets_[tile_num].stride_y, v);
+  } else {
+    LOG(ERROR) << "Unsupported tile reg: " << register_num;
+  }
+}
+
+void Vicky::StoreTileMap(uint32_t addr, uint8_t v) {
+  uint16_t tile_offset = addr - TILE_MAP0;
+  uint8_t tile_num = tile_offset / 0x800;
+  uint32_t map_offset = tile_offset % 0x800;
+  tile_sets_[tile_num].tile_map.mem[map_offset] = v;
+}
+
+void Vicky::StoreSpriteRegister(uint32_t addr, uint8_t v) {
+  uint16_t sprite_offset = addr - SP00_CONTROL_REG;
+  uint16_t sprite_num = sprite_offset / 0x08;
+  uint16_t register_num = sprite_offset % 0x08;
+  Sprite &sprite = sprites_[sprite_num];
+  if (register_num == 0) /* control register */ {
+    uint8_t layer = (v & 0b01110000) >> 4;
+    sprite.layer = layer;
+    sprite.enabled = v & 0x01;
+    sprite.lut = (v & 0b00001110) >> 1;
+    sprite.tile_striding = (v & 0x80);
+  } else if (register_num == 1) {
+    sprite.start_addr = (sprite.start_addr & 0x00ffff00) | v;
+  } else if (register_num == 2) {
+    sprite.start_addr = (sprite.start_addr & 0x00ff00ff) | (v << 8);
+  } else if (register_num == 3) {
+    sprite.start_addr = (sprite.start_addr & 0x0000ffff) | (v << 16);
+  } else if (register_num == 4) {
+    Binary::setLower8BitsOf16BitsValue(&sprite.x, v);
+  } else if (register_num == 5) {
+    Binary::setHigher8BitsOf16BitsValue(&sprite.x, v);
+  } else if (register_num == 6) {
+    Binary::setLower8BitsOf16BitsValue(&sprite.y, v);
+  } else if (register_num == 7) {
+    Binary::setHigher8BitsOf16BitsValue(&sprite.y, v);
+  } else {
+    LOG(ERROR) << "Unsupported sprite reg: " << register_num;
+  }
+}
+
+void Vicky::StoreMouseCursor(uint32_t addr, uint8_t v) {
+  if (addr <= MOUSE_PTR_GRAP0_END)
+    mouse_cursor_0_[addr - MOUSE_PTR_GRAP0_START] = v;
+  else
+    mouse_cursor_1_[addr - MOUSE_PTR_GRAP1_START] = v;
+}
+
+void Vicky::StoreCharacterLut(uint32_t addr, uint8_t v) {
+  if (addr < BG_CHAR_LUT_PTR)
+    memcpy((uint8_t *)fg_colour_mem_ + addr - FG_CHAR_LUT_PTR, &v, 1);
+  else
+    memcpy((uint8_t *)bg_colour_mem_ + addr - BG_CHAR_LUT_PTR, &v, 1);
+}
+
+void Vicky::StoreGammaLut(uint32_t addr, uint8_t v) {
+  if (addr < GAMMA_G_LUT_PTR)
+    gamma_.b[addr & 0xFF] = v;
+  else if (addr < GAMMA_R_LUT_PTR)
+    gamma_.g[addr & 0xFF] = v;
+  else
+    gamma_.r[addr & 0xFF] = v;
+}
+
 void Vicky::RenderLine() {
   //  if (mode_ & Mstr_Ctrl_Disable_Vid)
   //    return;
@@ -9,10 +9,12 @@
 #include <mutex>
 #include <thread>
 
+#include "bus/guest_memory.h"
 #include "cpu.h"
 
 class System;
 class InterruptController;
+class IoDispatch;
 
 using UniqueTexturePtr =
     std::unique_ptr<SDL_Texture, std::function<void(SDL_Texture *)>>;
@@ -44,7 +46,11 @@ class Vicky {
   // Render a single scan line and advance to the next.
   void RenderLine();
 
-  // SystemBusDevice implementation
+  // Claims all of bank AF, with the register arrays going straight to their
+  // own handlers and everything else to StoreByte().
+  void ClaimIo(IoDispatch *io);
+
+  // Single registers. |addr| is the offset in bank AF.
   void StoreByte(uint32_t addr, uint8_t v);
   uint8_t ReadByte(uint32_t addr);
 
@@ -66,6 +72,14 @@ class Vicky {
 
   uint32_t ApplyGamma(uint32_t colour_val);
 
+  // Register arrays claimed by ClaimIo().
+  void StoreTileSetRegister(uint32_t addr, uint8_t v);
+  void StoreTileMap(uint32_t addr, uint8_t v);
+  void StoreSpriteRegister(uint32_t addr, uint8_t v);
+  void StoreMouseCursor(uint32_t addr, uint8_t v);
+  void StoreCharacterLut(uint32_t addr, uint8_t v);
+  void StoreGammaLut(uint32_t addr, uint8_t v);
+
   System *sys_;
   InterruptController *int_controller_;
 
@@ -115,7 +129,8 @@ class Vicky {
   bool bitmap_enabled_ = false;
   uint8_t bitmap_lut_ = 0;
   uint32_t bitmap_addr_offset_ = 0;
-  uint8_t video_ram_[0x400000];
+  GuestMemory video_memory_{0x400000};
+  uint8_t *const video_ram_ = video_memory_.data();
 
   struct TileSet {
     bool enabled = false;
@@ -149,7 +164,9 @@ class Vicky {
   uint16_t raster_y_ = 0;
 
   // Our physical frame buffer
-  uint32_t frame_buffer_[kRasterSize];
+  GuestMemory frame_memory_{kRasterSize * sizeof(uint32_t)};
+  uint32_t *const frame_buffer_ =
+      reinterpret_cast<uint32_t *>(frame_memory_.data());
 
   // Which is uploaded to this texture each frame.
   UniqueTexturePtr vicky_texture_;
@@ -23,54 +23,13 @@
 #include "cpu/opcode.h"
 #include "cpu/system_bus_device.h"
 
-bool Cpu65816::opCodeAddressingCrossesPageBoundary(OpCode &opCode) const {
-  switch (opCode.addressing_mode()) {
-  case AddressingMode::AbsoluteIndexedWithX: {
-    Address initialAddress(
-        db_, system_bus_.ReadWord(program_address_.WithOffset(1)));
-    // TODO: figure out when to wrap around and when not to, it should not
-    // matter in this case but it matters when fetching data
-    Address finalAddress =
-        Address::SumOffsetToAddress(initialAddress, indexWithXRegister());
-    return Address::OffsetsAreOnDifferentPages(initialAddress.offset_,
-                                               finalAddress.offset_);
-  }
-  case AddressingMode::AbsoluteIndexedWithY: {
-    Address initialAddress(
-        db_, system_bus_.ReadWord(program_address_.WithOffset(1)));
-    // TODO: figure out when to wrap around and when not to, it should not
-    // matter in this case but it matters when fetching data
-    Address finalAddress =
-        Address::SumOffsetToAddress(initialAddress, indexWithYRegister());
-    return Address::OffsetsAreOnDifferentPages(initialAddress.offset_,
-                                               finalAddress.offset_);
-  }
-  case AddressingMode::DirectPageIndirectIndexedWithY: {
-    uint16_t firstStageOffset =
-        dp_ + system_bus_.ReadByte(program_address_.WithOffset(1));
-    Address firstStageAddress(0x00, firstStageOffset);
-    uint16_t secondStageOffset = system_bus_.ReadWord(firstStageAddress);
-    Address thirdStageAddress(db_, secondStageOffset);
-    // TODO: figure out when to wrap around and when not to, it should not
-    // matter in this case but it matters when fetching data
-    Address finalAddress =
-        Address::SumOffsetToAddress(thirdStageAddress, indexWithYRegister());
-    return Address::OffsetsAreOnDifferentPages(thirdStageAddress.offset_,
-                                               finalAddress.offset_);
-  }
-  default: {
-    LOG(ERROR) << "Unsupported opCodeAddressingCrossesPageBoundary for "
-                  "opCode: "
-               << opCode.code();
-  }
-  }
-
-  return false;
-}
-
-Address Cpu65816::getAddressOfOpCodeData(OpCode &opCode) const {
+template <int kMode>
+Cpu65816::EffectiveAddress
+Cpu65816::resolveEffectiveAddress(OpCode &opCode) const {
   uint8_t dataAddressBank = 0x0;
   uint16_t dataAddressOffset = 0x0000;
+  // Only worked out for the indexed modes whose timing depends on it.
+  bool crossesPage = false;
 
   switch (opCode.addressing_mode()) {
   case AddressingMode::Interrupt:
@@ -79,7 +38,7 @@ Address Cpu65816::getAddressOfOpCodeData(OpCode &opCode) const {
   case AddressingMode::StackImplied:
     // Not really used, doesn't make any sense since these opcodes do not have
     // operands
-    return program_address_;
+    return {program_address_, false};
   case AddressingMode::Immediate:
   case AddressingMode::BlockMove:
     // Blockmove OpCodes have two bytes following them directly
@@ -98,137 +57,124 @@ Address Cpu65816::getAddressOfOpCodeData(OpCode &opCode) const {
     break;
   case AddressingMode::Absolute:
     dataAddressBank = db_;
-    dataAddressOffset = system_bus_.ReadWord(program_address_.WithOffset(1));
+    dataAddressOffset = operand16();
     break;
   case AddressingMode::AbsoluteLong:
-    system_bus_.ReadAddressAt(program_address_ + 1)
-        .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
+    operand24().GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
     break;
   case AddressingMode::AbsoluteIndirect: {
     dataAddressBank = program_address_.bank_;
-    Address addressOfOffset(
-        0x00, system_bus_.ReadWord(program_address_.WithOffset(1)));
+    Address addressOfOffset(0x00, operand16());
     dataAddressOffset = system_bus_.ReadWord(addressOfOffset);
   } break;
   case AddressingMode::AbsoluteIndirectLong: {
-    Address addressOfEffectiveAddress(
-        0x00, system_bus_.ReadWord(program_address_.WithOffset(1)));
+    Address addressOfEffectiveAddress(0x00, operand16());
     system_bus_.ReadAddressAt(addressOfEffectiveAddress)
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
   } break;
   case AddressingMode::AbsoluteIndexedIndirectWithX: {
-    Address firstStageAddress(
-        program_address_.bank_,
-        system_bus_.ReadWord(program_address_.WithOffset(1)));
+    Address firstStageAddress(program_address_.bank_, operand16());
     Address secondStageAddress =
-        firstStageAddress.WithOffsetNoWrapAround(indexWithXRegister());
+        firstStageAddress.WithOffsetNoWrapAround(indexWithXRegister<kMode>());
     dataAddressBank = program_address_.bank_;
     dataAddressOffset = system_bus_.ReadWord(secondStageAddress);
   } break;
   case AddressingMode::AbsoluteIndexedWithX: {
-    Address firstStageAddress(
-        db_, system_bus_.ReadWord(program_address_.WithOffset(1)));
+    Address firstStageAddress(db_, operand16());
     Address::SumOffsetToAddressNoWrapAround(firstStageAddress,
-                                            indexWithXRegister())
+                                            indexWithXRegister<kMode>())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
-    ;
+    crossesPage = Address::OffsetsAreOnDifferentPages(
+        firstStageAddress.offset_, dataAddressOffset);
   } break;
   case AddressingMode::AbsoluteLongIndexedWithX: {
-    Address firstStageAddress =
-        system_bus_.ReadAddressAt(program_address_.WithOffset(1));
+    Address firstStageAddress = operand24();
     Address::SumOffsetToAddressNoWrapAround(firstStageAddress,
-                                            indexWithXRegister())
+                                            indexWithXRegister<kMode>())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
-    ;
   } break;
   case AddressingMode::AbsoluteIndexedWithY: {
-    Address firstStageAddress(
-        db_, system_bus_.ReadWord(program_address_.WithOffset(1)));
+    Address firstStageAddress(db_, operand16());
     Address::SumOffsetToAddressNoWrapAround(firstStageAddress,
-                                            indexWithYRegister())
+                                            indexWithYRegister<kMode>())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
-    ;
+    crossesPage = Address::OffsetsAreOnDifferentPages(
+        firstStageAddress.offset_, dataAddressOffset);
   } break;
   case AddressingMode::DirectPage: {
     // Direct page/Zero page always refers to bank zero
     dataAddressBank = 0x00;
-    if (cpu_status_.emulation_flag) {
+    if (kMode == kModeEmulation) {
       // 6502 uses zero page
-      dataAddressOffset = system_bus_.ReadByte(program_address_.WithOffset(1));
+      dataAddressOffset = operand8();
     } else {
       // 65816 uses direct page
-      dataAddressOffset =
-          dp_ + system_bus_.ReadByte(program_address_.WithOffset(1));
+      dataAddressOffset = dp_ + operand8();
     }
   } break;
   case AddressingMode::DirectPageIndexedWithX: {
     dataAddressBank = 0x00;
-    dataAddressOffset = dp_ + indexWithXRegister() +
-                        system_bus_.ReadByte(program_address_.WithOffset(1));
+    dataAddressOffset = dp_ + indexWithXRegister<kMode>() + operand8();
   } break;
   case AddressingMode::DirectPageIndexedWithY: {
     dataAddressBank = 0x00;
-    dataAddressOffset = dp_ + indexWithYRegister() +
-                        system_bus_.ReadByte(program_address_.WithOffset(1));
+    dataAddressOffset = dp_ + indexWithYRegister<kMode>() + operand8();
   } break;
   case AddressingMode::DirectPageIndirect: {
-    Address firstStageAddress(
-        0x00, dp_ + system_bus_.ReadByte(program_address_.WithOffset(1)));
     dataAddressBank = db_;
-    dataAddressOffset = system_bus_.ReadWord(firstStageAddress);
+    dataAddressOffset = directPagePointer16(dp_ + operand8());
   } break;
   case AddressingMode::DirectPageIndirectLong: {
-    Address firstStageAddress(
-        0x00, dp_ + system_bus_.ReadByte(program_address_.WithOffset(1)));
-    system_bus_.ReadAddressAt(firstStageAddress)
+    directPagePointer24(dp_ + operand8())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
-    ;
   } break;
   case AddressingMode::DirectPageIndexedIndirectWithX: {
-    Address firstStageAddress(
-        0x00, dp_ + system_bus_.ReadByte(program_address_.WithOffset(1)) +
-                  indexWithXRegister());
     dataAddressBank = db_;
-    dataAddressOffset = system_bus_.ReadWord(firstStageAddress);
+    dataAddressOffset =
+        directPagePointer16(dp_ + operand8() + indexWithXRegister<kMode>());
   } break;
   case AddressingMode::DirectPageIndirectIndexedWithY: {
-    Address firstStageAddress(
-        0x00, dp_ + system_bus_.ReadByte(program_address_.WithOffset(1)));
-    uint16_t secondStageOffset = system_bus_.ReadWord(firstStageAddress);
+    uint16_t secondStageOffset = directPagePointer16(dp_ + operand8());
     Address thirdStageAddress(db_, secondStageOffset);
     Address::SumOffsetToAddressNoWrapAround(thirdStageAddress,
-                                            indexWithYRegister())
+                                            indexWithYRegister<kMode>())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
+    crossesPage = Address::OffsetsAreOnDifferentPages(secondStageOffset,
+                                                      dataAddressOffset);
   } break;
   case AddressingMode::DirectPageIndirectLongIndexedWithY: {
-    Address firstStageAddress(
-        0x00, dp_ + system_bus_.ReadByte(program_address_.WithOffset(1)));
-    Address secondStageAddress = system_bus_.ReadAddressAt(firstStageAddress);
+    Address secondStageAddress = directPagePointer24(dp_ + operand8());
     Address::SumOffsetToAddressNoWrapAround(secondStageAddress,
-                                            indexWithYRegister())
+                                            indexWithYRegister<kMode>())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
   } break;
   case AddressingMode::StackRelative: {
     dataAddressBank = 0x00;
-    dataAddressOffset = stack_.stack_pointer() +
-                        system_bus_.ReadByte(program_address_.WithOffset(1));
+    dataAddressOffset = stack_.stack_pointer() + operand8();
   } break;
   case AddressingMode::StackDirectPageIndirect: {
     dataAddressBank = 0x00;
-    dataAddressOffset =
-        dp_ + system_bus_.ReadByte(program_address_.WithOffset(1));
+    dataAddressOffset = dp_ + operand8();
   } break;
   case AddressingMode::StackRelativeIndirectIndexedWithY: {
-    Address firstStageAddress(
-        0x00, stack_.stack_pointer() +
-                  system_bus_.ReadByte(program_address_.WithOffset(1)));
-    uint16_t secondStageOffset = system_bus_.ReadWord(firstStageAddress);
+    uint16_t secondStageOffset =
+        directPagePointer16(stack_.stack_pointer() + operand8());
     Address thirdStageAddress(db_, secondStageOffset);
     Address::SumOffsetToAddressNoWrapAround(thirdStageAddress,
-                                            indexWithYRegister())
+                                            indexWithYRegister<kMode>())
         .GetBankAndOffset(&dataAddressBank, &dataAddressOffset);
   } break;
   }
 
-  return Address(dataAddressBank, dataAddressOffset);
+  return {Address(dataAddressBank, dataAddressOffset), crossesPage};
 }
+
+#define INSTANTIATE_ADDRESSING(mode)                                           \
+  template Cpu65816::EffectiveAddress                                          \
+  Cpu65816::resolveEffectiveAddress<mode>(OpCode &) const
+
+INSTANTIATE_ADDRESSING(kModeNativeM16X16);
+INSTANTIATE_ADDRESSING(kModeNativeM16X8);
+INSTANTIATE_ADDRESSING(kModeNativeM8X16);
+INSTANTIATE_ADDRESSING(kModeNativeM8X8);
+INSTANTIATE_ADDRESSING(kModeEmulation);
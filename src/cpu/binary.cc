@@ -97,8 +97,8 @@ uint16_t convert16BitToBcd(uint16_t val) {
   return result;
 }
 
-bool bcdSum8Bit(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
-                bool carry) {
+bool bcdSum8BitByDigits(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
+                        bool carry) {
   uint8_t shift = 0;
   *result = 0;
 
@@ -121,8 +121,8 @@ bool bcdSum8Bit(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
   return carry;
 }
 
-bool bcdSubtract8Bit(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
-                     bool borrow) {
+bool bcdSubtract8BitByDigits(uint8_t bcdFirst, uint8_t bcdSecond,
+                             uint8_t *result, bool borrow) {
   uint8_t shift = 0;
   *result = 0;
 
@@ -145,38 +145,88 @@ bool bcdSubtract8Bit(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
   return borrow;
 }
 
+namespace {
+
+/**
+ * Every 8 bit BCD sum and difference, worked out digit by digit once so that
+ * decimal mode ADC and SBC are a single lookup. Entries hold the result in
+ * the low byte and the carry (or borrow) out in bit 8, and are indexed by
+ * carry (or borrow) in, first operand and second operand.
+ */
+struct BcdTables {
+  static constexpr uint16_t kCarryOut = 0x100;
+
+  BcdTables() {
+    for (uint32_t index = 0; index < kEntries; index++) {
+      const bool carry = index >> 16;
+      const auto first = static_cast<uint8_t>(index >> 8);
+      const auto second = static_cast<uint8_t>(index);
+      uint8_t result;
+      sum[index] = bcdSum8BitByDigits(first, second, &result, carry)
+                       ? result | kCarryOut
+                       : result;
+      difference[index] =
+          bcdSubtract8BitByDigits(first, second, &result, carry)
+              ? result | kCarryOut
+              : result;
+    }
+  }
+
+  static uint32_t indexOf(uint8_t first, uint8_t second, bool carry) {
+    return (carry ? 0x10000 : 0) | first << 8 | second;
+  }
+
+  static constexpr uint32_t kEntries = 2 * 0x10000;
+  uint16_t sum[kEntries];
+  uint16_t difference[kEntries];
+};
+
+// Built on first use rather than at static initialization, so that the
+// tables are ready whichever translation unit gets to them first.
+const BcdTables &bcdTables() {
+  static const BcdTables tables;
+  return tables;
+}
+
+} // namespace
+
+bool bcdSum8Bit(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
+                bool carry) {
+  const uint16_t entry =
+      bcdTables().sum[BcdTables::indexOf(bcdFirst, bcdSecond, carry)];
+  *result = static_cast<uint8_t>(entry);
+  return entry & BcdTables::kCarryOut;
+}
+
+bool bcdSubtract8Bit(uint8_t bcdFirst, uint8_t bcdSecond, uint8_t *result,
+                     bool borrow) {
+  const uint16_t entry =
+      bcdTables().difference[BcdTables::indexOf(bcdFirst, bcdSecond, borrow)];
+  *result = static_cast<uint8_t>(entry);
+  return entry & BcdTables::kCarryOut;
+}
+
 bool bcdSum16Bit(uint16_t bcdFirst, uint16_t bcdSecond, uint16_t *result,
                  bool carry) {
-  *result = 0;
-  uint8_t shift = 0;
-  while (shift < 16) {
-    auto digitOfFirst = static_cast<uint8_t>(bcdFirst & 0xFF);
-    auto digitOfSecond = static_cast<uint8_t>(bcdSecond & 0xFF);
-    uint8_t partialresult = 0;
-    carry = bcdSum8Bit(digitOfFirst, digitOfSecond, &partialresult, carry);
-    *result |= partialresult << shift;
-    shift += 8;
-    bcdFirst >>= shift;
-    bcdSecond >>= shift;
-  }
+  uint8_t lower;
+  uint8_t higher;
+  carry = bcdSum8Bit(lower8BitsOf(bcdFirst), lower8BitsOf(bcdSecond), &lower,
+                     carry);
+  carry = bcdSum8Bit(higher8BitsOf(bcdFirst), higher8BitsOf(bcdSecond),
+                     &higher, carry);
+  *result = higher << 8 | lower;
   return carry;
 }
 
 bool bcdSubtract16Bit(uint16_t bcdFirst, uint16_t bcdSecond, uint16_t *result,
                       bool borrow) {
-  *result = 0;
-  uint8_t shift = 0;
-  while (shift < 16) {
-    auto digitOfFirst = static_cast<uint8_t>(bcdFirst & 0xFF);
-    auto digitOfSecond = static_cast<uint8_t>(bcdSecond & 0xFF);
-    uint8_t partialresult = 0;
-    borrow =
-        bcdSubtract8Bit(digitOfFirst, digitOfSecond, &partialresult, borrow);
-    *result |= partialresult << shift;
-    shift += 8;
-    bcdFirst >>= shift;
-    bcdSecond >>= shift;
-  }
+  uint8_t lower;
+  uint8_t higher;
+  borrow = bcdSubtract8Bit(lower8BitsOf(bcdFirst), lower8BitsOf(bcdSecond),
+                           &lower, borrow);
+  borrow = bcdSubtract8Bit(higher8BitsOf(bcdFirst), higher8BitsOf(bcdSecond),
+                           &higher, borrow);
+  *result = higher << 8 | lower;
   return borrow;
 }
 
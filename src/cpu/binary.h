@@ -42,5 +42,9 @@ bool bcdSum8Bit(uint8_t, uint8_t, uint8_t*, bool);
 bool bcdSum16Bit(uint16_t, uint16_t, uint16_t*, bool);
 bool bcdSubtract8Bit(uint8_t, uint8_t, uint8_t*, bool);
 bool bcdSubtract16Bit(uint16_t, uint16_t, uint16_t*, bool);
+
+// The digit by digit arithmetic the 8 bit lookup tables are built from.
+bool bcdSum8BitByDigits(uint8_t, uint8_t, uint8_t*, bool);
+bool bcdSubtract8BitByDigits(uint8_t, uint8_t, uint8_t*, bool);
 }  // namespace Binary
 
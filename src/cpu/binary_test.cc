@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "cpu/binary.h"
+
+// The lookup tables have to agree with the arithmetic they were built from,
+// for every pair of operands, valid BCD or not, with and without carry.
+TEST(BinaryTest, BcdTablesMatchDigitArithmetic) {
+  for (uint32_t index = 0; index < 0x20000; index++) {
+    const bool carry = index >> 16;
+    const auto first = static_cast<uint8_t>(index >> 8);
+    const auto second = static_cast<uint8_t>(index);
+    uint8_t expected, actual;
+
+    const bool expected_carry =
+        Binary::bcdSum8BitByDigits(first, second, &expected, carry);
+    ASSERT_EQ(Binary::bcdSum8Bit(first, second, &actual, carry),
+              expected_carry)
+        << std::hex << index;
+    ASSERT_EQ(actual, expected) << std::hex << index;
+
+    const bool expected_borrow =
+        Binary::bcdSubtract8BitByDigits(first, second, &expected, carry);
+    ASSERT_EQ(Binary::bcdSubtract8Bit(first, second, &actual, carry),
+              expected_borrow)
+        << std::hex << index;
+    ASSERT_EQ(actual, expected) << std::hex << index;
+  }
+}
+
+TEST(BinaryTest, BcdDecimalArithmetic) {
+  for (int first = 0; first < 100; first++) {
+    for (int second = 0; second < 100; second++) {
+      const uint8_t a = Binary::convert8BitToBcd(first);
+      const uint8_t b = Binary::convert8BitToBcd(second);
+      uint8_t result;
+      EXPECT_EQ(Binary::bcdSum8Bit(a, b, &result, true),
+                first + second + 1 > 99);
+      EXPECT_EQ(result, Binary::convert8BitToBcd((first + second + 1) % 100));
+      EXPECT_EQ(Binary::bcdSubtract8Bit(a, b, &result, false), first < second);
+      EXPECT_EQ(result, Binary::convert8BitToBcd((first - second + 100) % 100));
+    }
+  }
+  uint16_t result;
+  EXPECT_TRUE(Binary::bcdSum16Bit(0x9999, 0x0001, &result, false));
+  EXPECT_EQ(result, 0x0000);
+  EXPECT_TRUE(Binary::bcdSubtract16Bit(0x0000, 0x0001, &result, false));
+  EXPECT_EQ(result, 0x9999);
+}
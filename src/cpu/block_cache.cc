@@ -0,0 +1,286 @@
+#include "cpu/block_cache.h"
+
+uint32_t InstructionLength(const OpCode &op_code, bool wide_accumulator,
+                           bool wide_index) {
+  switch (op_code.addressing_mode()) {
+  case AddressingMode::Accumulator:
+  case AddressingMode::Implied:
+  case AddressingMode::StackImplied:
+    return 1;
+  case AddressingMode::Immediate:
+    switch (op_code.code()) {
+    case 0xC2: // REP
+    case 0xE2: // SEP
+      return 2;
+    case 0xA0: // LDY
+    case 0xA2: // LDX
+    case 0xC0: // CPY
+    case 0xE0: // CPX
+      return wide_index ? 3 : 2;
+    default:
+      return wide_accumulator ? 3 : 2;
+    }
+  case AddressingMode::Interrupt:
+  case AddressingMode::DirectPage:
+  case AddressingMode::DirectPageIndexedWithX:
+  case AddressingMode::DirectPageIndexedWithY:
+  case AddressingMode::DirectPageIndirect:
+  case AddressingMode::DirectPageIndirectLong:
+  case AddressingMode::DirectPageIndexedIndirectWithX:
+  case AddressingMode::DirectPageIndirectIndexedWithY:
+  case AddressingMode::DirectPageIndirectLongIndexedWithY:
+  case AddressingMode::StackRelative:
+  case AddressingMode::StackDirectPageIndirect:
+  case AddressingMode::StackRelativeIndirectIndexedWithY:
+  case AddressingMode::ProgramCounterRelative:
+    return 2;
+  case AddressingMode::BlockMove:
+  case AddressingMode::Absolute:
+  case AddressingMode::AbsoluteIndirect:
+  case AddressingMode::AbsoluteIndirectLong:
+  case AddressingMode::AbsoluteIndexedIndirectWithX:
+  case AddressingMode::AbsoluteIndexedWithX:
+  case AddressingMode::AbsoluteIndexedWithY:
+  case AddressingMode::StackAbsolute:
+  case AddressingMode::StackProgramCounterRelativeLong:
+  case AddressingMode::ProgramCounterRelativeLong:
+    return 3;
+  case AddressingMode::AbsoluteLong:
+  case AddressingMode::AbsoluteLongIndexedWithX:
+    return 4;
+  }
+  return 1;
+}
+
+namespace {
+
+// Instructions after which decoding stops: unconditional control transfers,
+// register width changes and anything that may not advance the PC normally.
+bool EndsBlock(uint8_t code) {
+  switch (code) {
+  case 0x00: // BRK
+  case 0x02: // COP
+  case 0x20: // JSR
+  case 0x22: // JSL
+  case 0x28: // PLP
+  case 0x40: // RTI
+  case 0x42: // WDM
+  case 0x44: // MVP
+  case 0x4C: // JMP
+  case 0x54: // MVN
+  case 0x5C: // JML
+  case 0x60: // RTS
+  case 0x6B: // RTL
+  case 0x6C: // JMP (a)
+  case 0x7C: // JMP (a,x)
+  case 0x80: // BRA
+  case 0x82: // BRL
+  case 0xC2: // REP
+  case 0xCB: // WAI
+  case 0xDB: // STP
+  case 0xDC: // JML [a]
+  case 0xE2: // SEP
+  case 0xFB: // XCE
+  case 0xFC: // JSR (a,x)
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool IsBranch(uint8_t code) {
+  switch (code) {
+  case 0x10: // BPL
+  case 0x30: // BMI
+  case 0x50: // BVC
+  case 0x70: // BVS
+  case 0x80: // BRA
+  case 0x90: // BCC
+  case 0xB0: // BCS
+  case 0xD0: // BNE
+  case 0xF0: // BEQ
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Instructions that read memory at a fixed address, or nothing at all, and
+// only change registers and flags.
+bool IsPollingRead(uint8_t code) {
+  switch (code) {
+  case 0xA9: case 0xAD: case 0xAF: case 0xA5: // LDA
+  case 0xA2: case 0xAE: case 0xA6:            // LDX
+  case 0xA0: case 0xAC: case 0xA4:            // LDY
+  case 0x89: case 0x2C: case 0x24:            // BIT
+  case 0xC9: case 0xCD: case 0xCF: case 0xC5: // CMP
+  case 0xE0: case 0xEC: case 0xE4:            // CPX
+  case 0xC0: case 0xCC: case 0xC4:            // CPY
+  case 0x29: case 0x2D: case 0x2F: case 0x25: // AND
+  case 0x09: case 0x0D: case 0x0F: case 0x05: // ORA
+  case 0xEA:                                  // NOP
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool IsCount(uint8_t code) {
+  return code == 0xCA || code == 0x88 || code == 0xE8 || code == 0xC8;
+}
+
+bool IsCompareImmediate(uint8_t code) {
+  return code == 0xC9 || code == 0xE0 || code == 0xC0;
+}
+
+bool IsLoadA(uint8_t code) {
+  switch (code) {
+  case 0xA1: case 0xA3: case 0xA5: case 0xA7: case 0xA9: case 0xAD:
+  case 0xAF: case 0xB1: case 0xB2: case 0xB3: case 0xB5: case 0xB7:
+  case 0xB9: case 0xBD: case 0xBF:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool IsStoreA(uint8_t code) {
+  switch (code) {
+  case 0x81: case 0x83: case 0x85: case 0x87: case 0x8D: case 0x8F:
+  case 0x91: case 0x92: case 0x93: case 0x95: case 0x97: case 0x99:
+  case 0x9D: case 0x9F:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool IsModify(uint8_t code) {
+  switch (code) {
+  case 0xE6: case 0xEE: case 0xF6: case 0xFE: // INC
+  case 0xC6: case 0xCE: case 0xD6: case 0xDE: // DEC
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool IsZeroBranch(uint8_t code) { return code == 0xD0 || code == 0xF0; }
+
+// Returns true if |first| followed by |second| makes a superinstruction.
+bool FindSuperinstruction(uint8_t first, uint8_t second,
+                          Superinstruction *superinstruction) {
+  if (IsCount(first) &&
+      (IsZeroBranch(second) || second == 0x10 || second == 0x30)) {
+    *superinstruction = Superinstruction::kCountBranch;
+  } else if (IsCompareImmediate(first) &&
+             (IsZeroBranch(second) || second == 0x90 || second == 0xB0)) {
+    *superinstruction = Superinstruction::kCompareBranch;
+  } else if (IsLoadA(first) && IsStoreA(second)) {
+    *superinstruction = Superinstruction::kLoadStore;
+  } else if (IsModify(first) && IsZeroBranch(second)) {
+    *superinstruction = Superinstruction::kModifyBranch;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int IdleLoopSize(const DecodedBlock &block) {
+  for (int i = 0; i < block.size; i++) {
+    const MicroOp &op = block.ops[i];
+    if (IsBranch(op.op_code->code())) {
+      const uint32_t target =
+          (op.address & 0xFF0000) |
+          ((op.address + 2 + (int8_t)op.operand) & 0xFFFF);
+      return target == block.address ? i + 1 : 0;
+    }
+    if (!IsPollingRead(op.op_code->code()))
+      return 0;
+  }
+  return 0;
+}
+
+} // namespace
+
+BlockCache::BlockCache(SystemBus *system_bus)
+    : system_bus_(system_bus), blocks_(new DecodedBlock[kNumBlocks]) {}
+
+DecodedBlock *BlockCache::Find(uint32_t address, OpCode *op_code_table,
+                               bool wide_accumulator, bool wide_index) {
+  DecodedBlock *block =
+      &blocks_[(address ^ (address >> 12)) & (kNumBlocks - 1)];
+  if (block->address == address && block->op_code_table == op_code_table &&
+      IsValid(*block))
+    return block;
+  if (!Decode(block, address, op_code_table, wide_accumulator, wide_index))
+    return nullptr;
+  return block;
+}
+
+void BlockCache::ForgetCompiledCode() {
+  for (uint32_t i = 0; i < kNumBlocks; i++) {
+    blocks_[i].compiled = nullptr;
+    blocks_[i].compile_failed = false;
+    blocks_[i].executions = 0;
+  }
+}
+
+bool BlockCache::Decode(DecodedBlock *block, uint32_t address,
+                        OpCode *op_code_table, bool wide_accumulator,
+                        bool wide_index) {
+  // Blocks never leave their code page, so a single generation covers them.
+  const uint32_t page_end =
+      (address | ((1 << SystemBus::kCodePageBits) - 1)) + 1;
+  const uint8_t *mem =
+      system_bus_->DirectPointer(address, page_end - address);
+  block->address = ~0u;
+  if (!mem)
+    return false;
+
+  int size = 0;
+  uint32_t pc = address;
+  while (size < DecodedBlock::kMaxOps) {
+    const uint8_t *bytes = mem + (pc - address);
+    OpCode &op_code = op_code_table[bytes[0]];
+    const uint32_t length =
+        InstructionLength(op_code, wide_accumulator, wide_index);
+    if (pc + length > page_end)
+      break;
+
+    MicroOp &op = block->ops[size++];
+    op.op_code = &op_code;
+    op.address = pc;
+    op.operand = 0;
+    for (uint32_t i = 1; i < length; i++)
+      op.operand |= bytes[i] << (8 * (i - 1));
+
+    pc += length;
+    if (EndsBlock(op_code.code()))
+      break;
+  }
+  if (size == 0)
+    return false;
+  for (int i = 0; i < size; i++) {
+    MicroOp &op = block->ops[i];
+    op.dispatch = op.op_code->code();
+    Superinstruction superinstruction;
+    if (i + 1 < size &&
+        FindSuperinstruction(op.op_code->code(),
+                             block->ops[i + 1].op_code->code(),
+                             &superinstruction))
+      op.dispatch = MicroOp::kSuperinstructionDispatch +
+                    static_cast<uint16_t>(superinstruction);
+  }
+
+  block->op_code_table = op_code_table;
+  block->generation = system_bus_->WatchCodePage(address);
+  block->address = address;
+  block->end_address = pc;
+  block->size = size;
+  block->idle_loop_size = IdleLoopSize(*block);
+  block->executions = 0;
+  block->compile_failed = false;
+  block->compiled = nullptr;
+  return true;
+}
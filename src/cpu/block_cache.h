@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "cpu/opcode.h"
+#include "cpu/system_bus.h"
+
+class Cpu65816;
+
+// Length in bytes of an instruction, including the opcode.
+uint32_t InstructionLength(const OpCode &op_code, bool wide_accumulator,
+                           bool wide_index);
+
+// Common instruction pairs that Run() executes with a single dispatch,
+// picked out of the opcode stream when a block is decoded.
+enum class Superinstruction : uint8_t {
+  // DEX, DEY, INX or INY followed by BNE, BEQ, BPL or BMI.
+  kCountBranch,
+  // CMP, CPX or CPY immediate followed by BNE, BEQ, BCC or BCS.
+  kCompareBranch,
+  // LDA followed by STA, e.g. in copy loops.
+  kLoadStore,
+  // INC or DEC of memory followed by BNE or BEQ.
+  kModifyBranch,
+};
+constexpr int kNumSuperinstructions = 4;
+
+// An instruction decoded ahead of time, with its operand bytes already
+// fetched so executing it doesn't have to go back to the bus for them.
+struct MicroOp {
+  // Dispatch values from here on are the first instruction of a
+  // Superinstruction, the second one being the next MicroOp.
+  static constexpr uint16_t kSuperinstructionDispatch = 0x100;
+
+  OpCode *op_code;
+  // Up to three operand bytes following the opcode, little endian.
+  uint32_t operand;
+  // 24-bit address of the opcode.
+  uint32_t address;
+  // Entry of Run()'s dispatch table: the opcode, or
+  // kSuperinstructionDispatch plus a Superinstruction.
+  uint16_t dispatch;
+};
+
+// A straight run of instructions decoded from a single code page of RAM with
+// one opcode table, i.e. for one register width mode.
+struct DecodedBlock {
+  static constexpr int kMaxOps = 16;
+
+  OpCode *op_code_table = nullptr;
+  // SystemBus::code_page_generation() of the page at decode time.
+  uint32_t generation = 0;
+  uint32_t address = ~0u;
+  // Address just past the last instruction.
+  uint32_t end_address = 0;
+  int size = 0;
+  MicroOp ops[kMaxOps];
+  // Number of instructions in the polling loop the block starts with: reads
+  // that only change registers and flags, then a branch back to the start.
+  // Zero if there is none.
+  int idle_loop_size = 0;
+
+  // Dynarec state, reset whenever the block is decoded again.
+  uint32_t executions = 0;
+  bool compile_failed = false;
+  void (*compiled)(Cpu65816 *) = nullptr;
+  // Upper bound on the cycles taken by every compiled instruction but the
+  // last one, so Run() can tell whether the block fits in its budget.
+  uint32_t max_cycles = 0;
+};
+
+// Direct mapped cache of DecodedBlocks keyed by PBR:PC and opcode table.
+// Blocks are dropped when the bus reports a write to their code page, so
+// self-modifying code keeps working.
+class BlockCache {
+public:
+  explicit BlockCache(SystemBus *system_bus);
+
+  // Returns the block starting at 'address', decoding it if it is missing or
+  // stale, or nullptr if the code there does not live in RAM.
+  DecodedBlock *Find(uint32_t address, OpCode *op_code_table,
+                     bool wide_accumulator, bool wide_index);
+
+  // Drops every block's compiled code, for when the code buffer is recycled.
+  void ForgetCompiledCode();
+
+  bool IsValid(const DecodedBlock &block) const {
+    return system_bus_->code_page_generation(block.address) ==
+           block.generation;
+  }
+
+private:
+  static constexpr uint32_t kNumBlocks = 4096;
+
+  bool Decode(DecodedBlock *block, uint32_t address, OpCode *op_code_table,
+              bool wide_accumulator, bool wide_index);
+
+  SystemBus *system_bus_;
+  std::unique_ptr<DecodedBlock[]> blocks_;
+};
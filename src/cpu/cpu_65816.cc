@@ -21,13 +21,17 @@
 #include "cpu_65816.h"
 
 #include <cmath>
+#include <cstring>
 #include <iomanip>
 
 Cpu65816::Cpu65816(SystemBus &systemBus,
                    EmulationModeInterrupts *emulationInterrupts,
                    NativeModeInterrupts *nativeInterrupts)
     : system_bus_(systemBus), emulation_mode_interrupts_(emulationInterrupts),
-      native_mode_interrupts_(nativeInterrupts), stack_(&system_bus_) {}
+      native_mode_interrupts_(nativeInterrupts), stack_(&system_bus_),
+      block_cache_(&system_bus_) {
+  updateOpCodeTable();
+}
 
 Address Cpu65816::program_address() const { return program_address_; }
 
@@ -49,6 +53,7 @@ void Cpu65816::reset() {
   stack_ = Stack(&system_bus_);
   program_address_ = Address(0, system_bus_.ReadWord(Address(
                                     0x00, emulation_mode_interrupts_->reset)));
+  updateOpCodeTable();
 }
 
 void Cpu65816::SetRESPin(bool value) {
@@ -56,45 +61,43 @@ void Cpu65816::SetRESPin(bool value) {
     reset();
   }
   pins_.RES = value;
+  if (value)
+    events_pending_.store(true, std::memory_order_relaxed);
 }
 
-void Cpu65816::SetRDYPin(bool value) { pins_.RDY = value; }
+void Cpu65816::SetRDYPin(bool value) {
+  pins_.RDY = value;
+  if (!value)
+    events_pending_.store(true, std::memory_order_relaxed);
+}
 
 bool Cpu65816::ExecuteNextInstruction() {
   if (pins_.RES) {
     return false;
   }
-  if ((pins_.IRQ) && (!cpu_status_.interrupt_disable_flag)) {
-    /*
-    The program bank register (PB, the A16-A23 part of the address bus) is
-    pushed onto the hardware stack (65C816/65C802 only when operating in native
-    mode). The most significant byte (MSB) of the program counter (PC) is pushed
-    onto the stack. The least significant byte (LSB) of the program counter is
-    pushed onto the stack. The status register (SR) is pushed onto the stack.
-    The interrupt disable flag is set in the status register.
-    PB is loaded with $00 (65C816/65C802 only when operating in native mode).
-    PC is loaded from the relevant vector (see tables).
-    */
-    if (!cpu_status_.emulation_flag) {
-      stack_.Push8Bit(program_address_.bank_);
-      stack_.Push16Bit(program_address_.offset_);
-      stack_.Push8Bit(cpu_status_.register_value());
-      cpu_status_.interrupt_disable_flag = 1;
-      program_address_ =
-          Address(0x00, system_bus_.ReadWord(Address(0x00, 0xFFEE)));
-    } else {
-      stack_.Push16Bit(program_address_.offset_);
-      stack_.Push8Bit(cpu_status_.register_value());
-      cpu_status_.interrupt_disable_flag = 1;
-      program_address_ =
-          Address(0x00, system_bus_.ReadWord(Address(0x00, 0xFFFE)));
+  if (!pins_.RDY) {
+    if (!pins_.IRQ) {
+      // Inside Run() nothing can raise IRQ before the end of the budget.
+      // Single steps from outside only wait a cycle, so the caller gets to
+      // raise it.
+      if (in_run_)
+        idleUntilEndOfRun();
+      else
+        total_cycles_counter_++;
+      return true;
     }
+    pins_.RDY = true;
+  }
+  if ((pins_.IRQ) && (!cpu_status_.interrupt_disable_flag)) {
+    serviceIRQ();
   }
 
   // Fetch the instruction
   const uint8_t instruction = system_bus_.ReadByte(program_address_);
-  OpCode opCode = OP_CODE_TABLE[instruction];
+  OpCode &opCode = op_code_table_[instruction];
 
+  if (trace_buffer_)
+    traceInstruction(instruction);
   if (trace_log_) {
     LOG(INFO) << program_address_ << " :" << opCode.name() << " ("
               << "0x" << std::setfill('0') << std::setw(2) << std::hex
@@ -105,6 +108,263 @@ bool Cpu65816::ExecuteNextInstruction() {
   return opCode.execute(*this);
 }
 
+void Cpu65816::traceInstruction(uint8_t instruction) {
+  TraceRecord record;
+  record.cycles = total_cycles_counter_;
+  record.program_address = program_address_.AsInt();
+  record.a = a_;
+  record.x = x_;
+  record.y = y_;
+  record.sp = stack_.stack_pointer();
+  record.dp = dp_;
+  record.op_code = instruction;
+  record.db = db_;
+  record.p = cpu_status_.register_value();
+  record.emulation = cpu_status_.emulation_flag;
+  trace_buffer_->Append(record);
+}
+
+void Cpu65816::serviceIRQ() {
+  /*
+  The program bank register (PB, the A16-A23 part of the address bus) is
+  pushed onto the hardware stack (65C816/65C802 only when operating in native
+  mode). The most significant byte (MSB) of the program counter (PC) is pushed
+  onto the stack. The least significant byte (LSB) of the program counter is
+  pushed onto the stack. The status register (SR) is pushed onto the stack.
+  The interrupt disable flag is set in the status register.
+  PB is loaded with $00 (65C816/65C802 only when operating in native mode).
+  PC is loaded from the relevant vector (see tables).
+  */
+  if (!cpu_status_.emulation_flag) {
+    stack_.Push8Bit(program_address_.bank_);
+    stack_.Push16Bit(program_address_.offset_);
+    stack_.Push8Bit(cpu_status_.register_value());
+    cpu_status_.interrupt_disable_flag = 1;
+    program_address_ =
+        Address(0x00, system_bus_.ReadWord(Address(0x00, 0xFFEE)));
+  } else {
+    stack_.Push16Bit(program_address_.offset_);
+    stack_.Push8Bit(cpu_status_.register_value());
+    cpu_status_.interrupt_disable_flag = 1;
+    program_address_ =
+        Address(0x00, system_bus_.ReadWord(Address(0x00, 0xFFFE)));
+  }
+}
+
+bool Cpu65816::serviceEvents() {
+  if (pins_.RES) {
+    return false;
+  }
+  if (!pins_.RDY) {
+    // Waiting for an interrupt, which can only come from outside of Run().
+    if (!pins_.IRQ) {
+      idleUntilEndOfRun();
+      return false;
+    }
+    pins_.RDY = true;
+  }
+  // IRQ is level triggered, keep the event raised while the line is held.
+  events_pending_.store(pins_.IRQ, std::memory_order_relaxed);
+  if ((pins_.IRQ) && (!cpu_status_.interrupt_disable_flag)) {
+    serviceIRQ();
+  }
+  return true;
+}
+
+const MicroOp *Cpu65816::nextMicroOp() {
+  const uint32_t pc =
+      (program_address_.bank_ << 16) | program_address_.offset_;
+  if (block_ && block_pos_ < block_->size &&
+      block_->ops[block_pos_].address == pc &&
+      block_->op_code_table == op_code_table_ && block_cache_.IsValid(*block_))
+    return &block_->ops[block_pos_++];
+
+  enterBlock(block_cache_.Find(pc, op_code_table_, accumulatorIs16BitWide(),
+                              indexIs16BitWide()));
+  if (!block_)
+    return nullptr;
+  return &block_->ops[block_pos_++];
+}
+
+void Cpu65816::enterBlock(DecodedBlock *block) {
+  if (block && block == block_ && block->idle_loop_size != 0 &&
+      block_pos_ == block->idle_loop_size)
+    skipIdleLoop(block);
+  else
+    idle_loop_.block = nullptr;
+  block_ = block;
+  block_pos_ = 0;
+}
+
+void Cpu65816::skipIdleLoop(const DecodedBlock *block) {
+  const uint8_t p = cpu_status_.register_value();
+  if (idle_loop_.block == block && idle_loop_.a == a_ &&
+      idle_loop_.x == x_ && idle_loop_.y == y_ && idle_loop_.p == p &&
+      total_cycles_counter_ < run_end_cycles_) {
+    // Skip whole trips round the loop so the cycle count stays one the
+    // loop could really have reached.
+    const uint64_t trip = total_cycles_counter_ - idle_loop_.cycles;
+    const uint64_t trips =
+        (run_end_cycles_ - total_cycles_counter_ + trip - 1) / trip;
+    total_cycles_counter_ += trips * trip;
+  }
+  idle_loop_.block = block;
+  idle_loop_.cycles = total_cycles_counter_;
+  idle_loop_.a = a_;
+  idle_loop_.x = x_;
+  idle_loop_.y = y_;
+  idle_loop_.p = p;
+}
+
+bool Cpu65816::runCompiledBlock(uint64_t end_cycles) {
+  const uint32_t pc =
+      (program_address_.bank_ << 16) | program_address_.offset_;
+  // Compiled code is only ever entered at the start of a block.
+  if (block_ && block_pos_ > 0 && block_pos_ < block_->size &&
+      block_->ops[block_pos_].address == pc)
+    return false;
+
+  DecodedBlock *block = block_cache_.Find(
+      pc, op_code_table_, accumulatorIs16BitWide(), indexIs16BitWide());
+  enterBlock(block);
+  // Polling loops stay with the interpreter, which can skip them.
+  if (!block || block->idle_loop_size != 0)
+    return false;
+  if (!block->compiled) {
+    if (block->compile_failed || ++block->executions < dynarec_hot_threshold_)
+      return false;
+    dynarec_->Compile(block);
+    if (!block->compiled)
+      return false;
+  }
+  if (total_cycles_counter_ + block->max_cycles >= end_cycles)
+    return false;
+
+  const uint64_t start_cycles = total_cycles_counter_;
+  micro_op_ = nullptr;
+  dynarec_->Execute(block);
+  micro_op_ = nullptr;
+  if (total_cycles_counter_ == start_cycles &&
+      program_address_.AsInt() == pc) {
+    // The first instruction needs the interpreter, e.g. for an I/O access.
+    return false;
+  }
+  block_ = nullptr;
+  return true;
+}
+
+// X-macro listing every opcode, used to build the threaded dispatch table.
+#define FOR_EACH_OPCODE_ROW(X, r)                                              \
+  X(r##0) X(r##1) X(r##2) X(r##3) X(r##4) X(r##5) X(r##6) X(r##7) X(r##8)      \
+  X(r##9) X(r##A) X(r##B) X(r##C) X(r##D) X(r##E) X(r##F)
+#define FOR_EACH_OPCODE(X)                                                     \
+  FOR_EACH_OPCODE_ROW(X, 0) FOR_EACH_OPCODE_ROW(X, 1)                          \
+  FOR_EACH_OPCODE_ROW(X, 2) FOR_EACH_OPCODE_ROW(X, 3)                          \
+  FOR_EACH_OPCODE_ROW(X, 4) FOR_EACH_OPCODE_ROW(X, 5)                          \
+  FOR_EACH_OPCODE_ROW(X, 6) FOR_EACH_OPCODE_ROW(X, 7)                          \
+  FOR_EACH_OPCODE_ROW(X, 8) FOR_EACH_OPCODE_ROW(X, 9)                          \
+  FOR_EACH_OPCODE_ROW(X, A) FOR_EACH_OPCODE_ROW(X, B)                          \
+  FOR_EACH_OPCODE_ROW(X, C) FOR_EACH_OPCODE_ROW(X, D)                          \
+  FOR_EACH_OPCODE_ROW(X, E) FOR_EACH_OPCODE_ROW(X, F)
+// Same for the superinstructions, in Superinstruction order.
+#define FOR_EACH_SUPERINSTRUCTION(X)                                           \
+  X(CountBranch) X(CompareBranch) X(LoadStore) X(ModifyBranch)
+
+uint64_t Cpu65816::Run(uint64_t cycle_budget) {
+  const uint64_t start_cycles = total_cycles_counter_;
+  // Read back throughout, as EndRunAt() may bring it forward.
+  run_end_cycles_ = start_cycles + cycle_budget;
+  in_run_ = true;
+  // Devices may have changed state since the last Run(), so polling loops
+  // have to prove themselves idle again.
+  idle_loop_.block = nullptr;
+
+  if (trace_log_ || trace_buffer_) {
+    // Tracing is a per-instruction affair, no point in being clever.
+    while (total_cycles_counter_ < run_end_cycles_ &&
+           ExecuteNextInstruction()) {
+    }
+    in_run_ = false;
+    publishSnapshot();
+    return total_cycles_counter_ - start_cycles;
+  }
+
+#if defined(__GNUC__)
+  // Threaded dispatch: every opcode gets its own copy of the fetch and
+  // indirect jump, which gives the branch predictor one history per opcode
+  // instead of a single shared one.
+#define OPCODE_LABEL_ADDRESS(op) &&opcode_##op,
+#define SUPERINSTRUCTION_LABEL_ADDRESS(name) &&superinstruction_##name,
+  static void *const kDispatch[MicroOp::kSuperinstructionDispatch +
+                               kNumSuperinstructions] = {
+      FOR_EACH_OPCODE(OPCODE_LABEL_ADDRESS)
+          FOR_EACH_SUPERINSTRUCTION(SUPERINSTRUCTION_LABEL_ADDRESS)};
+#undef SUPERINSTRUCTION_LABEL_ADDRESS
+#undef OPCODE_LABEL_ADDRESS
+
+#define DISPATCH_NEXT()                                                        \
+  do {                                                                         \
+    if (total_cycles_counter_ >= run_end_cycles_)                              \
+      goto done;                                                               \
+    if (events_pending_.load(std::memory_order_relaxed) && !serviceEvents())   \
+      goto done;                                                               \
+    if (dynarec_ && runCompiledBlock(run_end_cycles_))                         \
+      goto dispatch;                                                           \
+    micro_op_ = nextMicroOp();                                                 \
+    goto *kDispatch[micro_op_ ? micro_op_->dispatch                            \
+                              : system_bus_.ReadByte(program_address_)];       \
+  } while (0)
+
+dispatch:
+  DISPATCH_NEXT();
+
+#define OPCODE_HANDLER(op)                                                     \
+  opcode_##op:                                                                 \
+  if (!op_code_table_[0x##op].execute(*this))                                  \
+    goto done;                                                                 \
+  DISPATCH_NEXT();
+  FOR_EACH_OPCODE(OPCODE_HANDLER)
+#undef OPCODE_HANDLER
+
+#define SUPERINSTRUCTION_HANDLER(name)                                         \
+  superinstruction_##name:                                                     \
+  execute##name();                                                             \
+  DISPATCH_NEXT();
+  FOR_EACH_SUPERINSTRUCTION(SUPERINSTRUCTION_HANDLER)
+#undef SUPERINSTRUCTION_HANDLER
+#undef DISPATCH_NEXT
+
+done:
+  micro_op_ = nullptr;
+#else
+  while (total_cycles_counter_ < run_end_cycles_) {
+    if (events_pending_.load(std::memory_order_relaxed) && !serviceEvents())
+      break;
+    if (dynarec_ && runCompiledBlock(run_end_cycles_))
+      continue;
+    micro_op_ = nextMicroOp();
+    if (micro_op_ &&
+        micro_op_->dispatch >= MicroOp::kSuperinstructionDispatch) {
+      executeSuperinstruction();
+      continue;
+    }
+    const uint8_t instruction = micro_op_
+                                    ? micro_op_->op_code->code()
+                                    : system_bus_.ReadByte(program_address_);
+    if (!op_code_table_[instruction].execute(*this))
+      break;
+  }
+  micro_op_ = nullptr;
+#endif
+  in_run_ = false;
+  publishSnapshot();
+  return total_cycles_counter_ - start_cycles;
+}
+
+#undef FOR_EACH_SUPERINSTRUCTION
+#undef FOR_EACH_OPCODE
+#undef FOR_EACH_OPCODE_ROW
+
 bool Cpu65816::accumulatorIs8BitWide() const {
   // Accumulator is always 8 bit in emulation mode.
   if (cpu_status_.emulation_flag)
@@ -129,17 +389,70 @@ bool Cpu65816::indexIs8BitWide() const {
 
 bool Cpu65816::indexIs16BitWide() const { return !indexIs8BitWide(); }
 
+void Cpu65816::updateOpCodeTable() {
+  int mode = kModeEmulation;
+  if (!cpu_status_.emulation_flag) {
+    mode = (cpu_status_.accumulator_width_flag ? kModeNativeM8X16 : 0) |
+           (cpu_status_.index_width_flag ? kModeNativeM16X8 : 0);
+  }
+  op_code_table_ = kOpCodeTables[mode];
+}
+
 void Cpu65816::addToProgramAddressAndCycles(int bytes, int cycles) {
   total_cycles_counter_ += cycles;
   program_address_.offset_ += bytes;
 }
 
-uint16_t Cpu65816::indexWithXRegister() const {
-  return indexIs8BitWide() ? Binary::lower8BitsOf(x_) : x_;
+Cpu65816::Snapshot Cpu65816::snapshot() const {
+  uint64_t words[kSnapshotWords];
+  uint32_t sequence;
+  do {
+    sequence = snapshot_sequence_.load(std::memory_order_acquire);
+    for (int i = 0; i < kSnapshotWords; i++)
+      words[i] = snapshot_words_[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 1) ||
+           sequence != snapshot_sequence_.load(std::memory_order_relaxed));
+  Snapshot snapshot;
+  memcpy(&snapshot, words, sizeof(snapshot));
+  return snapshot;
 }
 
-uint16_t Cpu65816::indexWithYRegister() const {
-  return indexIs8BitWide() ? Binary::lower8BitsOf(y_) : y_;
+void Cpu65816::publishSnapshot() {
+  Snapshot snapshot = {};
+  snapshot.cycles = total_cycles_counter_;
+  snapshot.program_address = program_address_.AsInt();
+  snapshot.a = a_;
+  snapshot.x = x_;
+  snapshot.y = y_;
+  snapshot.sp = stack_.stack_pointer();
+  snapshot.dp = dp_;
+  snapshot.db = db_;
+  snapshot.p = cpu_status_.register_value();
+  snapshot.emulation = cpu_status_.emulation_flag;
+  uint64_t words[kSnapshotWords] = {};
+  memcpy(words, &snapshot, sizeof(snapshot));
+
+  // Only this thread writes, so a relaxed read of the sequence is enough.
+  const uint32_t sequence = snapshot_sequence_.load(std::memory_order_relaxed);
+  snapshot_sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < kSnapshotWords; i++)
+    snapshot_words_[i].store(words[i], std::memory_order_relaxed);
+  snapshot_sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+void Cpu65816::set_dynarec_mode(Dynarec::Mode mode, uint32_t hot_threshold) {
+  dynarec_.reset();
+  block_cache_.ForgetCompiledCode();
+  if (mode == Dynarec::Mode::kOff)
+    return;
+  if (!Dynarec::IsSupported()) {
+    LOG(WARNING) << "No dynarec for this host, interpreting instead";
+    return;
+  }
+  dynarec_ = std::make_unique<Dynarec>(this, mode);
+  dynarec_hot_threshold_ = hot_threshold;
 }
 
 void Cpu65816::Jump(const Address &address) {
@@ -148,5 +461,6 @@ void Cpu65816::Jump(const Address &address) {
   cpu_status_.emulation_flag = false;
   cpu_status_.accumulator_width_flag = false;
   cpu_status_.index_width_flag = true;
+  updateOpCodeTable();
   program_address_ = address;
 }
@@ -20,149 +20,371 @@
 #ifndef __CPU_65816__
 #define __CPU_65816__
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 
 #include <glog/logging.h>
 
 #include "cpu/addressing.h"
 #include "cpu/binary.h"
+#include "cpu/block_cache.h"
 #include "cpu/cpu_status.h"
+#include "cpu/dynarec.h"
 #include "cpu/interrupt.h"
 #include "cpu/opcode.h"
 #include "cpu/stack.h"
 #include "cpu/system_bus.h"
+#include "cpu/trace_buffer.h"
 
 // Macro used by OpCode methods when an unrecognized OpCode is being executed.
 #define LOG_UNEXPECTED_OPCODE(opCode)                                          \
   LOG(ERROR) << "Unexpected OpCode: " << opCode.name();
 
+// Explicitly instantiates an opcode handler for every CpuMode.
+#define INSTANTIATE_FOR_CPU_MODES(handler)                                     \
+  template void Cpu65816::handler<kModeNativeM16X16>(OpCode &);                \
+  template void Cpu65816::handler<kModeNativeM16X8>(OpCode &);                 \
+  template void Cpu65816::handler<kModeNativeM8X16>(OpCode &);                 \
+  template void Cpu65816::handler<kModeNativeM8X8>(OpCode &);                  \
+  template void Cpu65816::handler<kModeEmulation>(OpCode &)
+
+// The register widths opcode handlers are specialized for. The native modes
+// are indexed by the m and x status bits; in emulation mode both are 8 bit.
+enum CpuMode {
+  kModeNativeM16X16 = 0,
+  kModeNativeM16X8 = 1,
+  kModeNativeM8X16 = 2,
+  kModeNativeM8X8 = 3,
+  kModeEmulation = 4,
+  kNumCpuModes
+};
+
 class Cpu65816Debugger;
 
 class Cpu65816 {
   friend class Cpu65816Debugger;
+  friend class Dynarec;
 
 public:
+  // Register state as published at the end of each Run(), for observers on
+  // other threads.
+  struct Snapshot {
+    uint64_t cycles;
+    uint32_t program_address;
+    uint16_t a, x, y, sp, dp;
+    uint8_t db, p;
+    bool emulation;
+  };
+
   Cpu65816(SystemBus &, EmulationModeInterrupts *, NativeModeInterrupts *);
 
   void SetRESPin(bool value);
   void SetRDYPin(bool value);
 
-  void SetIRQPin(bool value) { pins_.IRQ = value; }
+  void SetIRQPin(bool value) {
+    pins_.IRQ = value;
+    if (value)
+      events_pending_.store(true, std::memory_order_relaxed);
+  }
   void SetNMIPin(bool value) { pins_.NMI = value; }
   void SetABORTPin(bool value) { pins_.ABORT = value; }
 
   bool ExecuteNextInstruction();
 
+  // Executes instructions until at least |cycle_budget| cycles have elapsed,
+  // the RES pin is asserted or an unimplemented opcode is reached. Interrupt
+  // pins are only sampled when one of the Set*Pin calls raised an event.
+  // WAI, and polling loops that only an interrupt or a device can get out
+  // of, skip straight to the end of the budget, so it should not reach past
+  // the next scheduled event, and EndRunAt() has to be told about events
+  // scheduled along the way. Returns the number of cycles actually executed.
+  uint64_t Run(uint64_t cycle_budget);
+
+  // Brings the end of the current Run() forward to |cycle| if that is sooner,
+  // for a device which schedules an event from inside Run(), so that waiting
+  // stops at the event instead of skipping past it. Does nothing outside
+  // Run().
+  void EndRunAt(uint64_t cycle) {
+    if (in_run_ && cycle < run_end_cycles_)
+      run_end_cycles_ = std::max(cycle, total_cycles_counter_);
+  }
+
   void Jump(const Address &address);
 
   Address program_address() const;
   const Stack *stack() const;
   const CpuStatus *cpu_status() const;
 
+  // Only to be called from the thread running the CPU; other threads have to
+  // go through snapshot().
   inline uint64_t total_cycles_counter() const { return total_cycles_counter_; }
 
+  // Returns the state as of the end of the last Run(). Safe to call from any
+  // thread.
+  Snapshot snapshot() const;
+
   uint16_t a() const { return a_; }
   uint16_t x() const { return x_; }
   uint16_t y() const { return y_; }
 
   void set_trace_log(bool trace_log) { trace_log_ = trace_log; }
+
+  // Records every instruction executed into |trace_buffer|, or stops doing so
+  // when null. Like set_trace_log(), this makes Run() step one instruction
+  // at a time.
+  void set_trace_buffer(TraceBuffer *trace_buffer) {
+    trace_buffer_ = trace_buffer;
+  }
+
+  // Lets Run() translate blocks entered at least |hot_threshold| times into
+  // native code. Ignored on hosts the Dynarec has no code generator for.
+  void set_dynarec_mode(Dynarec::Mode mode,
+                        uint32_t hot_threshold = Dynarec::kDefaultHotThreshold);
+
+  // Mnemonic and addressing mode of |code|, which are the same whatever
+  // mode the CPU is in.
+  static const OpCode &DescribeOpCode(uint8_t code) {
+    return kOpCodeTables[kModeEmulation][code];
+  }
+
 private:
   bool accumulatorIs8BitWide() const;
   bool accumulatorIs16BitWide() const;
   bool indexIs8BitWide() const;
   bool indexIs16BitWide() const;
 
-  uint16_t indexWithXRegister() const;
-  uint16_t indexWithYRegister() const;
-
-  Address getAddressOfOpCodeData(OpCode &) const;
-  bool opCodeAddressingCrossesPageBoundary(OpCode &) const;
+  // Compile time versions of the above, for handlers specialized on CpuMode.
+  template <int kMode> static constexpr bool accumulatorIs8BitWide() {
+    return kMode == kModeEmulation || kMode == kModeNativeM8X16 ||
+           kMode == kModeNativeM8X8;
+  }
+  template <int kMode> static constexpr bool accumulatorIs16BitWide() {
+    return !accumulatorIs8BitWide<kMode>();
+  }
+  template <int kMode> static constexpr bool indexIs8BitWide() {
+    return kMode == kModeEmulation || kMode == kModeNativeM16X8 ||
+           kMode == kModeNativeM8X8;
+  }
+  template <int kMode> static constexpr bool indexIs16BitWide() {
+    return !indexIs8BitWide<kMode>();
+  }
+
+  template <int kMode> uint16_t indexWithXRegister() const {
+    return indexIs8BitWide<kMode>() ? Binary::lower8BitsOf(x_) : x_;
+  }
+  template <int kMode> uint16_t indexWithYRegister() const {
+    return indexIs8BitWide<kMode>() ? Binary::lower8BitsOf(y_) : y_;
+  }
+
+  // Selects the opcode table for the current m, x and e bits. Must be called
+  // whenever any of them change.
+  void updateOpCodeTable();
+
+  // Where an instruction's data lives, together with whether indexing
+  // crossed a page on the way there, which costs the indexed modes an extra
+  // cycle. Both come out of the same operand fetch and pointer reads.
+  struct EffectiveAddress {
+    Address address;
+    bool crosses_page;
+  };
+  template <int kMode>
+  EffectiveAddress resolveEffectiveAddress(OpCode &) const;
+  template <int kMode> Address getAddressOfOpCodeData(OpCode &opCode) const {
+    return resolveEffectiveAddress<kMode>(opCode).address;
+  }
 
   void addToProgramAddressAndCycles(int, int);
 
-  // OpCode Table.
-  static OpCode OP_CODE_TABLE[];
+  // OpCode tables, one per CpuMode, with handlers specialized for it.
+  template <int kMode> static OpCode OP_CODE_TABLE[256];
+  static OpCode *const kOpCodeTables[kNumCpuModes];
 
   // OpCodes handling routines.
   // Implementations for these methods can be found in the corresponding
   // OpCode_XXX.cpp file.
-  void executeORA(OpCode &);
-  void executeORA8Bit(OpCode &);
-  void executeORA16Bit(OpCode &);
-  void executeStack(OpCode &);
-  void executeStatusReg(OpCode &);
-  void executeMemoryROL(OpCode &);
-  void executeAccumulatorROL();
-  void executeROL(OpCode &);
-  void executeMemoryROR(OpCode &);
-  void executeAccumulatorROR();
-  void executeROR(OpCode &);
-  void executeInterrupt(OpCode &);
-  void executeJumpReturn(OpCode &);
-  void execute8BitSBC(OpCode &);
-  void execute16BitSBC(OpCode &);
-  void execute8BitBCDSBC(OpCode &);
-  void execute16BitBCDSBC(OpCode &);
-  void executeSBC(OpCode &);
-  void execute8BitADC(OpCode &);
-  void execute16BitADC(OpCode &);
-  void execute8BitBCDADC(OpCode &);
-  void execute16BitBCDADC(OpCode &);
-  void executeADC(OpCode &);
-  void executeSTA(OpCode &);
-  void executeSTX(OpCode &);
-  void executeSTY(OpCode &);
-  void executeSTZ(OpCode &);
-  void executeTransfer(OpCode &);
-  void executeMemoryASL(OpCode &);
-  void executeAccumulatorASL();
-  void executeASL(OpCode &);
-  void executeAND8Bit(OpCode &);
-  void executeAND16Bit(OpCode &);
-  void executeAND(OpCode &);
-  void executeLDA8Bit(OpCode &);
-  void executeLDA16Bit(OpCode &);
-  void executeLDA(OpCode &);
-  void executeLDX8Bit(OpCode &);
-  void executeLDX16Bit(OpCode &);
-  void executeLDX(OpCode &);
-  void executeLDY8Bit(OpCode &);
-  void executeLDY16Bit(OpCode &);
-  void executeLDY(OpCode &);
-  void executeEOR8Bit(OpCode &);
-  void executeEOR16Bit(OpCode &);
-  void executeEOR(OpCode &);
-  int executeBranchShortOnCondition(bool, OpCode &);
-  int executeBranchLongOnCondition(bool, OpCode &);
-  void executeBranch(OpCode &);
-  void execute8BitCMP(OpCode &);
-  void execute16BitCMP(OpCode &);
-  void executeCMP(OpCode &);
-  void execute8BitDecInMemory(OpCode &);
-  void execute16BitDecInMemory(OpCode &);
-  void execute8BitIncInMemory(OpCode &);
-  void execute16BitIncInMemory(OpCode &);
-  void executeINCDEC(OpCode &);
-  void execute8BitCPX(OpCode &);
-  void execute16BitCPX(OpCode &);
-  void execute8BitCPY(OpCode &);
-  void execute16BitCPY(OpCode &);
-  void executeCPXCPY(OpCode &);
-  void execute8BitTSB(OpCode &);
-  void execute16BitTSB(OpCode &);
-  void execute8BitTRB(OpCode &);
-  void execute16BitTRB(OpCode &);
-  void executeTSBTRB(OpCode &);
-  void execute8BitBIT(OpCode &);
-  void execute16BitBIT(OpCode &);
-  void executeBIT(OpCode &);
-  void executeMemoryLSR(OpCode &);
-  void executeAccumulatorLSR();
-  void executeLSR(OpCode &);
-  void executeMisc(OpCode &);
+  template <int kMode> void executeORA(OpCode &);
+  template <int kMode> void executeORA8Bit(const Address &);
+  template <int kMode> void executeORA16Bit(const Address &);
+  template <int kMode> void executeStack(OpCode &);
+  template <int kMode> void executeStatusReg(OpCode &);
+  template <int kMode> void executeMemoryROL(const Address &);
+  template <int kMode> void executeAccumulatorROL();
+  template <int kMode> void executeROL(OpCode &);
+  template <int kMode> void executeMemoryROR(const Address &);
+  template <int kMode> void executeAccumulatorROR();
+  template <int kMode> void executeROR(OpCode &);
+  template <int kMode> void executeInterrupt(OpCode &);
+  template <int kMode> void executeJumpReturn(OpCode &);
+  template <int kMode> void execute8BitSBC(const Address &);
+  template <int kMode> void execute16BitSBC(const Address &);
+  template <int kMode> void execute8BitBCDSBC(const Address &);
+  template <int kMode> void execute16BitBCDSBC(const Address &);
+  template <int kMode> void executeSBC(OpCode &);
+  template <int kMode> void execute8BitADC(const Address &);
+  template <int kMode> void execute16BitADC(const Address &);
+  template <int kMode> void execute8BitBCDADC(const Address &);
+  template <int kMode> void execute16BitBCDADC(const Address &);
+  template <int kMode> void executeADC(OpCode &);
+  template <int kMode> void executeSTA(OpCode &);
+  template <int kMode> void executeSTX(OpCode &);
+  template <int kMode> void executeSTY(OpCode &);
+  template <int kMode> void executeSTZ(OpCode &);
+  template <int kMode> void executeTransfer(OpCode &);
+  template <int kMode> void executeMemoryASL(const Address &);
+  template <int kMode> void executeAccumulatorASL();
+  template <int kMode> void executeASL(OpCode &);
+  template <int kMode> void executeAND8Bit(const Address &);
+  template <int kMode> void executeAND16Bit(const Address &);
+  template <int kMode> void executeAND(OpCode &);
+  template <int kMode> void executeLDA8Bit(const Address &);
+  template <int kMode> void executeLDA16Bit(const Address &);
+  template <int kMode> void executeLDA(OpCode &);
+  template <int kMode> void executeLDX8Bit(const Address &);
+  template <int kMode> void executeLDX16Bit(const Address &);
+  template <int kMode> void executeLDX(OpCode &);
+  template <int kMode> void executeLDY8Bit(const Address &);
+  template <int kMode> void executeLDY16Bit(const Address &);
+  template <int kMode> void executeLDY(OpCode &);
+  template <int kMode> void executeEOR8Bit(const Address &);
+  template <int kMode> void executeEOR16Bit(const Address &);
+  template <int kMode> void executeEOR(OpCode &);
+  template <int kMode> int executeBranchShortOnCondition(bool, OpCode &);
+  template <int kMode> int executeBranchLongOnCondition(bool, OpCode &);
+  template <int kMode> void executeBranch(OpCode &);
+  template <int kMode> void execute8BitCMP(const Address &);
+  template <int kMode> void execute16BitCMP(const Address &);
+  template <int kMode> void executeCMP(OpCode &);
+  template <int kMode> void execute8BitDecInMemory(const Address &);
+  template <int kMode> void execute16BitDecInMemory(const Address &);
+  template <int kMode> void execute8BitIncInMemory(const Address &);
+  template <int kMode> void execute16BitIncInMemory(const Address &);
+  template <int kMode> void executeINCDEC(OpCode &);
+  template <int kMode> void execute8BitCPX(OpCode &);
+  template <int kMode> void execute16BitCPX(OpCode &);
+  template <int kMode> void execute8BitCPY(OpCode &);
+  template <int kMode> void execute16BitCPY(OpCode &);
+  template <int kMode> void executeCPXCPY(OpCode &);
+  template <int kMode> void execute8BitTSB(OpCode &);
+  template <int kMode> void execute16BitTSB(OpCode &);
+  template <int kMode> void execute8BitTRB(OpCode &);
+  template <int kMode> void execute16BitTRB(OpCode &);
+  template <int kMode> void executeTSBTRB(OpCode &);
+  template <int kMode> void execute8BitBIT(OpCode &, const Address &);
+  template <int kMode> void execute16BitBIT(OpCode &, const Address &);
+  template <int kMode> void executeBIT(OpCode &);
+  template <int kMode> void executeMemoryLSR(const Address &);
+  template <int kMode> void executeAccumulatorLSR();
+  template <int kMode> void executeLSR(OpCode &);
+  template <int kMode> void executeMisc(OpCode &);
+  // Moves bytes for MVN (|step| 1) and MVP (|step| -1).
+  template <int kMode> void executeBlockMove(int step);
 
   void reset();
+  // Takes the IRQ: pushes the return state and loads PC from the IRQ vector.
+  void serviceIRQ();
+  // Handles the pins that raised events_pending_. Returns false if execution
+  // must stop.
+  bool serviceEvents();
+  // Returns the predecoded instruction at the PC, or nullptr if it could not
+  // be decoded.
+  const MicroOp *nextMicroOp();
+  // Makes nextMicroOp() carry on from the start of |block|, checking for a
+  // trip round a polling loop on the way.
+  void enterBlock(DecodedBlock *block);
+  // Called whenever execution gets back to the start of |block|'s polling
+  // loop. Once a whole trip left the registers as they were, the loop can
+  // only be left by an interrupt or a device changing state, neither of
+  // which happens before the end of the Run() budget, so the remaining trips
+  // are skipped.
+  void skipIdleLoop(const DecodedBlock *block);
+  void idleUntilEndOfRun() {
+    if (total_cycles_counter_ < run_end_cycles_)
+      total_cycles_counter_ = run_end_cycles_;
+  }
+  // Runs the compiled code for the block starting at the PC, compiling it if
+  // it has become hot. Returns false if the interpreter has to carry on
+  // instead.
+  bool runCompiledBlock(uint64_t end_cycles);
+  // Superinstructions, run with micro_op_ on their first instruction. They
+  // stop after it wherever Run() would have stopped or serviced an event.
+  // Their second instruction runs through its usual handler, so a fused
+  // branch is timed by executeBranchShortOnCondition like any other.
+  void executeSuperinstruction();
+  void executeCountBranch();
+  void executeCompareBranch();
+  void executeLoadStore();
+  void executeModifyBranch();
+  // Moves micro_op_ on to the second instruction of a superinstruction,
+  // unless Run() has to look at the budget, an event or rewritten code
+  // first.
+  bool enterSecondInstruction();
+  // Copies the registers to snapshot_words_ under snapshot_sequence_.
+  void publishSnapshot();
+  // Appends the state before executing |instruction| to trace_buffer_.
+  void traceInstruction(uint8_t instruction);
+
+  // Operand bytes of the current instruction, taken from the predecoded
+  // MicroOp when running from the block cache. The instruction may have
+  // already written over its own operand (e.g. JSR pushing onto it), in which
+  // case they are fetched again: with a single read when they are in RAM,
+  // through the bus otherwise.
+  bool hasPredecodedOperand() const {
+    return micro_op_ && block_cache_.IsValid(*block_);
+  }
+  bool fetchOperandFromRam(uint32_t *operand) const {
+    if (program_address_.offset_ == 0xFFFF)
+      return false;
+    const uint8_t *mem =
+        system_bus_.DirectPointer(program_address_.AsInt() + 1, 4);
+    if (!mem)
+      return false;
+    memcpy(operand, mem, 4);
+    return true;
+  }
+  uint8_t operand8() const {
+    uint32_t operand;
+    if (hasPredecodedOperand())
+      return (uint8_t)micro_op_->operand;
+    if (fetchOperandFromRam(&operand))
+      return (uint8_t)operand;
+    return system_bus_.ReadByte(program_address_.WithOffset(1));
+  }
+  uint16_t operand16() const {
+    uint32_t operand;
+    if (hasPredecodedOperand())
+      return (uint16_t)micro_op_->operand;
+    if (fetchOperandFromRam(&operand))
+      return (uint16_t)operand;
+    return system_bus_.ReadWord(program_address_.WithOffset(1));
+  }
+  Address operand24() const {
+    uint32_t operand;
+    if (hasPredecodedOperand())
+      return Address(micro_op_->operand);
+    if (fetchOperandFromRam(&operand))
+      return Address(operand & 0xFFFFFF);
+    return system_bus_.ReadAddressAt(program_address_ + 1);
+  }
+
+  // Pointers fetched from bank 0 by the direct page (and stack relative)
+  // indirect addressing modes, read through direct_page_window_.
+  uint16_t directPagePointer16(uint16_t offset) const {
+    if (offset != 0xFFFF) {
+      if (const uint8_t *mem = direct_page_window_.Get(system_bus_, offset, 2))
+        return mem[0] | mem[1] << 8;
+    }
+    return system_bus_.ReadWord(Address(0x00, offset));
+  }
+  Address directPagePointer24(uint16_t offset) const {
+    if (offset < 0xFFFE) {
+      if (const uint8_t *mem = direct_page_window_.Get(system_bus_, offset, 3))
+        return Address(mem[0] | mem[1] << 8 | mem[2] << 16);
+    }
+    return system_bus_.ReadAddressAt(Address(0x00, offset));
+  }
 
   SystemBus &system_bus_;
   EmulationModeInterrupts *emulation_mode_interrupts_;
@@ -186,7 +408,7 @@ private:
     // 0x00FFFC)
     bool RES = true;
     // Ready to false means CPU is waiting for an NMI/IRQ/ABORT/RESET
-    bool RDY = false;
+    bool RDY = true;
 
     // nmi true execute nmi vector (0x00FFEA)
     bool NMI = false;
@@ -198,14 +420,54 @@ private:
   } pins_;
 
   Stack stack_;
+  mutable PageWindow direct_page_window_;
+
+  // The entry of kOpCodeTables for the current CpuMode.
+  OpCode *op_code_table_;
+
+  // Decoded code used by Run(). micro_op_ is only set while executing an
+  // instruction that came from block_.
+  BlockCache block_cache_;
+  DecodedBlock *block_ = nullptr;
+  int block_pos_ = 0;
+  const MicroOp *micro_op_ = nullptr;
+  // Registers at the start of the last trip round a polling loop, see
+  // skipIdleLoop().
+  struct {
+    const DecodedBlock *block = nullptr;
+    uint64_t cycles = 0;
+    uint16_t a = 0, x = 0, y = 0;
+    uint8_t p = 0;
+  } idle_loop_;
+
+  std::unique_ptr<Dynarec> dynarec_;
+  uint32_t dynarec_hot_threshold_ = Dynarec::kDefaultHotThreshold;
+  // End of the current Run() budget, checked by compiled loops and block
+  // moves and brought forward by EndRunAt().
+  uint64_t run_end_cycles_ = 0;
+  // Whether Run() is on the stack, as opposed to a single step from outside.
+  bool in_run_ = false;
 
   // Address of the current OpCode
   Address program_address_{0x00, 0x0000};
 
   // Total number of cycles
-  std::atomic<uint64_t> total_cycles_counter_ = 0;
+  uint64_t total_cycles_counter_ = 0;
+
+  // Seqlock protected copy of the Snapshot: odd sequence numbers mean a
+  // write is in progress. The words are atomics so that torn reads are
+  // merely retried rather than undefined.
+  static constexpr int kSnapshotWords =
+      (sizeof(Snapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  std::atomic<uint32_t> snapshot_sequence_{0};
+  std::atomic<uint64_t> snapshot_words_[kSnapshotWords] = {};
 
   bool trace_log_ = false;
+  TraceBuffer *trace_buffer_ = nullptr;
+
+  // Set when a pin that Run() has to look at changed. Stays raised while IRQ
+  // is held so that the interrupt is taken as soon as it gets unmasked.
+  std::atomic<bool> events_pending_ = true;
 };
 
 #endif
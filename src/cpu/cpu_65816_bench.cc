@@ -0,0 +1,227 @@
+// Throughput of the Cpu65816 interpreter on synthetic kernels, each a loop
+// exercising one class of instructions. Reports emulated MHz and host ns per
+// instruction, so changes to Run() or the opcode handlers can be compared
+// against a baseline:
+//
+//   c256_cpu_bench --benchmark_repetitions=5 --benchmark_format=json
+
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "bus/ram_device.h"
+#include "cpu/cpu_65816.h"
+
+namespace {
+
+constexpr uint16_t kSetupAddress = 0x1000;
+constexpr uint16_t kKernelAddress = 0x2000;
+constexpr uint16_t kSubroutineAddress = 0x3000;
+constexpr int kBodyRepeats = 8;
+constexpr uint64_t kCyclesPerIteration = 100000;
+
+// All kernels run in native mode with 16-bit registers. The body is
+// repeated kBodyRepeats times and followed by a JMP back to its start.
+struct Kernel {
+  // Runs once, after switching to native mode.
+  std::vector<uint8_t> prologue;
+  std::vector<uint8_t> body;
+};
+
+const Kernel kAluImmediate = {
+    {},
+    {
+        0x69, 0x34, 0x12, // ADC #$1234
+        0x29, 0xFF, 0x7F, // AND #$7FFF
+        0x09, 0x01, 0x01, // ORA #$0101
+        0x49, 0x55, 0x55, // EOR #$5555
+        0xC9, 0x00, 0x40, // CMP #$4000
+        0xE9, 0x11, 0x00, // SBC #$0011
+    }};
+
+const Kernel kAbsoluteLoadStore = {
+    {},
+    {
+        0xAD, 0x00, 0x40, // LDA $4000
+        0x8D, 0x02, 0x40, // STA $4002
+        0xAE, 0x04, 0x40, // LDX $4004
+        0x8E, 0x06, 0x40, // STX $4006
+        0xAC, 0x08, 0x40, // LDY $4008
+        0x8C, 0x0A, 0x40, // STY $400A
+        0xEE, 0x0C, 0x40, // INC $400C
+    }};
+
+const Kernel kIndirectLong = {
+    {},
+    {
+        0xA7, 0x10,             // LDA [$10]
+        0x87, 0x13,             // STA [$13]
+        0xB7, 0x10,             // LDA [$10],Y
+        0x97, 0x13,             // STA [$13],Y
+        0xAF, 0x00, 0x40, 0x01, // LDA $014000
+        0x8F, 0x00, 0x60, 0x01, // STA $016000
+        0xC8,                   // INY
+    }};
+
+const Kernel kBranches = {
+    {},
+    {
+        0xE8,       // INX
+        0xD0, 0x00, // BNE, taken
+        0xF0, 0x00, // BEQ, not taken
+        0x10, 0x00, // BPL
+        0x30, 0x00, // BMI
+        0x80, 0x00, // BRA
+        0x90, 0x00, // BCC
+        0xB0, 0x00, // BCS
+    }};
+
+const Kernel kStack = {
+    {},
+    {
+        0x48,             // PHA
+        0xDA,             // PHX
+        0x5A,             // PHY
+        0x7A,             // PLY
+        0xFA,             // PLX
+        0x68,             // PLA
+        0x08,             // PHP
+        0x28,             // PLP
+        0xF4, 0x34, 0x12, // PEA $1234
+        0x68,             // PLA
+        0x0B,             // PHD
+        0x2B,             // PLD
+        0x8B,             // PHB
+        0xAB,             // PLB
+        0x20, 0x00, 0x30, // JSR $3000, which is an RTS
+    }};
+
+const Kernel kBlockMove = {
+    {},
+    {
+        0xA9, 0xFF, 0x00, // LDA #$00FF
+        0xA2, 0x00, 0x40, // LDX #$4000
+        0xA0, 0x00, 0x60, // LDY #$6000
+        0x54, 0x00, 0x00, // MVN $00,$00
+    }};
+
+const Kernel kDecimal = {
+    {
+        0xF8, // SED
+    },
+    {
+        0x69, 0x34, 0x12, // ADC #$1234
+        0xE9, 0x67, 0x05, // SBC #$0567
+        0x6D, 0x00, 0x40, // ADC $4000
+        0xED, 0x02, 0x40, // SBC $4002
+    }};
+
+// A Cpu65816 on 256k of RAM, reset into |kernel|.
+class Machine {
+public:
+  explicit Machine(const Kernel &kernel)
+      : memory_(Address(0x0, 0x0), Address(0x3, 0xffff)) {
+    bus_.RegisterDevice(&memory_);
+    uint8_t *ram = memory_.region().mem;
+
+    std::vector<uint8_t> setup = {
+        0x18,             // CLC
+        0xFB,             // XCE
+        0xC2, 0x30,       // REP #$30
+        0xA9, 0x00, 0x00, // LDA #0
+        0xA2, 0x00, 0x00, // LDX #0
+        0xA0, 0x00, 0x00, // LDY #0
+    };
+    setup.insert(setup.end(), kernel.prologue.begin(), kernel.prologue.end());
+    setup.insert(setup.end(),
+                 {0x4C, kKernelAddress & 0xFF, kKernelAddress >> 8}); // JMP
+    memcpy(&ram[kSetupAddress], setup.data(), setup.size());
+
+    uint16_t address = kKernelAddress;
+    for (int i = 0; i < kBodyRepeats; i++) {
+      memcpy(&ram[address], kernel.body.data(), kernel.body.size());
+      address += kernel.body.size();
+    }
+    const uint8_t jump[] = {0x4C, kKernelAddress & 0xFF, kKernelAddress >> 8};
+    memcpy(&ram[address], jump, sizeof(jump));
+
+    ram[kSubroutineAddress] = 0x60; // RTS
+    // Long pointers to $01:4000 and $01:6000 for the indirect kernel.
+    const uint8_t pointers[] = {0x00, 0x40, 0x01, 0x00, 0x60, 0x01};
+    memcpy(&ram[0x10], pointers, sizeof(pointers));
+    for (uint32_t i = 0; i < 0x100; i++)
+      ram[0x4000 + i] = ram[0x14000 + i] = i * 0x47;
+
+    ram[0xFFFC] = kSetupAddress & 0xFF;
+    ram[0xFFFD] = kSetupAddress >> 8;
+    cpu_ = std::make_unique<Cpu65816>(bus_, &emulation_interrupts_,
+                                      &native_interrupts_);
+    cpu_->SetRESPin(false);
+  }
+
+  Cpu65816 *cpu() { return cpu_.get(); }
+
+private:
+  RAMDevice memory_;
+  SystemBus bus_;
+  EmulationModeInterrupts emulation_interrupts_{0xfff4, 0xfff8, 0xfff8,
+                                                0xfffa, 0xfffc, 0xfffe};
+  NativeModeInterrupts native_interrupts_{0xffe4, 0xffe6, 0xffe8,
+                                          0xffea, 0xfffc, 0xffee};
+  std::unique_ptr<Cpu65816> cpu_;
+};
+
+// Counts the instructions and cycles of one trip around the kernel's loop,
+// by single stepping; MVN counts once per byte moved, as on the hardware.
+void MeasureTrip(const Kernel &kernel, uint64_t *instructions,
+                 uint64_t *cycles) {
+  Machine machine(kernel);
+  Cpu65816 *cpu = machine.cpu();
+  while (cpu->program_address().AsInt() != kKernelAddress)
+    cpu->Run(1);
+  const uint64_t start_cycles = cpu->total_cycles_counter();
+  *instructions = 0;
+  do {
+    cpu->Run(1);
+    ++*instructions;
+  } while (cpu->program_address().AsInt() != kKernelAddress);
+  *cycles = cpu->total_cycles_counter() - start_cycles;
+}
+
+void BM_Kernel(benchmark::State &state, const Kernel &kernel) {
+  uint64_t trip_instructions, trip_cycles;
+  MeasureTrip(kernel, &trip_instructions, &trip_cycles);
+
+  Machine machine(kernel);
+  Cpu65816 *cpu = machine.cpu();
+  uint64_t cycles = 0;
+  // CPU time, like the benchmark's own CPU column.
+  const std::clock_t start = std::clock();
+  for (auto _ : state)
+    cycles += cpu->Run(kCyclesPerIteration);
+  const double seconds =
+      static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+  // The loops take the same path every trip, so instructions go in
+  // proportion to cycles.
+  const double instructions =
+      static_cast<double>(cycles) * trip_instructions / trip_cycles;
+  state.SetItemsProcessed(static_cast<int64_t>(instructions));
+  state.counters["emulated_MHz"] = cycles / seconds / 1e6;
+  state.counters["ns_per_instruction"] = seconds * 1e9 / instructions;
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_Kernel, alu_immediate, kAluImmediate);
+BENCHMARK_CAPTURE(BM_Kernel, absolute_load_store, kAbsoluteLoadStore);
+BENCHMARK_CAPTURE(BM_Kernel, indirect_long, kIndirectLong);
+BENCHMARK_CAPTURE(BM_Kernel, branches, kBranches);
+BENCHMARK_CAPTURE(BM_Kernel, stack, kStack);
+BENCHMARK_CAPTURE(BM_Kernel, block_move, kBlockMove);
+BENCHMARK_CAPTURE(BM_Kernel, decimal, kDecimal);
+
+BENCHMARK_MAIN();
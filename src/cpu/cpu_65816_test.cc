@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bus/ram_device.h"
+#include "cpu/cpu_65816.h"
+#include "cpu/trace_buffer.h"
+
+// A CPU over a bank of RAM, which starts running from 0x1000 once the test
+// releases RES.
+class Cpu65816Test : public ::testing::Test {
+protected:
+  void SetUp() override {
+    bus.RegisterDevice(&memory);
+    bus.StoreWord(Address(0x0, 0xfffc), 0x1000);
+  }
+
+  template <size_t N> void Load(uint16_t address, const uint8_t (&data)[N]) {
+    memcpy(mem() + address, data, N);
+  }
+  uint8_t *mem() { return memory.region().mem; }
+
+  RAMDevice memory{Address(0x0, 0x0), Address(0x0, 0xffff)};
+  SystemBus bus;
+  EmulationModeInterrupts emulation_interrupts{0xfff4, 0xfff8, 0xfff8,
+                                               0xfffa, 0xfffc, 0xfffe};
+  NativeModeInterrupts native_interrupts{0xffe4, 0xffe6, 0xffe8,
+                                         0xffea, 0xfffc, 0xffee};
+  Cpu65816 cpu{bus, &emulation_interrupts, &native_interrupts};
+};
+
+TEST_F(Cpu65816Test, SelfModifyingCode) {
+  // LDA $2000; INC $1001; CMP #$04; BNE $1000; WAI
+  const uint8_t program[] = {0xad, 0x00, 0x20, 0xee, 0x01, 0x10,
+                             0xc9, 0x04, 0xd0, 0xf6, 0xcb};
+  const uint8_t data[] = {0x01, 0x02, 0x03, 0x04};
+  Load(0x1000, program);
+  Load(0x2000, data);
+
+  cpu.SetRESPin(false);
+  cpu.Run(1000);
+  EXPECT_EQ(cpu.a(), 0x04);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x100b));
+  EXPECT_EQ(cpu.total_cycles_counter(), 1000u);
+
+  const Cpu65816::Snapshot snapshot = cpu.snapshot();
+  EXPECT_EQ(snapshot.a, 0x04);
+  EXPECT_EQ(snapshot.program_address, 0x100bu);
+  EXPECT_EQ(snapshot.cycles, cpu.total_cycles_counter());
+}
+
+TEST_F(Cpu65816Test, DynarecSelfModifyingCode) {
+  // LDA $2000; INC $1001; CMP #$04; BNE $1000; WAI
+  const uint8_t program[] = {0xad, 0x00, 0x20, 0xee, 0x01, 0x10,
+                             0xc9, 0x04, 0xd0, 0xf6, 0xcb};
+  const uint8_t data[] = {0x01, 0x02, 0x03, 0x04};
+  Load(0x1000, program);
+  Load(0x2000, data);
+
+  cpu.set_dynarec_mode(Dynarec::Mode::kOn, 1);
+  cpu.SetRESPin(false);
+  cpu.Run(1000);
+  EXPECT_EQ(cpu.a(), 0x04);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x100b));
+}
+
+TEST_F(Cpu65816Test, TraceBuffer) {
+  // LDX #$03; DEX; BNE $1002; WAI
+  const uint8_t program[] = {0xa2, 0x03, 0xca, 0xd0, 0xfd, 0xcb};
+  Load(0x1000, program);
+
+  TraceBuffer trace(4);
+  cpu.set_trace_buffer(&trace);
+  cpu.SetRESPin(false);
+  cpu.Run(20);
+
+  // LDX, three times DEX and BNE, then WAI.
+  EXPECT_EQ(trace.recorded(), 8u);
+  const std::vector<TraceRecord> last = trace.Last(8);
+  ASSERT_EQ(last.size(), 4u);
+  EXPECT_EQ(last[0].op_code, 0xd0);
+  EXPECT_EQ(last[0].x, 0x01);
+  EXPECT_EQ(last[1].op_code, 0xca);
+  EXPECT_EQ(last[2].op_code, 0xd0);
+  EXPECT_EQ(last[2].x, 0x00);
+  EXPECT_EQ(last[3].op_code, 0xcb);
+  EXPECT_EQ(last[3].program_address, 0x1005u);
+  EXPECT_TRUE(last[3].emulation);
+  EXPECT_LT(last[0].cycles, last[3].cycles);
+}
+
+TEST_F(Cpu65816Test, BlockMove) {
+  // CLC; XCE; REP #$30; LDA #$1fff; LDX #$4000; LDY #$2000; MVN $00,$00;
+  // LDA #$00ff; LDX #$6000; LDY #$6001; MVN $00,$00; WAI
+  const uint8_t program[] = {0x18, 0xfb, 0xc2, 0x30, 0xa9, 0xff, 0x1f, 0xa2,
+                             0x00, 0x40, 0xa0, 0x00, 0x20, 0x54, 0x00, 0x00,
+                             0xa9, 0xff, 0x00, 0xa2, 0x00, 0x60, 0xa0, 0x01,
+                             0x60, 0x54, 0x00, 0x00, 0xcb};
+  Load(0x1000, program);
+  uint8_t *mem = this->mem();
+  for (int i = 0; i < 0x2000; i++)
+    mem[0x4000 + i] = i * 7;
+  mem[0x6000] = 0xaa;
+
+  cpu.SetRESPin(false);
+
+  // The move stops at the end of the budget, with the PC still on it.
+  cpu.Run(16 + 7 * 100);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x100d));
+  EXPECT_EQ(cpu.a(), 0x1fff - 100);
+  EXPECT_EQ(cpu.x(), 0x4000 + 100);
+  EXPECT_EQ(cpu.y(), 0x2000 + 100);
+  EXPECT_EQ(mem[0x2000 + 99], (uint8_t)(99 * 7));
+  EXPECT_EQ(mem[0x2000 + 100], 0);
+
+  cpu.Run(7 * 0x2000 + 9 + 7 * 0x100 - 7 * 100);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x101c));
+  EXPECT_EQ(cpu.total_cycles_counter(), 16u + 7 * 0x2000 + 9 + 7 * 0x100);
+  for (int i = 0; i < 0x2000; i++)
+    ASSERT_EQ(mem[0x2000 + i], (uint8_t)(i * 7)) << i;
+  EXPECT_EQ(cpu.x(), 0x6100);
+  EXPECT_EQ(cpu.y(), 0x6101);
+  // Moving a byte up over itself repeats it.
+  for (int i = 0; i <= 0x100; i++)
+    ASSERT_EQ(mem[0x6000 + i], 0xaa) << i;
+}
+
+TEST_F(Cpu65816Test, WaitForInterrupt) {
+  // CLI; WAI; INX; SEI; WAI; INX; BRA $1006
+  const uint8_t program[] = {0x58, 0xcb, 0xe8, 0x78, 0xcb, 0xe8, 0x80, 0xfe};
+  // LDA #$42; RTI
+  const uint8_t handler[] = {0xa9, 0x42, 0x40};
+  Load(0x1000, program);
+  Load(0x2000, handler);
+  bus.StoreWord(Address(0x0, 0xfffe), 0x2000);
+
+  cpu.SetRESPin(false);
+
+  // Waiting takes up the whole budget, however big.
+  EXPECT_EQ(cpu.Run(1000), 1000u);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1002));
+  EXPECT_EQ(cpu.Run(1000000), 1000000u);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1002));
+
+  // The interrupt wakes the CPU up and gets taken.
+  cpu.SetIRQPin(true);
+  cpu.Run(2);
+  EXPECT_EQ(cpu.a(), 0x42);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x2002));
+  cpu.SetIRQPin(false);
+
+  // With interrupts disabled it only wakes the CPU up.
+  cpu.Run(1000);
+  EXPECT_EQ(cpu.x(), 0x01);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1005));
+  cpu.SetIRQPin(true);
+  cpu.Run(1000);
+  EXPECT_EQ(cpu.x(), 0x02);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1006));
+  EXPECT_EQ(cpu.a(), 0x42);
+}
+
+TEST_F(Cpu65816Test, StepWhileWaiting) {
+  // SEI; WAI; INX
+  const uint8_t program[] = {0x78, 0xcb, 0xe8};
+  Load(0x1000, program);
+
+  cpu.SetRESPin(false);
+  cpu.Run(1000);
+
+  // Outside Run() each step waits a single cycle, whatever the last budget.
+  const uint64_t cycles = cpu.total_cycles_counter();
+  ASSERT_TRUE(cpu.ExecuteNextInstruction());
+  EXPECT_EQ(cpu.total_cycles_counter(), cycles + 1);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1002));
+
+  // With interrupts disabled IRQ only wakes the CPU up.
+  cpu.SetIRQPin(true);
+  ASSERT_TRUE(cpu.ExecuteNextInstruction());
+  EXPECT_EQ(cpu.x(), 0x01);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1003));
+}
+
+namespace {
+
+// A device register that reads as whatever it was last set to.
+class StatusRegister : public SystemBusDevice {
+public:
+  explicit StatusRegister(const Address &address)
+      : address_(address.AsInt()) {}
+
+  void StoreByte(const Address &, uint8_t, uint8_t **) override {}
+  uint8_t ReadByte(const Address &, uint8_t **) override {
+    reads++;
+    return value;
+  }
+  bool DecodeAddress(const Address &from, Address &to) override {
+    to = from;
+    return from.AsInt() == address_;
+  }
+
+  uint8_t value = 0;
+  int reads = 0;
+
+private:
+  const uint32_t address_;
+};
+
+} // namespace
+
+TEST_F(Cpu65816Test, PollingLoop) {
+  StatusRegister status(Address(0x1, 0x2000));
+  bus.RegisterDevice(&status);
+  // LDA $012000; AND #$80; BEQ $1000; WAI
+  const uint8_t program[] = {0xaf, 0x00, 0x20, 0x01, 0x29,
+                             0x80, 0xf0, 0xf8, 0xcb};
+  Load(0x1000, program);
+
+  for (Dynarec::Mode mode : {Dynarec::Mode::kOff, Dynarec::Mode::kOn}) {
+    status.value = 0;
+    status.reads = 0;
+    Cpu65816 polling(bus, &emulation_interrupts, &native_interrupts);
+    polling.set_dynarec_mode(mode, 1);
+    polling.SetRESPin(false);
+
+    // After going round twice the rest of the budget is skipped, in whole
+    // trips of 5 + 2 + 3 cycles.
+    polling.Run(100000);
+    EXPECT_LT(status.reads, 5);
+    EXPECT_EQ(polling.total_cycles_counter() % 10, 5u);
+    EXPECT_GE(polling.total_cycles_counter(), 100000u);
+
+    status.value = 0x80;
+    polling.Run(1000);
+    EXPECT_EQ(polling.program_address(), Address(0x0, 0x1009));
+    EXPECT_EQ(polling.a(), 0x80);
+  }
+}
+
+namespace {
+
+// A device register which, like a timer being started, schedules an event a
+// fixed number of cycles after each store to it.
+class TimerRegister : public SystemBusDevice {
+public:
+  TimerRegister(const Address &address, uint64_t delay)
+      : address_(address.AsInt()), delay_(delay) {}
+
+  void StoreByte(const Address &, uint8_t, uint8_t **) override {
+    event_cycle = cpu->total_cycles_counter() + delay_;
+    cpu->EndRunAt(event_cycle);
+  }
+  uint8_t ReadByte(const Address &, uint8_t **) override { return 0; }
+  bool DecodeAddress(const Address &from, Address &to) override {
+    to = from;
+    return from.AsInt() == address_;
+  }
+
+  Cpu65816 *cpu = nullptr;
+  uint64_t event_cycle = 0;
+
+private:
+  const uint32_t address_;
+  const uint64_t delay_;
+};
+
+} // namespace
+
+TEST_F(Cpu65816Test, EventDuringRun) {
+  TimerRegister timer(Address(0x1, 0x2000), 500);
+  timer.cpu = &cpu;
+  bus.RegisterDevice(&timer);
+  // SEI; STA $012000; WAI
+  const uint8_t program[] = {0x78, 0x8f, 0x00, 0x20, 0x01, 0xcb};
+  Load(0x1000, program);
+  cpu.SetRESPin(false);
+
+  // Waiting stops at the event rather than at the end of the budget.
+  EXPECT_EQ(cpu.Run(1000000), timer.event_cycle);
+  EXPECT_EQ(cpu.program_address(), Address(0x0, 0x1006));
+
+  // The next Run() gets its whole budget again.
+  EXPECT_EQ(cpu.Run(1000), 1000u);
+}
+
+TEST_F(Cpu65816Test, Superinstructions) {
+  // LDX #$10; LDA $2000,X; STA $3000,X; DEX; BPL $1002; LDY #$00; INY;
+  // CPY #$20; BNE $100d; INC $4000; BNE $1012; WAI
+  const uint8_t program[] = {0xa2, 0x10, 0xbd, 0x00, 0x20, 0x9d, 0x00, 0x30,
+                             0xca, 0x10, 0xf7, 0xa0, 0x00, 0xc8, 0xc0, 0x20,
+                             0xd0, 0xfb, 0xee, 0x00, 0x40, 0xd0, 0xfb, 0xcb};
+
+  // Single stepping never fuses instructions.
+  Load(0x1000, program);
+  uint8_t *stepped_mem = mem();
+  for (int i = 0; i <= 0x10; i++)
+    stepped_mem[0x2000 + i] = 0x80 + i;
+  cpu.SetRESPin(false);
+  while (!(cpu.program_address() == Address(0x0, 0x1017)))
+    ASSERT_TRUE(cpu.ExecuteNextInstruction());
+  const uint64_t cycles = cpu.total_cycles_counter();
+
+  // Whatever the budget, Run() has to stop where stepping would have.
+  for (uint64_t budget : {1, 2, 3, 5, 7, 1000}) {
+    RAMDevice run_memory(Address(0x0, 0x0), Address(0x0, 0xffff));
+    SystemBus run_bus;
+    run_bus.RegisterDevice(&run_memory);
+    uint8_t *run_mem = run_memory.region().mem;
+    memcpy(run_mem, stepped_mem, 0x10000);
+    memset(run_mem + 0x3000, 0, 0x11);
+    run_mem[0x4000] = 0;
+    Cpu65816 run(run_bus, &emulation_interrupts, &native_interrupts);
+    run.SetRESPin(false);
+    while (run.total_cycles_counter() < cycles)
+      run.Run(std::min(budget, cycles - run.total_cycles_counter()));
+    EXPECT_EQ(run.total_cycles_counter(), cycles) << budget;
+    EXPECT_EQ(run.program_address(), Address(0x0, 0x1017)) << budget;
+    EXPECT_EQ(run.a(), cpu.a()) << budget;
+    EXPECT_EQ(run.x(), cpu.x()) << budget;
+    EXPECT_EQ(run.y(), cpu.y()) << budget;
+    EXPECT_EQ(run.cpu_status()->register_value(),
+              cpu.cpu_status()->register_value())
+        << budget;
+    EXPECT_EQ(memcmp(run_mem, stepped_mem, 0x10000), 0) << budget;
+  }
+  EXPECT_EQ(stepped_mem[0x3010], 0x90);
+}
@@ -19,7 +19,6 @@
 
 #include "cpu/cpu_status.h"
 
-#include "cpu/binary.h"
 #include <glog/logging.h>
 
 /* **********************************************
@@ -58,7 +57,7 @@ uint8_t CpuStatus::register_value() const {
   uint8_t value = 0;
   if (carry_flag)
     value |= STATUS_CARRY;
-  if (zero_flag)
+  if (zero_flag())
     value |= STATUS_ZERO;
   if (interrupt_disable_flag)
     value |= STATUS_INTERRUPT_DISABLE;
@@ -72,7 +71,7 @@ uint8_t CpuStatus::register_value() const {
     value |= STATUS_ACCUMULATOR_WIDTH;
   if (overflow_flag)
     value |= STATUS_OVERFLOW;
-  if (sign_flag)
+  if (sign_flag())
     value |= STATUS_SIGN;
 
   return value;
@@ -83,7 +82,7 @@ void CpuStatus::resetPRegister(uint8_t value) {
     carry_flag = false;
 
   if (value & STATUS_ZERO)
-    zero_flag = false;
+    set_zero_flag(false);
 
   if (value & STATUS_INTERRUPT_DISABLE)
     interrupt_disable_flag = 0;
@@ -106,7 +105,7 @@ void CpuStatus::resetPRegister(uint8_t value) {
     overflow_flag = false;
 
   if (value & STATUS_SIGN)
-    sign_flag = false;
+    set_sign_flag(false);
 }
 
 void CpuStatus::setPRegister(uint8_t value) {
@@ -114,7 +113,7 @@ void CpuStatus::setPRegister(uint8_t value) {
     carry_flag = true;
 
   if (value & STATUS_ZERO)
-    zero_flag = true;
+    set_zero_flag(true);
 
   if (value & STATUS_INTERRUPT_DISABLE)
     interrupt_disable_flag = 1;
@@ -137,12 +136,11 @@ void CpuStatus::setPRegister(uint8_t value) {
     overflow_flag = true;
 
   if (value & STATUS_SIGN)
-    sign_flag = true;
+    set_sign_flag(true);
 }
 
 void CpuStatus::setRegisterValue(uint8_t value) {
   carry_flag = (value & STATUS_CARRY) != 0;
-  zero_flag = (value & STATUS_ZERO) != 0;
   interrupt_disable_flag = (value & STATUS_INTERRUPT_DISABLE) != 0;
   decimal_flag = (value & STATUS_DECIMAL) != 0;
 
@@ -156,43 +154,5 @@ void CpuStatus::setRegisterValue(uint8_t value) {
       !emulation_flag && (value & STATUS_ACCUMULATOR_WIDTH);
 
   overflow_flag = (value & STATUS_OVERFLOW) != 0;
-  sign_flag = (value & STATUS_SIGN) != 0;
-}
-
-void CpuStatus::updateZeroFlagFrom8BitValue(uint8_t value) {
-  if (Binary::is8bitValueZero(value))
-    zero_flag = true;
-  else
-    zero_flag = 0;
-}
-
-void CpuStatus::updateZeroFlagFrom16BitValue(uint16_t value) {
-  if (Binary::is16bitValueZero(value))
-    zero_flag = true;
-  else
-    zero_flag = 0;
-}
-
-void CpuStatus::updateSignFlagFrom8BitValue(uint8_t value) {
-  if (Binary::is8bitValueNegative(value))
-    sign_flag = true;
-  else
-    sign_flag = false;
-}
-
-void CpuStatus::updateSignFlagFrom16BitValue(uint16_t value) {
-  if (Binary::is16bitValueNegative(value))
-    sign_flag = true;
-  else
-    sign_flag = false;
-}
-
-void CpuStatus::updateSignAndZeroFlagFrom8BitValue(uint8_t value) {
-  updateSignFlagFrom8BitValue(value);
-  updateZeroFlagFrom8BitValue(value);
-}
-
-void CpuStatus::updateSignAndZeroFlagFrom16BitValue(uint16_t value) {
-  updateSignFlagFrom16BitValue(value);
-  updateZeroFlagFrom16BitValue(value);
+  setSignAndZeroFlags(value & STATUS_SIGN, value & STATUS_ZERO);
 }
@@ -28,15 +28,38 @@ struct CpuStatus {
   void setPRegister(uint8_t value);
   void setRegisterValue(uint8_t);
 
-  void updateZeroFlagFrom8BitValue(uint8_t);
-  void updateZeroFlagFrom16BitValue(uint16_t);
-  void updateSignFlagFrom8BitValue(uint8_t);
-  void updateSignFlagFrom16BitValue(uint16_t);
-  void updateSignAndZeroFlagFrom8BitValue(uint8_t);
-  void updateSignAndZeroFlagFrom16BitValue(uint16_t);
+  // N and Z are evaluated lazily: instructions only record the result they
+  // are derived from, and nothing is computed until somebody asks.
+  bool zero_flag() const { return (uint16_t)nz_result == 0; }
+  bool sign_flag() const { return (nz_result & nz_sign_mask) != 0; }
+  void set_zero_flag(bool value) { setSignAndZeroFlags(sign_flag(), value); }
+  void set_sign_flag(bool value) { setSignAndZeroFlags(value, zero_flag()); }
+
+  void updateZeroFlagFrom8BitValue(uint8_t value) { set_zero_flag(value == 0); }
+  void updateZeroFlagFrom16BitValue(uint16_t value) {
+    set_zero_flag(value == 0);
+  }
+  void updateSignFlagFrom8BitValue(uint8_t value) {
+    set_sign_flag(value & 0x80);
+  }
+  void updateSignFlagFrom16BitValue(uint16_t value) {
+    set_sign_flag(value & 0x8000);
+  }
+  void updateSignAndZeroFlagFrom8BitValue(uint8_t value) {
+    nz_result = value;
+    nz_sign_mask = 0x80;
+  }
+  void updateSignAndZeroFlagFrom16BitValue(uint16_t value) {
+    nz_result = value;
+    nz_sign_mask = 0x8000;
+  }
 
   bool carry_flag = false;
-  bool zero_flag = false;
+  // Last result N and Z were set from. Z is set when its low 16 bits are
+  // zero and N when it has any of the nz_sign_mask bits set; flags that were
+  // set explicitly are encoded with N in bit 16.
+  uint32_t nz_result = 1;
+  uint32_t nz_sign_mask = 0x80;
   bool interrupt_disable_flag = false;
   bool decimal_flag = false;
   bool break_flag = false;
@@ -44,7 +67,12 @@ struct CpuStatus {
   bool index_width_flag = false;
   bool emulation_flag = true;  // CPU Starts in emulation mode
   bool overflow_flag = false;
-  bool sign_flag = false;
+
+private:
+  void setSignAndZeroFlags(bool sign, bool zero) {
+    nz_result = (sign ? 0x10000 : 0) | (zero ? 0 : 1);
+    nz_sign_mask = 0x10000;
+  }
 };
 
 #endif  // CPUSTATUS_H
@@ -0,0 +1,112 @@
+#include "cpu/disassembler.h"
+
+#include <cstdio>
+
+#include "cpu/block_cache.h"
+#include "cpu/cpu_65816.h"
+
+std::string Disassemble(const uint8_t *bytes, uint32_t address,
+                        bool wide_accumulator, bool wide_index) {
+  const OpCode &op_code = Cpu65816::DescribeOpCode(bytes[0]);
+  const uint32_t length =
+      InstructionLength(op_code, wide_accumulator, wide_index);
+  const uint32_t operand8 = bytes[1];
+  const uint32_t operand16 = bytes[1] | bytes[2] << 8;
+  const uint32_t operand24 = operand16 | bytes[3] << 16;
+
+  char operand[32] = "";
+  switch (op_code.addressing_mode()) {
+  case AddressingMode::Implied:
+  case AddressingMode::StackImplied:
+    break;
+  case AddressingMode::Accumulator:
+    snprintf(operand, sizeof(operand), "A");
+    break;
+  case AddressingMode::Interrupt:
+    snprintf(operand, sizeof(operand), "#$%02x", operand8);
+    break;
+  case AddressingMode::Immediate:
+    if (length == 3)
+      snprintf(operand, sizeof(operand), "#$%04x", operand16);
+    else
+      snprintf(operand, sizeof(operand), "#$%02x", operand8);
+    break;
+  case AddressingMode::BlockMove:
+    // Assembled as source bank, destination bank; encoded the other way.
+    snprintf(operand, sizeof(operand), "$%02x,$%02x", bytes[2], bytes[1]);
+    break;
+  case AddressingMode::Absolute:
+  case AddressingMode::StackAbsolute:
+    snprintf(operand, sizeof(operand), "$%04x", operand16);
+    break;
+  case AddressingMode::AbsoluteLong:
+    snprintf(operand, sizeof(operand), "$%06x", operand24);
+    break;
+  case AddressingMode::AbsoluteIndirect:
+    snprintf(operand, sizeof(operand), "($%04x)", operand16);
+    break;
+  case AddressingMode::AbsoluteIndirectLong:
+    snprintf(operand, sizeof(operand), "[$%04x]", operand16);
+    break;
+  case AddressingMode::AbsoluteIndexedIndirectWithX:
+    snprintf(operand, sizeof(operand), "($%04x,X)", operand16);
+    break;
+  case AddressingMode::AbsoluteIndexedWithX:
+    snprintf(operand, sizeof(operand), "$%04x,X", operand16);
+    break;
+  case AddressingMode::AbsoluteLongIndexedWithX:
+    snprintf(operand, sizeof(operand), "$%06x,X", operand24);
+    break;
+  case AddressingMode::AbsoluteIndexedWithY:
+    snprintf(operand, sizeof(operand), "$%04x,Y", operand16);
+    break;
+  case AddressingMode::DirectPage:
+    snprintf(operand, sizeof(operand), "$%02x", operand8);
+    break;
+  case AddressingMode::DirectPageIndexedWithX:
+    snprintf(operand, sizeof(operand), "$%02x,X", operand8);
+    break;
+  case AddressingMode::DirectPageIndexedWithY:
+    snprintf(operand, sizeof(operand), "$%02x,Y", operand8);
+    break;
+  case AddressingMode::DirectPageIndirect:
+  case AddressingMode::StackDirectPageIndirect:
+    snprintf(operand, sizeof(operand), "($%02x)", operand8);
+    break;
+  case AddressingMode::DirectPageIndirectLong:
+    snprintf(operand, sizeof(operand), "[$%02x]", operand8);
+    break;
+  case AddressingMode::DirectPageIndexedIndirectWithX:
+    snprintf(operand, sizeof(operand), "($%02x,X)", operand8);
+    break;
+  case AddressingMode::DirectPageIndirectIndexedWithY:
+    snprintf(operand, sizeof(operand), "($%02x),Y", operand8);
+    break;
+  case AddressingMode::DirectPageIndirectLongIndexedWithY:
+    snprintf(operand, sizeof(operand), "[$%02x],Y", operand8);
+    break;
+  case AddressingMode::StackRelative:
+    snprintf(operand, sizeof(operand), "$%02x,S", operand8);
+    break;
+  case AddressingMode::StackRelativeIndirectIndexedWithY:
+    snprintf(operand, sizeof(operand), "($%02x,S),Y", operand8);
+    break;
+  case AddressingMode::ProgramCounterRelative:
+    // Branches stay within the bank, so only the offset is shown.
+    snprintf(operand, sizeof(operand), "$%04x",
+             (address + 2 + static_cast<int8_t>(operand8)) & 0xFFFF);
+    break;
+  case AddressingMode::ProgramCounterRelativeLong:
+  case AddressingMode::StackProgramCounterRelativeLong:
+    snprintf(operand, sizeof(operand), "$%04x",
+             (address + 3 + static_cast<int16_t>(operand16)) & 0xFFFF);
+    break;
+  }
+
+  std::string text = op_code.name();
+  if (operand[0]) {
+    text += ' ';
+    text += operand;
+  }
+  return text;
+}
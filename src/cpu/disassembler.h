@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Formats the instruction whose opcode is at |bytes|, e.g. "LDA $1234,X".
+// |address| is where it lives, for resolving branch targets, and the
+// register widths decide the size of immediate operands. |bytes| must hold
+// the whole instruction, at most four bytes.
+std::string Disassemble(const uint8_t *bytes, uint32_t address,
+                        bool wide_accumulator, bool wide_index);
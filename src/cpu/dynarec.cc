@@ -0,0 +1,928 @@
+#include "cpu/dynarec.h"
+
+#include <glog/logging.h>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#include "cpu/cpu_65816.h"
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(_WIN32)
+#define DYNAREC_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if DYNAREC_X86_64
+namespace {
+
+constexpr size_t kCodeBufferSize = 16 << 20;
+
+// Worst case for an instruction that goes through the interpreter. The
+// exceptions (block moves, interrupts) always end their block, and the last
+// instruction of a block is not counted.
+constexpr uint32_t kMaxHandlerCycles = 16;
+
+// x86 condition codes.
+enum : uint8_t {
+  kAboveOrEqual = 0x3,
+  kEqual = 0x4,
+  kNotEqual = 0x5,
+  kAbove = 0x7,
+};
+
+// x86 registers, by encoding.
+enum : int { kRax = 0, kRcx = 1, kRdx = 2, kRbx = 3, kRsi = 6, kRdi = 7 };
+
+// Just enough of an x86-64 assembler for the code below. Compiled code keeps
+// the Cpu65816 pointer in rbx and addresses its state relative to it.
+class Emitter {
+public:
+  Emitter(uint8_t *code, size_t capacity) : code_(code), capacity_(capacity) {}
+
+  size_t size() const { return size_; }
+
+  void Byte(uint8_t b) {
+    if (size_ < capacity_)
+      code_[size_] = b;
+    size_++;
+  }
+  void Bytes(std::initializer_list<uint8_t> bytes) {
+    for (uint8_t b : bytes)
+      Byte(b);
+  }
+  void Imm16(uint16_t v) {
+    Byte(v);
+    Byte(v >> 8);
+  }
+  void Imm32(uint32_t v) {
+    Imm16(v);
+    Imm16(v >> 16);
+  }
+  void Imm64(uint64_t v) {
+    Imm32(v);
+    Imm32(v >> 32);
+  }
+  void Imm64(const void *p) { Imm64(reinterpret_cast<uintptr_t>(p)); }
+
+  // ModRM byte and displacement for [rbx + disp].
+  void RbxDisp(int reg, int32_t disp) {
+    Byte(0x80 | (reg << 3) | kRbx);
+    Imm32(disp);
+  }
+
+  // Jumps are emitted with a 32-bit displacement to be filled in by Bind(),
+  // and identified by the offset just past them.
+  size_t Jcc(uint8_t cc) {
+    Bytes({0x0F, (uint8_t)(0x80 | cc)});
+    Imm32(0);
+    return size_;
+  }
+  size_t Jmp() {
+    Byte(0xE9);
+    Imm32(0);
+    return size_;
+  }
+  void Bind(size_t jump, size_t target) {
+    if (jump > capacity_)
+      return;
+    const uint32_t rel = (uint32_t)(target - jump);
+    memcpy(code_ + jump - 4, &rel, 4);
+  }
+  void Patch32(size_t at, uint32_t v) {
+    if (at + 4 <= capacity_)
+      memcpy(code_ + at, &v, 4);
+  }
+
+  void MovRegImm64(int reg, const void *p) {
+    Bytes({0x48, (uint8_t)(0xB8 + reg)});
+    Imm64(p);
+  }
+  void MovzxEaxByte(int32_t disp) {
+    Bytes({0x0F, 0xB6});
+    RbxDisp(kRax, disp);
+  }
+  void MovzxEaxWord(int32_t disp) {
+    Bytes({0x0F, 0xB7});
+    RbxDisp(kRax, disp);
+  }
+  void MovzxEcxByte(int32_t disp) {
+    Bytes({0x0F, 0xB6});
+    RbxDisp(kRcx, disp);
+  }
+  void MovzxEcxWord(int32_t disp) {
+    Bytes({0x0F, 0xB7});
+    RbxDisp(kRcx, disp);
+  }
+  void StoreEax(int32_t disp) {
+    Byte(0x89);
+    RbxDisp(kRax, disp);
+  }
+  void StoreAl(int32_t disp) {
+    Byte(0x88);
+    RbxDisp(kRax, disp);
+  }
+  void StoreAx(int32_t disp) {
+    Bytes({0x66, 0x89});
+    RbxDisp(kRax, disp);
+  }
+  void MovByteImm(int32_t disp, uint8_t v) {
+    Byte(0xC6);
+    RbxDisp(0, disp);
+    Byte(v);
+  }
+  void MovDwordImm(int32_t disp, uint32_t v) {
+    Byte(0xC7);
+    RbxDisp(0, disp);
+    Imm32(v);
+  }
+  void MovWordImm(int32_t disp, uint16_t v) {
+    Bytes({0x66, 0xC7});
+    RbxDisp(0, disp);
+    Imm16(v);
+  }
+  void Setcc(uint8_t cc, int32_t disp) {
+    Bytes({0x0F, (uint8_t)(0x90 | cc)});
+    RbxDisp(0, disp);
+  }
+  void AddQwordImm(int32_t disp, uint32_t v) {
+    Bytes({0x48, 0x81});
+    RbxDisp(0, disp);
+    Imm32(v);
+  }
+  void CmpByteImm(int32_t disp, uint8_t v) {
+    Byte(0x80);
+    RbxDisp(7, disp);
+    Byte(v);
+  }
+  void CmpWordImm(int32_t disp, uint16_t v) {
+    Bytes({0x66, 0x81});
+    RbxDisp(7, disp);
+    Imm16(v);
+  }
+  // inc (ext 0) or dec (ext 1) of a byte or word.
+  void IncDec(int ext, bool wide, int32_t disp) {
+    if (wide)
+      Bytes({0x66, 0xFF});
+    else
+      Byte(0xFE);
+    RbxDisp(ext, disp);
+  }
+  // and (ext 4), or (ext 1), xor (ext 6) of a byte or word with an immediate.
+  void AluImm(int ext, bool wide, int32_t disp, uint16_t v) {
+    if (wide) {
+      Bytes({0x66, 0x81});
+      RbxDisp(ext, disp);
+      Imm16(v);
+    } else {
+      Byte(0x80);
+      RbxDisp(ext, disp);
+      Byte(v);
+    }
+  }
+
+private:
+  uint8_t *code_;
+  size_t capacity_;
+  size_t size_ = 0;
+};
+
+// Address of the function behind a non-virtual member function pointer, as
+// laid out by the Itanium C++ ABI.
+bool HandlerAddress(OpCode::Executor executor, const void **address) {
+  struct {
+    uintptr_t ptr;
+    ptrdiff_t adj;
+  } mfp;
+  static_assert(sizeof(mfp) == sizeof(executor),
+                "unexpected member function pointer layout");
+  if (!executor)
+    return false;
+  memcpy(&mfp, &executor, sizeof(mfp));
+  if ((mfp.ptr & 1) || mfp.adj)
+    return false;
+  *address = reinterpret_cast<const void *>(mfp.ptr);
+  return true;
+}
+
+} // namespace
+#endif // DYNAREC_X86_64
+
+struct Dynarec::State {
+  uint16_t a, x, y, dp, sp;
+  uint8_t db, p;
+  bool emulation;
+  uint32_t pc;
+  uint64_t cycles;
+
+  bool operator==(const State &o) const {
+    return a == o.a && x == o.x && y == o.y && dp == o.dp && sp == o.sp &&
+           db == o.db && p == o.p && emulation == o.emulation && pc == o.pc &&
+           cycles == o.cycles;
+  }
+};
+
+// static
+bool Dynarec::IsSupported() {
+#if DYNAREC_X86_64
+  return true;
+#else
+  return false;
+#endif
+}
+
+Dynarec::Dynarec(Cpu65816 *cpu, Mode mode) : cpu_(cpu), mode_(mode) {
+#if DYNAREC_X86_64
+  void *code =
+      mmap(nullptr, kCodeBufferSize, PROT_READ | PROT_EXEC,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED) {
+    LOG(ERROR) << "Unable to map dynarec code buffer, dynarec disabled";
+    return;
+  }
+  code_ = static_cast<uint8_t *>(code);
+  code_capacity_ = kCodeBufferSize;
+  // Grows to fit bigger blocks.
+  scratch_.resize(4096);
+#endif
+}
+
+Dynarec::~Dynarec() {
+#if DYNAREC_X86_64
+  if (code_)
+    munmap(code_, code_capacity_);
+#endif
+}
+
+bool Dynarec::Install(size_t offset, const uint8_t *code, size_t size) {
+#if DYNAREC_X86_64
+  // Only the pages the code lands on are made writable, and never while
+  // they are executable.
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t first =
+      reinterpret_cast<uintptr_t>(code_ + offset) & ~(page_size - 1);
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(code_ + offset + size) + page_size - 1) &
+      ~(page_size - 1);
+  void *pages = reinterpret_cast<void *>(first);
+  if (mprotect(pages, end - first, PROT_READ | PROT_WRITE) == 0) {
+    memcpy(code_ + offset, code, size);
+    if (mprotect(pages, end - first, PROT_READ | PROT_EXEC) == 0)
+      return true;
+  }
+  LOG(ERROR) << "Unable to protect dynarec code buffer, dynarec disabled";
+  cpu_->block_cache_.ForgetCompiledCode();
+  munmap(code_, code_capacity_);
+  code_ = nullptr;
+#endif
+  return false;
+}
+
+void Dynarec::Compile(DecodedBlock *block) {
+  // Generated aside first, as the size is only known once it has been.
+  size_t size = 0;
+  bool compiled = code_ && CompileInto(block, scratch_.data(),
+                                       scratch_.size(), &size);
+  if (code_ && !compiled && size > scratch_.size()) {
+    scratch_.resize(size);
+    compiled = CompileInto(block, scratch_.data(), scratch_.size(), &size);
+  }
+  if (compiled && size > code_capacity_ - code_used_) {
+    // Out of room: throw all compiled code away and start over.
+    cpu_->block_cache_.ForgetCompiledCode();
+    code_used_ = 0;
+    compiled = size <= code_capacity_;
+  }
+  if (compiled)
+    compiled = Install(code_used_, scratch_.data(), size);
+  if (!compiled) {
+    block->compile_failed = true;
+    return;
+  }
+  block->compiled = reinterpret_cast<void (*)(Cpu65816 *)>(code_ + code_used_);
+  code_used_ += size;
+}
+
+bool Dynarec::CompileInto(DecodedBlock *block, uint8_t *buffer,
+                          size_t capacity, size_t *size) {
+#if DYNAREC_X86_64
+  Cpu65816 &cpu = *cpu_;
+  SystemBus &bus = cpu.system_bus_;
+  const auto disp = [&cpu](const void *p) {
+    return (int32_t)(reinterpret_cast<const char *>(p) -
+                     reinterpret_cast<const char *>(&cpu));
+  };
+  const int32_t a = disp(&cpu.a_);
+  const int32_t x = disp(&cpu.x_);
+  const int32_t y = disp(&cpu.y_);
+  const int32_t db = disp(&cpu.db_);
+  const int32_t pc = disp(&cpu.program_address_.offset_);
+  const int32_t pbr = disp(&cpu.program_address_.bank_);
+  const int32_t cycles = disp(&cpu.total_cycles_counter_);
+  const int32_t end_cycles = disp(&cpu.run_end_cycles_);
+  const int32_t events = disp(&cpu.events_pending_);
+  const int32_t micro_op = disp(&cpu.micro_op_);
+  const int32_t carry = disp(&cpu.cpu_status_.carry_flag);
+  const int32_t nz_result = disp(&cpu.cpu_status_.nz_result);
+  const int32_t nz_sign_mask = disp(&cpu.cpu_status_.nz_sign_mask);
+  const int32_t decimal = disp(&cpu.cpu_status_.decimal_flag);
+  const int32_t overflow = disp(&cpu.cpu_status_.overflow_flag);
+
+  int cpu_mode = 0;
+  while (cpu_mode < kNumCpuModes &&
+         Cpu65816::kOpCodeTables[cpu_mode] != block->op_code_table)
+    cpu_mode++;
+  if (cpu_mode == kNumCpuModes)
+    return false;
+  const bool emulation = cpu_mode == kModeEmulation;
+  const bool wide_a =
+      cpu_mode == kModeNativeM16X16 || cpu_mode == kModeNativeM16X8;
+  const bool wide_x =
+      cpu_mode == kModeNativeM16X16 || cpu_mode == kModeNativeM8X16;
+  const uint8_t bank = block->address >> 16;
+  const uint16_t start = block->address & 0xFFFF;
+  const bool verify = mode_ == Mode::kVerify;
+
+  Emitter e(buffer, capacity);
+  // Exits taken before an instruction, to let the interpreter run it.
+  std::vector<std::pair<size_t, uint16_t>> exits_before;
+  // Exits taken with the PC already up to date.
+  std::vector<size_t> exits;
+  // Places to patch with the final max_cycles.
+  std::vector<size_t> max_cycles_patches;
+
+  // push rbx; mov rbx, rdi
+  e.Bytes({0x53, 0x48, 0x89, 0xFB});
+  const size_t loop_start = e.size();
+
+  // Records the zero extended result in eax for the lazy N and Z flags.
+  const auto set_nz = [&](bool wide) {
+    e.StoreEax(nz_result);
+    e.MovDwordImm(nz_sign_mask, wide ? 0x8000 : 0x80);
+  };
+  const auto set_nz_from = [&](int32_t reg, bool wide) {
+    if (wide)
+      e.MovzxEaxWord(reg);
+    else
+      e.MovzxEaxByte(reg);
+    set_nz(wide);
+  };
+  const auto set_nz_constant = [&](bool wide, uint16_t v) {
+    e.MovDwordImm(nz_result, wide ? v : v & 0xFF);
+    e.MovDwordImm(nz_sign_mask, wide ? 0x8000 : 0x80);
+  };
+  const auto add_cycles = [&](uint32_t n) { e.AddQwordImm(cycles, n); };
+  const auto count_op = [&]() {
+    if (verify) {
+      e.MovRegImm64(kRax, &ops_executed_);
+      e.Bytes({0xFF, 0x00}); // inc dword [rax]
+    }
+  };
+
+  // Leaves eax = (bank << 16) | (offset + index), with the bank carried the
+  // way Address::SumOffsetToAddressNoWrapAround does, and ecx = the 16-bit
+  // offset sum.
+  const auto indexed_address = [&](int32_t bank_disp, uint16_t offset,
+                                   int32_t index, bool wide_index) {
+    if (wide_index) {
+      e.MovzxEcxWord(index);
+      e.Bytes({0x0F, 0xBF, 0xC9}); // movsx ecx, cx
+    } else {
+      e.MovzxEcxByte(index);
+    }
+    e.Byte(0xBA); // mov edx, offset
+    e.Imm32(offset);
+    e.Bytes({0x01, 0xCA}); // add edx, ecx
+    e.MovzxEaxByte(bank_disp);
+    e.Bytes({0x81, 0xFA}); // cmp edx, 0x10000
+    e.Imm32(0x10000);
+    e.Bytes({0x72, 0x02}); // jb +2
+    e.Bytes({0xFE, 0xC0}); // inc al
+    e.Bytes({0x0F, 0xB6, 0xC0}); // movzx eax, al
+    e.Bytes({0xC1, 0xE0, 0x10}); // shl eax, 16
+    e.Bytes({0x0F, 0xB7, 0xCA}); // movzx ecx, dx
+    e.Bytes({0x09, 0xC8}); // or eax, ecx
+  };
+  const auto absolute_address = [&](uint16_t offset) {
+    e.MovzxEaxByte(db);
+    e.Bytes({0xC1, 0xE0, 0x10}); // shl eax, 16
+    e.Byte(0x0D);                // or eax, offset
+    e.Imm32(offset);
+  };
+
+  // With the guest address in eax, leaves rdx pointing at its host memory,
+  // or exits before the instruction if it is not plain RAM.
+  const auto host_pointer = [&](uint16_t op_pc, uint32_t size, bool store) {
+    if (verify && store) {
+      e.MovRegImm64(kRdi, this);
+      e.Bytes({0x89, 0xC6}); // mov esi, eax
+      e.Byte(0xBA);          // mov edx, size
+      e.Imm32(size);
+      e.MovRegImm64(kRax, reinterpret_cast<const void *>(&JournalStore));
+      e.Bytes({0xFF, 0xD0}); // call rax, which returns the address
+    }
+    if (store) {
+      // Stores to code pages go through the bus so they invalidate blocks.
+      e.Bytes({0x89, 0xC1});       // mov ecx, eax
+      e.Bytes({0xC1, 0xE9, 0x08}); // shr ecx, 8
+      e.MovRegImm64(kRsi, bus.code_page_watched_);
+      e.Bytes({0x80, 0x3C, 0x0E, 0x00}); // cmp byte [rsi + rcx], 0
+      exits_before.push_back({e.Jcc(kNotEqual), op_pc});
+      if (size > 1) {
+        e.Bytes({0x89, 0xC1});             // mov ecx, eax
+        e.Bytes({0x81, 0xE1});             // and ecx, 0xFF
+        e.Imm32(0xFF);
+        e.Bytes({0x81, 0xF9}); // cmp ecx, 0x100 - size
+        e.Imm32(0x100 - size);
+        exits_before.push_back({e.Jcc(kAbove), op_pc});
+      }
+    }
+    e.Bytes({0x89, 0xC1});       // mov ecx, eax
+    e.Bytes({0xC1, 0xE9, 0x0C}); // shr ecx, 12
+    e.Bytes({0x69, 0xC9});       // imul ecx, ecx, sizeof(Page)
+    e.Imm32(sizeof(SystemBus::Page));
+    e.MovRegImm64(kRdx, &bus.pages_[0].mem);
+    e.Bytes({0x48, 0x8B, 0x14, 0x0A}); // mov rdx, [rdx + rcx]
+    e.Bytes({0x48, 0x85, 0xD2});       // test rdx, rdx
+    exits_before.push_back({e.Jcc(kEqual), op_pc});
+    e.Bytes({0x89, 0xC1}); // mov ecx, eax
+    e.Bytes({0x81, 0xE1}); // and ecx, kPageMask
+    e.Imm32(SystemBus::kPageMask);
+    e.Bytes({0x81, 0xF9}); // cmp ecx, kPageSize - size
+    e.Imm32(SystemBus::kPageSize - size);
+    exits_before.push_back({e.Jcc(kAbove), op_pc});
+    e.Bytes({0x48, 0x01, 0xCA}); // add rdx, rcx
+  };
+  // Loads the byte or word at guest address eax into eax.
+  const auto load = [&](uint16_t op_pc, bool wide) {
+    host_pointer(op_pc, wide ? 2 : 1, false);
+    if (wide)
+      e.Bytes({0x0F, 0xB7, 0x02}); // movzx eax, word [rdx]
+    else
+      e.Bytes({0x0F, 0xB6, 0x02}); // movzx eax, byte [rdx]
+  };
+  // Stores a register (or zero if 'source' is negative) to guest address
+  // eax.
+  const auto store = [&](uint16_t op_pc, bool wide, int32_t source) {
+    host_pointer(op_pc, wide ? 2 : 1, true);
+    if (source < 0) {
+      if (wide)
+        e.Bytes({0x66, 0xC7, 0x02, 0x00, 0x00}); // mov word [rdx], 0
+      else
+        e.Bytes({0xC6, 0x02, 0x00}); // mov byte [rdx], 0
+      return;
+    }
+    if (wide) {
+      e.MovzxEcxWord(source);
+      e.Bytes({0x66, 0x89, 0x0A}); // mov [rdx], cx
+    } else {
+      e.MovzxEcxByte(source);
+      e.Bytes({0x88, 0x0A}); // mov [rdx], cl
+    }
+  };
+  // Writes a loaded value in eax to a register.
+  const auto set_register = [&](int32_t reg, bool wide) {
+    if (wide)
+      e.StoreAx(reg);
+    else
+      e.StoreAl(reg);
+    set_nz(wide);
+  };
+  // Compares a register with the value in ecx.
+  const auto compare = [&](int32_t reg, bool wide) {
+    if (wide) {
+      e.MovzxEaxWord(reg);
+      e.Bytes({0x66, 0x29, 0xC8}); // sub ax, cx
+      e.Setcc(kAboveOrEqual, carry);
+      e.Bytes({0x0F, 0xB7, 0xC0}); // movzx eax, ax
+    } else {
+      e.MovzxEaxByte(reg);
+      e.Bytes({0x28, 0xC8}); // sub al, cl
+      e.Setcc(kAboveOrEqual, carry);
+      e.Bytes({0x0F, 0xB6, 0xC0}); // movzx eax, al
+    }
+    set_nz(wide);
+  };
+
+  std::vector<uint32_t> op_max_cycles;
+  bool pc_in_sync = true;
+  bool ended = false;
+  int i = 0;
+  for (; i < block->size && !ended; i++) {
+    const MicroOp &op = block->ops[i];
+    const uint16_t op_pc = op.address & 0xFFFF;
+    const uint16_t next_pc =
+        (i + 1 < block->size ? block->ops[i + 1].address : block->end_address) &
+        0xFFFF;
+    const uint16_t operand16 = op.operand & 0xFFFF;
+    const uint8_t code = op.op_code->code();
+    uint32_t max_cycles = 0;
+    // Cycles taken conditionally, and already accounted for by the code.
+    uint32_t variable_cycles = 0;
+    bool translated = true;
+
+    switch (code) {
+    case 0x18: // CLC
+    case 0x38: // SEC
+      e.MovByteImm(carry, code == 0x38);
+      max_cycles = 2;
+      break;
+    case 0xD8: // CLD
+    case 0xF8: // SED
+      e.MovByteImm(decimal, code == 0xF8);
+      max_cycles = 2;
+      break;
+    case 0xB8: // CLV
+      e.MovByteImm(overflow, 0);
+      max_cycles = 2;
+      break;
+    case 0xEA: // NOP
+      max_cycles = 2;
+      break;
+    case 0xE8: // INX
+    case 0xCA: // DEX
+    case 0xC8: // INY
+    case 0x88: // DEY
+    case 0x1A: // INC A
+    case 0x3A: // DEC A
+    {
+      const bool wide = (code == 0x1A || code == 0x3A) ? wide_a : wide_x;
+      const int32_t reg = (code == 0x1A || code == 0x3A) ? a
+                          : (code == 0xE8 || code == 0xCA) ? x
+                                                           : y;
+      e.IncDec((code == 0xCA || code == 0x88 || code == 0x3A) ? 1 : 0, wide,
+               reg);
+      set_nz_from(reg, wide);
+      max_cycles = 2;
+      break;
+    }
+    case 0xAA: // TAX
+    case 0xA8: // TAY
+    case 0x9B: // TXY
+    case 0xBB: // TYX
+    {
+      const int32_t from = (code == 0x9B) ? x : (code == 0xBB) ? y : a;
+      const int32_t to = (code == 0xAA || code == 0xBB) ? x : y;
+      if (wide_x)
+        e.MovzxEaxWord(from);
+      else
+        e.MovzxEaxByte(from);
+      set_register(to, wide_x);
+      max_cycles = 2;
+      break;
+    }
+    case 0x8A: // TXA
+    case 0x98: // TYA
+    {
+      const int32_t from = code == 0x8A ? x : y;
+      if (!wide_a) {
+        e.MovzxEaxByte(from);
+        set_register(a, false);
+      } else if (!wide_x) {
+        e.MovzxEaxByte(from);
+        e.StoreAx(a);
+        set_nz(false);
+      } else {
+        e.MovzxEaxWord(from);
+        set_register(a, true);
+      }
+      max_cycles = 2;
+      break;
+    }
+    case 0xA9: // LDA #
+    case 0xA2: // LDX #
+    case 0xA0: // LDY #
+    {
+      const bool wide = code == 0xA9 ? wide_a : wide_x;
+      const int32_t reg = code == 0xA9 ? a : code == 0xA2 ? x : y;
+      if (wide)
+        e.MovWordImm(reg, operand16);
+      else
+        e.MovByteImm(reg, operand16 & 0xFF);
+      set_nz_constant(wide, operand16);
+      max_cycles = 2 + wide;
+      break;
+    }
+    case 0xC9: // CMP #
+    case 0xE0: // CPX #
+    case 0xC0: // CPY #
+    {
+      const bool wide = code == 0xC9 ? wide_a : wide_x;
+      e.Byte(0xB9); // mov ecx, operand
+      e.Imm32(wide ? operand16 : operand16 & 0xFF);
+      compare(code == 0xC9 ? a : code == 0xE0 ? x : y, wide);
+      max_cycles = 2 + wide;
+      break;
+    }
+    case 0x29: // AND #
+    case 0x09: // ORA #
+    case 0x49: // EOR #
+      e.AluImm(code == 0x29 ? 4 : code == 0x09 ? 1 : 6, wide_a, a,
+               wide_a ? operand16 : operand16 & 0xFF);
+      set_nz_from(a, wide_a);
+      max_cycles = 2 + wide_a;
+      break;
+    case 0xAD: // LDA abs
+    case 0xAE: // LDX abs
+    case 0xAC: // LDY abs
+    {
+      const bool wide = code == 0xAD ? wide_a : wide_x;
+      absolute_address(operand16);
+      load(op_pc, wide);
+      set_register(code == 0xAD ? a : code == 0xAE ? x : y, wide);
+      max_cycles = 4 + wide;
+      break;
+    }
+    case 0xCD: // CMP abs
+    case 0xEC: // CPX abs
+    case 0xCC: // CPY abs
+    {
+      const bool wide = code == 0xCD ? wide_a : wide_x;
+      absolute_address(operand16);
+      load(op_pc, wide);
+      e.Bytes({0x89, 0xC1}); // mov ecx, eax
+      compare(code == 0xCD ? a : code == 0xEC ? x : y, wide);
+      max_cycles = 4 + wide;
+      break;
+    }
+    case 0x8D: // STA abs
+    case 0x8E: // STX abs
+    case 0x8C: // STY abs
+    case 0x9C: // STZ abs
+    {
+      // executeSTY goes by the accumulator width, so this does too.
+      const bool wide = code == 0x8E ? wide_x : wide_a;
+      absolute_address(operand16);
+      store(op_pc, wide,
+            code == 0x8D ? a : code == 0x8E ? x : code == 0x8C ? y : -1);
+      max_cycles = 4 + wide;
+      break;
+    }
+    case 0xBD: // LDA abs,X
+    case 0xB9: // LDA abs,Y
+    {
+      indexed_address(db, operand16, code == 0xBD ? x : y, wide_x);
+      e.Bytes({0x89, 0xCF});       // mov edi, ecx
+      e.Bytes({0xC1, 0xEF, 0x08}); // shr edi, 8
+      load(op_pc, wide_a);
+      set_register(a, wide_a);
+      // One more cycle when the index crosses a page.
+      e.Bytes({0x81, 0xFF}); // cmp edi, operand >> 8
+      e.Imm32(operand16 >> 8);
+      const size_t same_page = e.Jcc(kEqual);
+      add_cycles(1);
+      e.Bind(same_page, e.size());
+      max_cycles = 5 + wide_a;
+      variable_cycles = 1;
+      break;
+    }
+    case 0x9D: // STA abs,X
+    case 0x99: // STA abs,Y
+      indexed_address(db, operand16, code == 0x9D ? x : y, wide_x);
+      store(op_pc, wide_a, a);
+      max_cycles = 5 + wide_a;
+      break;
+    case 0xAF: // LDA long
+      e.Byte(0xB8); // mov eax, operand
+      e.Imm32(op.operand);
+      load(op_pc, wide_a);
+      set_register(a, wide_a);
+      max_cycles = 5 + wide_a;
+      break;
+    case 0x8F: // STA long
+      e.Byte(0xB8); // mov eax, operand
+      e.Imm32(op.operand);
+      store(op_pc, wide_a, a);
+      max_cycles = 5 + wide_a;
+      break;
+    case 0xD0: // BNE
+    case 0xF0: // BEQ
+    case 0x90: // BCC
+    case 0xB0: // BCS
+    case 0x10: // BPL
+    case 0x30: // BMI
+    case 0x50: // BVC
+    case 0x70: // BVS
+    case 0x80: // BRA
+    {
+      const uint16_t target = op_pc + 2 + (int8_t)op.operand;
+      const uint32_t taken_cycles =
+          3 + (emulation && (op_pc >> 8) != (target >> 8));
+      count_op();
+      size_t not_taken = 0;
+      if (code != 0x80) {
+        // Leaves ZF set if the flag is set (Z) or clear (everything else).
+        bool zf_if_set = false;
+        if (code == 0xD0 || code == 0xF0) {
+          e.CmpWordImm(nz_result, 0);
+          zf_if_set = true;
+        } else if (code == 0x10 || code == 0x30) {
+          e.Bytes({0x8B}); // mov eax, nz_result
+          e.RbxDisp(kRax, nz_result);
+          e.Bytes({0x85}); // test nz_sign_mask, eax
+          e.RbxDisp(kRax, nz_sign_mask);
+        } else {
+          e.CmpByteImm((code == 0x90 || code == 0xB0) ? carry : overflow, 0);
+        }
+        // Odd rows (BEQ, BCS, BMI, BVS) branch when the flag is set.
+        const bool branch_if_set = code & 0x20;
+        not_taken = e.Jcc(branch_if_set == zf_if_set ? kNotEqual : kEqual);
+      }
+      add_cycles(taken_cycles);
+      e.MovWordImm(pc, target);
+      if (target == start) {
+        // Go round again while nothing needs the interpreter's attention.
+        e.CmpByteImm(events, 0);
+        exits.push_back(e.Jcc(kNotEqual));
+        e.Bytes({0x48, 0x8B}); // mov rax, cycles
+        e.RbxDisp(kRax, cycles);
+        e.Bytes({0x48, 0x05}); // add rax, max_cycles
+        max_cycles_patches.push_back(e.size());
+        e.Imm32(0);
+        e.Bytes({0x48, 0x3B}); // cmp rax, end_cycles
+        e.RbxDisp(kRax, end_cycles);
+        exits.push_back(e.Jcc(kAboveOrEqual));
+        e.Bind(e.Jmp(), loop_start);
+      } else {
+        exits.push_back(e.Jmp());
+      }
+      if (code == 0x80) {
+        ended = true;
+      } else {
+        e.Bind(not_taken, e.size());
+        add_cycles(2);
+      }
+      max_cycles = 4;
+      variable_cycles = 4;
+      break;
+    }
+    default:
+      translated = false;
+      break;
+    }
+
+    if (!translated) {
+      const void *handler;
+      if (verify || !HandlerAddress(op.op_code->executor(), &handler))
+        break;
+      if (!pc_in_sync)
+        e.MovWordImm(pc, op_pc);
+      // Point micro_op_ at the predecoded operand and call the handler.
+      e.MovRegImm64(kRax, &op);
+      e.Bytes({0x48, 0x89});
+      e.RbxDisp(kRax, micro_op);
+      e.Bytes({0x48, 0x89, 0xDF}); // mov rdi, rbx
+      e.MovRegImm64(kRsi, op.op_code);
+      e.MovRegImm64(kRax, handler);
+      e.Bytes({0xFF, 0xD0}); // call rax
+      if (i + 1 < block->size) {
+        // Leave if the handler jumped, touched this code or raised an event.
+        e.CmpWordImm(pc, next_pc);
+        exits.push_back(e.Jcc(kNotEqual));
+        e.CmpByteImm(pbr, bank);
+        exits.push_back(e.Jcc(kNotEqual));
+        e.MovRegImm64(kRax, &bus.code_page_generation_
+                                 [block->address >> SystemBus::kCodePageBits]);
+        e.Bytes({0x81, 0x38}); // cmp dword [rax], generation
+        e.Imm32(block->generation);
+        exits.push_back(e.Jcc(kNotEqual));
+        e.CmpByteImm(events, 0);
+        exits.push_back(e.Jcc(kNotEqual));
+      } else {
+        ended = true;
+      }
+      pc_in_sync = true;
+      op_max_cycles.push_back(kMaxHandlerCycles);
+      continue;
+    }
+
+    if (max_cycles > variable_cycles) {
+      add_cycles(max_cycles - variable_cycles);
+      count_op();
+    }
+    pc_in_sync = false;
+    op_max_cycles.push_back(max_cycles);
+  }
+  if (op_max_cycles.empty())
+    return false;
+
+  if (!ended) {
+    // Fell off the end of what could be compiled.
+    const uint32_t next = i < block->size ? block->ops[i].address
+                                          : block->end_address;
+    if (!pc_in_sync)
+      e.MovWordImm(pc, next & 0xFFFF);
+  }
+  const size_t epilogue = e.size();
+  e.Bytes({0x5B, 0xC3}); // pop rbx; ret
+  for (const auto &exit : exits_before) {
+    e.Bind(exit.first, e.size());
+    e.MovWordImm(pc, exit.second);
+    e.Bind(e.Jmp(), epilogue);
+  }
+  for (size_t exit : exits)
+    e.Bind(exit, epilogue);
+
+  uint32_t max_cycles = 0;
+  for (size_t j = 0; j + 1 < op_max_cycles.size(); j++)
+    max_cycles += op_max_cycles[j];
+  for (size_t at : max_cycles_patches)
+    e.Patch32(at, max_cycles);
+  block->max_cycles = max_cycles;
+
+  *size = e.size();
+  return e.size() <= capacity;
+#else
+  return false;
+#endif
+}
+
+void Dynarec::Execute(DecodedBlock *block) {
+  if (mode_ == Mode::kVerify) {
+    Verify(block);
+    return;
+  }
+  block->compiled(cpu_);
+}
+
+// static
+uint32_t Dynarec::JournalStore(Dynarec *dynarec, uint32_t address,
+                               uint32_t size) {
+  const uint8_t *mem = dynarec->cpu_->system_bus_.DirectPointer(address, size);
+  if (mem) {
+    for (uint32_t i = 0; i < size; i++)
+      dynarec->journal_.push_back({address + i, mem[i]});
+  }
+  return address;
+}
+
+Dynarec::State Dynarec::Capture() const {
+  const Cpu65816 &cpu = *cpu_;
+  State state;
+  state.a = cpu.a_;
+  state.x = cpu.x_;
+  state.y = cpu.y_;
+  state.dp = cpu.dp_;
+  state.sp = cpu.stack_.stack_pointer();
+  state.db = cpu.db_;
+  state.p = cpu.cpu_status_.register_value();
+  state.emulation = cpu.cpu_status_.emulation_flag;
+  state.pc = cpu.program_address_.AsInt();
+  state.cycles = cpu.total_cycles_counter_;
+  return state;
+}
+
+void Dynarec::Verify(DecodedBlock *block) {
+  Cpu65816 &cpu = *cpu_;
+  SystemBus &bus = cpu.system_bus_;
+  const State before = Capture();
+  journal_.clear();
+  ops_executed_ = 0;
+  block->compiled(cpu_);
+  const State compiled = Capture();
+
+  // Note what the compiled code wrote, then put memory back the way it was.
+  std::vector<JournalEntry> written;
+  for (const JournalEntry &entry : journal_)
+    written.push_back({entry.address, *bus.DirectPointer(entry.address, 1)});
+  for (auto it = journal_.rbegin(); it != journal_.rend(); ++it)
+    *bus.DirectPointer(it->address, 1) = it->value;
+
+  // Only flags and the registers below are touched by translated code.
+  cpu.a_ = before.a;
+  cpu.x_ = before.x;
+  cpu.y_ = before.y;
+  cpu.cpu_status_.setRegisterValue(before.p);
+  // The op code table follows the M and X flags just restored.
+  cpu.updateOpCodeTable();
+  cpu.program_address_ = Address(before.pc >> 16, before.pc & 0xFFFF);
+  cpu.total_cycles_counter_ = before.cycles;
+
+  for (uint32_t i = 0; i < ops_executed_; i++)
+    cpu.ExecuteNextInstruction();
+
+  const State interpreted = Capture();
+  bool match = compiled == interpreted;
+  for (const JournalEntry &entry : written)
+    match &= *bus.DirectPointer(entry.address, 1) == entry.value;
+  if (match)
+    return;
+
+  LOG(ERROR) << std::hex << "Dynarec mismatch in block at " << block->address
+             << " after " << std::dec << ops_executed_ << " instructions";
+  const auto log = [](const char *name, const State &s) {
+    LOG(ERROR) << std::hex << name << ": pc=" << s.pc << " a=" << s.a
+               << " x=" << s.x << " y=" << s.y << " sp=" << s.sp
+               << " dp=" << s.dp << " db=" << (int)s.db << " p=" << (int)s.p
+               << " e=" << s.emulation << std::dec << " cycles=" << s.cycles;
+  };
+  log("before", before);
+  log("compiled", compiled);
+  log("interpreted", interpreted);
+  for (const JournalEntry &entry : written) {
+    LOG(ERROR) << std::hex << "store " << entry.address << ": compiled "
+               << (int)entry.value << " interpreted "
+               << (int)*bus.DirectPointer(entry.address, 1);
+  }
+  LOG(FATAL) << "Dynarec verification failed";
+}
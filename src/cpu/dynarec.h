@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpu/block_cache.h"
+
+class Cpu65816;
+
+// Translates hot DecodedBlocks into x86-64 code.
+//
+// Simple loads, stores, register and flag operations and branches are
+// translated directly, with RAM accesses going through the SystemBus page
+// table. Everything else is compiled into a direct call to the interpreter's
+// handler. Accesses to anything other than plain RAM, and stores to pages
+// holding decoded code, leave the compiled code before the instruction so
+// that the interpreter performs them.
+//
+// In kVerify mode only directly translated instructions are compiled, and
+// every block run is replayed through the interpreter and compared.
+class Dynarec {
+public:
+  enum class Mode { kOff, kOn, kVerify };
+
+  // Number of times a block has to be entered before it gets compiled.
+  static constexpr uint32_t kDefaultHotThreshold = 64;
+
+  // Whether this build can generate code for the host.
+  static bool IsSupported();
+
+  Dynarec(Cpu65816 *cpu, Mode mode);
+  ~Dynarec();
+
+  Mode mode() const { return mode_; }
+
+  // Compiles 'block', leaving block->compiled unset if nothing in it could
+  // be compiled.
+  void Compile(DecodedBlock *block);
+
+  // Runs a compiled block.
+  void Execute(DecodedBlock *block);
+
+private:
+  struct JournalEntry {
+    uint32_t address;
+    uint8_t value;
+  };
+  struct State;
+
+  static uint32_t JournalStore(Dynarec *dynarec, uint32_t address,
+                               uint32_t size);
+
+  // Copies 'size' bytes of generated code to 'offset' in the code buffer.
+  bool Install(size_t offset, const uint8_t *code, size_t size);
+  // Generates code for 'block' into 'buffer', setting 'size' to the space
+  // needed even when that is more than 'capacity'. The code can be moved.
+  bool CompileInto(DecodedBlock *block, uint8_t *buffer, size_t capacity,
+                   size_t *size);
+  void Verify(DecodedBlock *block);
+  State Capture() const;
+
+  Cpu65816 *cpu_;
+  Mode mode_;
+
+  uint8_t *code_ = nullptr;
+  size_t code_capacity_ = 0;
+  size_t code_used_ = 0;
+  // Where blocks are generated before being installed in the code buffer.
+  std::vector<uint8_t> scratch_;
+
+  // Stores and instruction count of the block being verified.
+  std::vector<JournalEntry> journal_;
+  uint32_t ops_executed_ = 0;
+};
@@ -28,6 +28,8 @@ class Cpu65816;
 
 class OpCode {
  public:
+  using Executor = void (Cpu65816::*)(OpCode&);
+
   OpCode(uint8_t code,
          const char* const name,
          const AddressingMode& addressingMode)
@@ -51,10 +53,11 @@ class OpCode {
 
   AddressingMode addressing_mode() const { return addressing_mode_; }
 
+  Executor executor() const { return executor_; }
+
   bool execute(Cpu65816& cpu) {
     if (executor_ != 0) {
-      OpCode opCode = *this;
-      (cpu.*executor_)(opCode);
+      (cpu.*executor_)(*this);
       return true;
     }
     return false;
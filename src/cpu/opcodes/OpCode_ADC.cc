@@ -23,8 +23,8 @@
  * This file contains the implementation for all ADC OpCodes.
  */
 
-void Cpu65816::execute8BitADC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitADC(const Address &dataAddress) {
   uint8_t value = system_bus_.ReadByte(dataAddress);
   uint8_t accumulator = Binary::lower8BitsOf(a_);
   uint8_t carryValue = cpu_status_.carry_flag ? 1 : 0;
@@ -60,8 +60,8 @@ void Cpu65816::execute8BitADC(OpCode &opCode) {
   Binary::setLower8BitsOf16BitsValue(&a_, result8Bit);
 }
 
-void Cpu65816::execute16BitADC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitADC(const Address &dataAddress) {
   uint16_t value = system_bus_.ReadWord(dataAddress);
   uint16_t accumulator = a_;
   uint16_t carryValue = cpu_status_.carry_flag ? 1 : 0;
@@ -97,8 +97,8 @@ void Cpu65816::execute16BitADC(OpCode &opCode) {
   a_ = result16Bit;
 }
 
-void Cpu65816::execute8BitBCDADC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitBCDADC(const Address &dataAddress) {
   uint8_t value = system_bus_.ReadByte(dataAddress);
   uint8_t accumulator = Binary::lower8BitsOf(a_);
 
@@ -114,8 +114,8 @@ void Cpu65816::execute8BitBCDADC(OpCode &opCode) {
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
 }
 
-void Cpu65816::execute16BitBCDADC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitBCDADC(const Address &dataAddress) {
   uint16_t value = system_bus_.ReadWord(dataAddress);
   uint16_t accumulator = a_;
 
@@ -131,17 +131,20 @@ void Cpu65816::execute16BitBCDADC(OpCode &opCode) {
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
 }
 
+template <int kMode>
 void Cpu65816::executeADC(OpCode &opCode) {
-  if (accumulatorIs8BitWide()) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
     if (cpu_status_.decimal_flag)
-      execute8BitBCDADC(opCode);
+      execute8BitBCDADC<kMode>(effectiveAddress.address);
     else
-      execute8BitADC(opCode);
+      execute8BitADC<kMode>(effectiveAddress.address);
   } else {
     if (cpu_status_.decimal_flag)
-      execute16BitBCDADC(opCode);
+      execute16BitBCDADC<kMode>(effectiveAddress.address);
     else
-      execute16BitADC(opCode);
+      execute16BitADC<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   }
 
@@ -155,7 +158,7 @@ void Cpu65816::executeADC(OpCode &opCode) {
   switch (opCode.code()) {
   case (0x69): // ADC Immediate
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       program_address_.offset_ += 1;
     }
     program_address_.offset_ += 2;
@@ -206,7 +209,7 @@ void Cpu65816::executeADC(OpCode &opCode) {
   }
   case (0x7D): // ADC Absolute Indexed, X
   {
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
 
@@ -222,7 +225,7 @@ void Cpu65816::executeADC(OpCode &opCode) {
   }
   case (0x79): // ADC Absolute Indexed Y
   {
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     program_address_.offset_ += 3;
@@ -252,7 +255,7 @@ void Cpu65816::executeADC(OpCode &opCode) {
     if (Binary::lower8BitsOf(dp_) != 0) {
       total_cycles_counter_ += 1;
     }
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     program_address_.offset_ += 2;
@@ -285,3 +288,5 @@ void Cpu65816::executeADC(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeADC);
@@ -27,34 +27,37 @@
  * This file contains implementations for all AND OpCodes.
  */
 
-void Cpu65816::executeAND8Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeAND8Bit(const Address &opCodeDataAddress) {
   uint8_t operand = system_bus_.ReadByte(opCodeDataAddress);
   uint8_t result = Binary::lower8BitsOf(a_) & operand;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
   Binary::setLower8BitsOf16BitsValue(&a_, result);
 }
 
-void Cpu65816::executeAND16Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeAND16Bit(const Address &opCodeDataAddress) {
   uint16_t operand = system_bus_.ReadWord(opCodeDataAddress);
   uint16_t result = a_ & operand;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(result);
   a_ = result;
 }
 
+template <int kMode>
 void Cpu65816::executeAND(OpCode& opCode) {
-  if (accumulatorIs16BitWide()) {
-    executeAND16Bit(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs16BitWide<kMode>()) {
+    executeAND16Bit<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   } else {
-    executeAND8Bit(opCode);
+    executeAND8Bit<kMode>(effectiveAddress.address);
   }
 
   switch (opCode.code()) {
     case (0x29):  // AND Immediate
     {
-      if (accumulatorIs16BitWide()) {
+      if (accumulatorIs16BitWide<kMode>()) {
         program_address_.offset_ += 1;
       }
       addToProgramAddressAndCycles(2, 2);
@@ -96,7 +99,7 @@ void Cpu65816::executeAND(OpCode& opCode) {
     }
     case (0x3D):  // AND Absolute Indexed, X
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -109,7 +112,7 @@ void Cpu65816::executeAND(OpCode& opCode) {
     }
     case (0x39):  // AND Absolute Indexed, Y
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -136,7 +139,7 @@ void Cpu65816::executeAND(OpCode& opCode) {
       if (Binary::lower8BitsOf(dp_) != 0) {
         total_cycles_counter_ += 1;
       }
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(2, 5);
@@ -165,3 +168,5 @@ void Cpu65816::executeAND(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeAND);
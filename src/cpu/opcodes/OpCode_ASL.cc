@@ -45,10 +45,10 @@
  * This file contains implementations for all ASL OpCodes.
  */
 
-void Cpu65816::executeMemoryASL(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeMemoryASL(const Address &opCodeDataAddress) {
 
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
     DO_ASL_8_BIT(value);
     system_bus_.StoreByte(opCodeDataAddress, value);
@@ -59,8 +59,9 @@ void Cpu65816::executeMemoryASL(OpCode &opCode) {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeAccumulatorASL() {
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = Binary::lower8BitsOf(a_);
     DO_ASL_8_BIT(value);
     Binary::setLower8BitsOf16BitsValue(&a_, value);
@@ -69,61 +70,64 @@ void Cpu65816::executeAccumulatorASL() {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeASL(OpCode &opCode) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
   switch (opCode.code()) {
   case (0x0A): // ASL Accumulator
   {
-    executeAccumulatorASL();
+    executeAccumulatorASL<kMode>();
     addToProgramAddressAndCycles(1, 2);
     break;
   }
   case (0x0E): // ASL Absolute
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
 
-    executeMemoryASL(opCode);
+    executeMemoryASL<kMode>(effectiveAddress.address);
     addToProgramAddressAndCycles(3, 6);
     break;
   }
   case (0x06): // ASL Direct Page
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
       total_cycles_counter_ += 1;
     }
 
-    executeMemoryASL(opCode);
+    executeMemoryASL<kMode>(effectiveAddress.address);
     addToProgramAddressAndCycles(2, 5);
     break;
   }
   case (0x1E): // ASL Absolute Indexed, X
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
 #ifdef EMU_65C02
-    if (!opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (!effectiveAddress.crosses_page) {
       subtractFromCycles(1);
     }
 #endif
-    executeMemoryASL(opCode);
+    executeMemoryASL<kMode>(effectiveAddress.address);
     addToProgramAddressAndCycles(3, 7);
     break;
   }
   case (0x16): // ASL Direct Page Indexed, X
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
       total_cycles_counter_ += 1;
     }
 
-    executeMemoryASL(opCode);
+    executeMemoryASL<kMode>(effectiveAddress.address);
     addToProgramAddressAndCycles(2, 6);
     break;
   }
@@ -132,3 +136,5 @@ void Cpu65816::executeASL(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeASL);
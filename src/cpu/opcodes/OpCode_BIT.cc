@@ -26,17 +26,18 @@
  * This file contains the implementation for all BIT OpCodes
  */
 
-void Cpu65816::execute8BitBIT(OpCode& opCode) {
-  const Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitBIT(OpCode& opCode,
+                              const Address& addressOfOpCodeData) {
   uint8_t value = system_bus_.ReadByte(addressOfOpCodeData);
   bool isHighestBitSet = value & 0x80;
   bool isNextToHighestBitSet = value & 0x40;
 
   if (opCode.addressing_mode() != AddressingMode::Immediate) {
     if (isHighestBitSet)
-      cpu_status_.sign_flag = true;
+      cpu_status_.set_sign_flag(true);
     else
-      cpu_status_.sign_flag = false;
+      cpu_status_.set_sign_flag(false);
     if (isNextToHighestBitSet)
       cpu_status_.overflow_flag = true;
     else
@@ -45,17 +46,18 @@ void Cpu65816::execute8BitBIT(OpCode& opCode) {
   cpu_status_.updateZeroFlagFrom8BitValue(value & Binary::lower8BitsOf(a_));
 }
 
-void Cpu65816::execute16BitBIT(OpCode& opCode) {
-  const Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitBIT(OpCode& opCode,
+                              const Address& addressOfOpCodeData) {
   uint16_t value = system_bus_.ReadWord(addressOfOpCodeData);
   bool isHighestBitSet = value & 0x8000;
   bool isNextToHighestBitSet = value & 0x4000;
 
   if (opCode.addressing_mode() != AddressingMode::Immediate) {
     if (isHighestBitSet)
-      cpu_status_.sign_flag = true;
+      cpu_status_.set_sign_flag(true);
     else
-      cpu_status_.sign_flag = false;
+      cpu_status_.set_sign_flag(false);
     if (isNextToHighestBitSet)
       cpu_status_.overflow_flag = true;
     else
@@ -64,18 +66,21 @@ void Cpu65816::execute16BitBIT(OpCode& opCode) {
   cpu_status_.updateZeroFlagFrom16BitValue(value & a_);
 }
 
+template <int kMode>
 void Cpu65816::executeBIT(OpCode& opCode) {
-  if (accumulatorIs8BitWide()) {
-    execute8BitBIT(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
+    execute8BitBIT<kMode>(opCode, effectiveAddress.address);
   } else {
-    execute16BitBIT(opCode);
+    execute16BitBIT<kMode>(opCode, effectiveAddress.address);
     total_cycles_counter_ += 1;
   }
 
   switch (opCode.code()) {
     case (0x89):  // BIT Immediate
     {
-      if (accumulatorIs16BitWide()) {
+      if (accumulatorIs16BitWide<kMode>()) {
         program_address_.offset_ += 1;
       }
       addToProgramAddressAndCycles(2, 2);
@@ -96,7 +101,7 @@ void Cpu65816::executeBIT(OpCode& opCode) {
     }
     case (0x3C):  // BIT Absolute Indexed, X
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -113,3 +118,5 @@ void Cpu65816::executeBIT(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeBIT);
@@ -24,9 +24,11 @@
 /**
  * This file contains the implementation for all branch OpCodes
  */
+template <int kMode>
 int Cpu65816::executeBranchShortOnCondition(bool condition, OpCode &opCode) {
   uint8_t opCycles = 2;
-  uint8_t destination = system_bus_.ReadByte(getAddressOfOpCodeData(opCode));
+  uint8_t destination =
+      system_bus_.ReadByte(getAddressOfOpCodeData<kMode>(opCode));
   // This is the address of the next instruction
   uint16_t actualDestination;
   if (condition) {
@@ -42,7 +44,7 @@ int Cpu65816::executeBranchShortOnCondition(bool condition, OpCode &opCode) {
     // Emulation mode requires 1 extra cycle on page boundary crossing
     if (Address::OffsetsAreOnDifferentPages(program_address_.offset_,
                                             actualDestination) &&
-        cpu_status_.emulation_flag) {
+        kMode == kModeEmulation) {
       opCycles++;
     }
   } else {
@@ -53,73 +55,78 @@ int Cpu65816::executeBranchShortOnCondition(bool condition, OpCode &opCode) {
   return opCycles;
 }
 
+template <int kMode>
 int Cpu65816::executeBranchLongOnCondition(bool condition, OpCode &opCode) {
   if (condition) {
-    uint16_t destination = system_bus_.ReadWord(getAddressOfOpCodeData(opCode));
+    uint16_t destination =
+        system_bus_.ReadWord(getAddressOfOpCodeData<kMode>(opCode));
     program_address_.offset_ += 3 + destination;
   }
   // CPU cycles: 4
   return 4;
 }
 
+template <int kMode>
 void Cpu65816::executeBranch(OpCode &opCode) {
   switch (opCode.code()) {
   case (0xD0): // BNE
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(!cpu_status_.zero_flag, opCode);
+        executeBranchShortOnCondition<kMode>(!cpu_status_.zero_flag(), opCode);
     break;
   }
   case (0xF0): // BEQ
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(cpu_status_.zero_flag, opCode);
+        executeBranchShortOnCondition<kMode>(cpu_status_.zero_flag(), opCode);
     break;
   }
   case (0x90): // BCC
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(!cpu_status_.carry_flag, opCode);
+        executeBranchShortOnCondition<kMode>(!cpu_status_.carry_flag, opCode);
     break;
   }
   case (0xB0): // BCS
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(cpu_status_.carry_flag, opCode);
+        executeBranchShortOnCondition<kMode>(cpu_status_.carry_flag, opCode);
     break;
   }
   case (0x10): // BPL
   {
-    int cycles = executeBranchShortOnCondition(!cpu_status_.sign_flag, opCode);
+    int cycles =
+        executeBranchShortOnCondition<kMode>(!cpu_status_.sign_flag(), opCode);
     total_cycles_counter_ += cycles;
     break;
   }
   case (0x30): // BMI
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(cpu_status_.sign_flag, opCode);
+        executeBranchShortOnCondition<kMode>(cpu_status_.sign_flag(), opCode);
     break;
   }
   case (0x50): // BVC
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(!cpu_status_.overflow_flag, opCode);
+        executeBranchShortOnCondition<kMode>(!cpu_status_.overflow_flag,
+                                             opCode);
     break;
   }
   case (0x70): // BVS
   {
     total_cycles_counter_ +=
-        executeBranchShortOnCondition(cpu_status_.overflow_flag, opCode);
+        executeBranchShortOnCondition<kMode>(cpu_status_.overflow_flag, opCode);
     break;
   }
   case (0x80): // BRA
   {
-    total_cycles_counter_ += executeBranchShortOnCondition(true, opCode);
+    total_cycles_counter_ += executeBranchShortOnCondition<kMode>(true, opCode);
     break;
   }
   case (0x82): // BRL
   {
-    total_cycles_counter_ += executeBranchLongOnCondition(true, opCode);
+    total_cycles_counter_ += executeBranchLongOnCondition<kMode>(true, opCode);
     break;
   }
   default: {
@@ -127,3 +134,5 @@ void Cpu65816::executeBranch(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeBranch);
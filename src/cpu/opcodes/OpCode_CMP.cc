@@ -23,8 +23,8 @@
  * This file contains the implementation for all CMP OpCodes
  */
 
-void Cpu65816::execute8BitCMP(OpCode &opCode) {
-  Address valueAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitCMP(const Address &valueAddress) {
   uint8_t value = system_bus_.ReadByte(valueAddress);
   uint8_t result = Binary::lower8BitsOf(a_) - value;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
@@ -35,8 +35,8 @@ void Cpu65816::execute8BitCMP(OpCode &opCode) {
   }
 }
 
-void Cpu65816::execute16BitCMP(OpCode &opCode) {
-  Address valueAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitCMP(const Address &valueAddress) {
   uint16_t value = system_bus_.ReadWord(valueAddress);
   uint16_t result = a_ - value;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(result);
@@ -47,18 +47,21 @@ void Cpu65816::execute16BitCMP(OpCode &opCode) {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeCMP(OpCode &opCode) {
-  if (accumulatorIs8BitWide()) {
-    execute8BitCMP(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
+    execute8BitCMP<kMode>(effectiveAddress.address);
   } else {
-    execute16BitCMP(opCode);
+    execute16BitCMP<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   }
 
   switch (opCode.code()) {
   case (0xC9): // CMP Immediate
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       program_address_.offset_ += 1;
     }
     addToProgramAddressAndCycles(2, 2);
@@ -97,7 +100,7 @@ void Cpu65816::executeCMP(OpCode &opCode) {
   }
   case (0xDD): // CMP Absolute Indexed, X
   {
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     addToProgramAddressAndCycles(3, 4);
@@ -110,7 +113,7 @@ void Cpu65816::executeCMP(OpCode &opCode) {
   }
   case (0xD9): // CMP Absolute Indexed, Y
   {
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     addToProgramAddressAndCycles(3, 4);
@@ -137,7 +140,7 @@ void Cpu65816::executeCMP(OpCode &opCode) {
     if (Binary::lower8BitsOf(dp_) != 0) {
       total_cycles_counter_ += 1;
     }
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     addToProgramAddressAndCycles(2, 5);
@@ -166,3 +169,5 @@ void Cpu65816::executeCMP(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeCMP);
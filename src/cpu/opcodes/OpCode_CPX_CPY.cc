@@ -25,8 +25,9 @@
  * This file contains implementations for all CPX and CPY OpCodes.
  */
 
+template <int kMode>
 void Cpu65816::execute8BitCPX(OpCode& opCode) {
-  uint8_t value = system_bus_.ReadByte(getAddressOfOpCodeData(opCode));
+  uint8_t value = system_bus_.ReadByte(getAddressOfOpCodeData<kMode>(opCode));
   uint8_t result = Binary::lower8BitsOf(x_) - value;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
   if (Binary::lower8BitsOf(x_) >= value)
@@ -35,8 +36,9 @@ void Cpu65816::execute8BitCPX(OpCode& opCode) {
     cpu_status_.carry_flag = 0;
 }
 
+template <int kMode>
 void Cpu65816::execute16BitCPX(OpCode& opCode) {
-  uint16_t value = system_bus_.ReadWord(getAddressOfOpCodeData(opCode));
+  uint16_t value = system_bus_.ReadWord(getAddressOfOpCodeData<kMode>(opCode));
   uint16_t result = x_ - value;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(result);
   if (x_ >= value)
@@ -45,8 +47,9 @@ void Cpu65816::execute16BitCPX(OpCode& opCode) {
     cpu_status_.carry_flag = 0;
 }
 
+template <int kMode>
 void Cpu65816::execute8BitCPY(OpCode& opCode) {
-  uint8_t value = system_bus_.ReadByte(getAddressOfOpCodeData(opCode));
+  uint8_t value = system_bus_.ReadByte(getAddressOfOpCodeData<kMode>(opCode));
   uint8_t result = Binary::lower8BitsOf(y_) - value;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
   if (Binary::lower8BitsOf(y_) >= value)
@@ -55,8 +58,9 @@ void Cpu65816::execute8BitCPY(OpCode& opCode) {
     cpu_status_.carry_flag = 0;
 }
 
+template <int kMode>
 void Cpu65816::execute16BitCPY(OpCode& opCode) {
-  uint16_t value = system_bus_.ReadWord(getAddressOfOpCodeData(opCode));
+  uint16_t value = system_bus_.ReadWord(getAddressOfOpCodeData<kMode>(opCode));
   uint16_t result = y_ - value;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(result);
   if (y_ >= value)
@@ -65,14 +69,15 @@ void Cpu65816::execute16BitCPY(OpCode& opCode) {
     cpu_status_.carry_flag = 0;
 }
 
+template <int kMode>
 void Cpu65816::executeCPXCPY(OpCode& opCode) {
   switch (opCode.code()) {
     case (0xE0):  // CPX Immediate
     {
-      if (indexIs8BitWide()) {
-        execute8BitCPX(opCode);
+      if (indexIs8BitWide<kMode>()) {
+        execute8BitCPX<kMode>(opCode);
       } else {
-        execute16BitCPX(opCode);
+        execute16BitCPX<kMode>(opCode);
         program_address_.offset_ += 1;
         total_cycles_counter_ += 1;
       }
@@ -81,10 +86,10 @@ void Cpu65816::executeCPXCPY(OpCode& opCode) {
     }
     case (0xEC):  // CPX Absolute
     {
-      if (indexIs8BitWide()) {
-        execute8BitCPX(opCode);
+      if (indexIs8BitWide<kMode>()) {
+        execute8BitCPX<kMode>(opCode);
       } else {
-        execute16BitCPX(opCode);
+        execute16BitCPX<kMode>(opCode);
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -92,10 +97,10 @@ void Cpu65816::executeCPXCPY(OpCode& opCode) {
     }
     case (0xE4):  // CPX Direct Page
     {
-      if (indexIs8BitWide()) {
-        execute8BitCPX(opCode);
+      if (indexIs8BitWide<kMode>()) {
+        execute8BitCPX<kMode>(opCode);
       } else {
-        execute16BitCPX(opCode);
+        execute16BitCPX<kMode>(opCode);
         total_cycles_counter_ += 1;
       }
       if (Binary::lower8BitsOf(dp_) != 0) {
@@ -106,10 +111,10 @@ void Cpu65816::executeCPXCPY(OpCode& opCode) {
     }
     case (0xC0):  // CPY Immediate
     {
-      if (indexIs8BitWide()) {
-        execute8BitCPY(opCode);
+      if (indexIs8BitWide<kMode>()) {
+        execute8BitCPY<kMode>(opCode);
       } else {
-        execute16BitCPY(opCode);
+        execute16BitCPY<kMode>(opCode);
         program_address_.offset_ += 1;
         total_cycles_counter_ += 1;
       }
@@ -118,10 +123,10 @@ void Cpu65816::executeCPXCPY(OpCode& opCode) {
     }
     case (0xCC):  // CPY Absolute
     {
-      if (indexIs8BitWide()) {
-        execute8BitCPY(opCode);
+      if (indexIs8BitWide<kMode>()) {
+        execute8BitCPY<kMode>(opCode);
       } else {
-        execute16BitCPY(opCode);
+        execute16BitCPY<kMode>(opCode);
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -129,10 +134,10 @@ void Cpu65816::executeCPXCPY(OpCode& opCode) {
     }
     case (0xC4):  // CPY Direct Page
     {
-      if (indexIs8BitWide()) {
-        execute8BitCPY(opCode);
+      if (indexIs8BitWide<kMode>()) {
+        execute8BitCPY<kMode>(opCode);
       } else {
-        execute16BitCPY(opCode);
+        execute16BitCPY<kMode>(opCode);
         total_cycles_counter_ += 1;
       }
       if (Binary::lower8BitsOf(dp_) != 0) {
@@ -144,3 +149,5 @@ void Cpu65816::executeCPXCPY(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeCPXCPY);
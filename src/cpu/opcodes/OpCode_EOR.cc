@@ -25,34 +25,37 @@
  * This file contains the implementation for all EOR OpCodes.
  */
 
-void Cpu65816::executeEOR8Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeEOR8Bit(const Address &opCodeDataAddress) {
   uint8_t operand = system_bus_.ReadByte(opCodeDataAddress);
   uint8_t result = Binary::lower8BitsOf(a_) ^ operand;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
   Binary::setLower8BitsOf16BitsValue(&a_, result);
 }
 
-void Cpu65816::executeEOR16Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeEOR16Bit(const Address &opCodeDataAddress) {
   uint16_t operand = system_bus_.ReadWord(opCodeDataAddress);
   uint16_t result = a_ ^ operand;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(result);
   a_ = result;
 }
 
+template <int kMode>
 void Cpu65816::executeEOR(OpCode& opCode) {
-  if (accumulatorIs8BitWide()) {
-    executeEOR8Bit(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
+    executeEOR8Bit<kMode>(effectiveAddress.address);
   } else {
-    executeEOR16Bit(opCode);
+    executeEOR16Bit<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   }
 
   switch (opCode.code()) {
     case (0x49):  // EOR Immediate
     {
-      if (accumulatorIs16BitWide()) {
+      if (accumulatorIs16BitWide<kMode>()) {
         program_address_.offset_ += 1;
       }
       addToProgramAddressAndCycles(2, 2);
@@ -94,7 +97,7 @@ void Cpu65816::executeEOR(OpCode& opCode) {
     }
     case (0x5D):  // EOR Absolute Indexed, X
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -107,7 +110,7 @@ void Cpu65816::executeEOR(OpCode& opCode) {
     }
     case (0x59):  // EOR Absolute Indexed, Y
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -134,7 +137,7 @@ void Cpu65816::executeEOR(OpCode& opCode) {
       if (Binary::lower8BitsOf(dp_) != 0) {
         total_cycles_counter_ += 1;
       }
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(2, 5);
@@ -161,3 +164,5 @@ void Cpu65816::executeEOR(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeEOR);
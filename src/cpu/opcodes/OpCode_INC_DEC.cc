@@ -23,43 +23,46 @@
  * This file contains implementations for all Increment and Decrement OpCodes.
  */
 
-void Cpu65816::execute8BitDecInMemory(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitDecInMemory(const Address &opCodeDataAddress) {
   uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
   value--;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
   system_bus_.StoreByte(opCodeDataAddress, value);
 }
 
-void Cpu65816::execute16BitDecInMemory(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitDecInMemory(const Address &opCodeDataAddress) {
   uint16_t value = system_bus_.ReadWord(opCodeDataAddress);
   value--;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(value);
   system_bus_.StoreWord(opCodeDataAddress, value);
 }
 
-void Cpu65816::execute8BitIncInMemory(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitIncInMemory(const Address &opCodeDataAddress) {
   uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
   value++;
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
   system_bus_.StoreByte(opCodeDataAddress, value);
 }
 
-void Cpu65816::execute16BitIncInMemory(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitIncInMemory(const Address &opCodeDataAddress) {
   uint16_t value = system_bus_.ReadWord(opCodeDataAddress);
   value++;
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(value);
   system_bus_.StoreWord(opCodeDataAddress, value);
 }
 
+template <int kMode>
 void Cpu65816::executeINCDEC(OpCode &opCode) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
   switch (opCode.code()) {
   case (0x1A): // INC Accumulator
   {
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       uint8_t lowerA = Binary::lower8BitsOf(a_);
       lowerA++;
       Binary::setLower8BitsOf16BitsValue(&a_, lowerA);
@@ -73,10 +76,10 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xEE): // INC Absolute
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitIncInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitIncInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitIncInMemory(opCode);
+      execute16BitIncInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
     addToProgramAddressAndCycles(3, 6);
@@ -84,10 +87,10 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xE6): // INC Direct Page
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitIncInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitIncInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitIncInMemory(opCode);
+      execute16BitIncInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
@@ -98,14 +101,14 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xFE): // INC Absolute Indexed, X
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitIncInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitIncInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitIncInMemory(opCode);
+      execute16BitIncInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
 #ifdef EMU_65C02
-    if (!opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (!effectiveAddress.crosses_page) {
       subtractFromCycles(1);
     }
 #endif
@@ -113,10 +116,10 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   } break;
   case (0xF6): // INC Direct Page Indexed, X
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitIncInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitIncInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitIncInMemory(opCode);
+      execute16BitIncInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
@@ -127,7 +130,7 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0x3A): // DEC Accumulator
   {
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       uint8_t lowerA = Binary::lower8BitsOf(a_);
       lowerA--;
       Binary::setLower8BitsOf16BitsValue(&a_, lowerA);
@@ -141,10 +144,10 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xCE): // DEC Absolute
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitDecInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitDecInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitDecInMemory(opCode);
+      execute16BitDecInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
     addToProgramAddressAndCycles(3, 6);
@@ -152,10 +155,10 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xC6): // DEC Direct Page
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitDecInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitDecInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitDecInMemory(opCode);
+      execute16BitDecInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
@@ -166,14 +169,14 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xDE): // DEC Absolute Indexed, X
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitDecInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitDecInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitDecInMemory(opCode);
+      execute16BitDecInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
 #ifdef EMU_65C02
-    if (!opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (!effectiveAddress.crosses_page) {
       subtractFromCycles(1);
     }
 #endif
@@ -182,10 +185,10 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xD6): // DEC Direct Page Indexed, X
   {
-    if (accumulatorIs8BitWide()) {
-      execute8BitDecInMemory(opCode);
+    if (accumulatorIs8BitWide<kMode>()) {
+      execute8BitDecInMemory<kMode>(effectiveAddress.address);
     } else {
-      execute16BitDecInMemory(opCode);
+      execute16BitDecInMemory<kMode>(effectiveAddress.address);
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
@@ -196,7 +199,7 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xC8): // INY
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t lowerY = Binary::lower8BitsOf(y_);
       lowerY++;
       Binary::setLower8BitsOf16BitsValue(&y_, lowerY);
@@ -210,7 +213,7 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xE8): // INX
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t lowerX = Binary::lower8BitsOf(x_);
       lowerX++;
       Binary::setLower8BitsOf16BitsValue(&x_, lowerX);
@@ -224,7 +227,7 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0x88): // DEY
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t lowerY = Binary::lower8BitsOf(y_);
       lowerY--;
       Binary::setLower8BitsOf16BitsValue(&y_, lowerY);
@@ -238,7 +241,7 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   case (0xCA): // DEX
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t lowerX = Binary::lower8BitsOf(x_);
       lowerX--;
       Binary::setLower8BitsOf16BitsValue(&x_, lowerX);
@@ -255,3 +258,5 @@ void Cpu65816::executeINCDEC(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeINCDEC);
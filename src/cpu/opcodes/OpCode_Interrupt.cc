@@ -27,6 +27,7 @@
  * that deal with interrupts.
  */
 
+template <int kMode>
 void Cpu65816::executeInterrupt(OpCode& opCode) {
   switch (opCode.code()) {
     case (0x00):  // BRK
@@ -78,6 +79,7 @@ void Cpu65816::executeInterrupt(OpCode& opCode) {
       // Note: The picture in the 65816 programming manual about this looks
       // wrong. This implementation follows the text instead.
       cpu_status_.setRegisterValue(stack_.Pull8Bit());
+      updateOpCodeTable();
 
       if (cpu_status_.emulation_flag) {
         Address newProgramAddress(program_address_.bank_, stack_.Pull16Bit());
@@ -95,3 +97,5 @@ void Cpu65816::executeInterrupt(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeInterrupt);
@@ -24,12 +24,13 @@
  * that deal with jumps, calls and returns.
  */
 
+template <int kMode>
 void Cpu65816::executeJumpReturn(OpCode &opCode) {
   switch (opCode.code()) {
   case (0x20): // JSR Absolute
   {
     stack_.Push16Bit(program_address_.offset_ + 2);
-    uint16_t destinationAddress = getAddressOfOpCodeData(opCode).offset_;
+    uint16_t destinationAddress = getAddressOfOpCodeData<kMode>(opCode).offset_;
     program_address_ = Address(program_address_.bank_, destinationAddress);
     total_cycles_counter_ += 6;
     break;
@@ -38,13 +39,13 @@ void Cpu65816::executeJumpReturn(OpCode &opCode) {
   {
     stack_.Push8Bit(program_address_.bank_);
     stack_.Push16Bit(program_address_.offset_ + 3);
-    program_address_ = getAddressOfOpCodeData(opCode);
+    program_address_ = getAddressOfOpCodeData<kMode>(opCode);
     total_cycles_counter_ += 8;
     break;
   }
   case (0xFC): // JSR Absolute Indexed Indirect, X
   {
-    Address destinationAddress = getAddressOfOpCodeData(opCode);
+    Address destinationAddress = getAddressOfOpCodeData<kMode>(opCode);
     stack_.Push8Bit(program_address_.bank_);
     stack_.Push16Bit(program_address_.offset_ + 2);
     program_address_ = destinationAddress;
@@ -53,14 +54,14 @@ void Cpu65816::executeJumpReturn(OpCode &opCode) {
   }
   case (0x4C): // JMP Absolute
   {
-    uint16_t destinationAddress = getAddressOfOpCodeData(opCode).offset_;
+    uint16_t destinationAddress = getAddressOfOpCodeData<kMode>(opCode).offset_;
     program_address_ = Address(program_address_.bank_, destinationAddress);
     total_cycles_counter_ += 3;
     break;
   }
   case (0x6C): // JMP Absolute Indirect
   {
-    program_address_ = getAddressOfOpCodeData(opCode);
+    program_address_ = getAddressOfOpCodeData<kMode>(opCode);
     total_cycles_counter_ += 5;
 #ifdef EMU_65C02
     total_cycles_counter_ += 1;
@@ -69,19 +70,19 @@ void Cpu65816::executeJumpReturn(OpCode &opCode) {
   }
   case (0x7C): // JMP Absolute Indexed Indirect, X
   {
-    program_address_ = getAddressOfOpCodeData(opCode);
+    program_address_ = getAddressOfOpCodeData<kMode>(opCode);
     total_cycles_counter_ += 6;
     break;
   }
   case (0x5C): // JMP Absolute Long
   {
-    program_address_ = getAddressOfOpCodeData(opCode);
+    program_address_ = getAddressOfOpCodeData<kMode>(opCode);
     total_cycles_counter_ += 4;
     break;
   }
   case (0xDC): // JMP Absolute Indirect Long
   {
-    program_address_ = getAddressOfOpCodeData(opCode);
+    program_address_ = getAddressOfOpCodeData<kMode>(opCode);
     total_cycles_counter_ += 6;
     break;
   }
@@ -107,3 +108,5 @@ void Cpu65816::executeJumpReturn(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeJumpReturn);
@@ -27,31 +27,34 @@
  * This file contains implementations for all LDA OpCodes.
  */
 
-void Cpu65816::executeLDA8Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeLDA8Bit(const Address &opCodeDataAddress) {
   uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
   Binary::setLower8BitsOf16BitsValue(&a_, value);
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
 }
 
-void Cpu65816::executeLDA16Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeLDA16Bit(const Address &opCodeDataAddress) {
   a_ = system_bus_.ReadWord(opCodeDataAddress);
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(a_);
 }
 
+template <int kMode>
 void Cpu65816::executeLDA(OpCode& opCode) {
-  if (accumulatorIs16BitWide()) {
-    executeLDA16Bit(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs16BitWide<kMode>()) {
+    executeLDA16Bit<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   } else {
-    executeLDA8Bit(opCode);
+    executeLDA8Bit<kMode>(effectiveAddress.address);
   }
 
   switch (opCode.code()) {
     case (0xA9):  // LDA Immediate
     {
-      if (accumulatorIs16BitWide()) {
+      if (accumulatorIs16BitWide<kMode>()) {
         program_address_.offset_ += 1;
       }
       addToProgramAddressAndCycles(2, 2);
@@ -93,7 +96,7 @@ void Cpu65816::executeLDA(OpCode& opCode) {
     }
     case (0xBD):  // LDA Absolute Indexed, X
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -106,7 +109,7 @@ void Cpu65816::executeLDA(OpCode& opCode) {
     }
     case (0xB9):  // LDA Absolute Indexed, Y
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -133,7 +136,7 @@ void Cpu65816::executeLDA(OpCode& opCode) {
       if (Binary::lower8BitsOf(dp_) != 0) {
         total_cycles_counter_ += 1;
       }
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(2, 5);
@@ -160,3 +163,5 @@ void Cpu65816::executeLDA(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeLDA);
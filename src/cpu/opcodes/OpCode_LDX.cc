@@ -27,31 +27,34 @@
  * This file contains implementations for all LDX OpCodes.
  */
 
-void Cpu65816::executeLDX8Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeLDX8Bit(const Address &opCodeDataAddress) {
   uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
   Binary::setLower8BitsOf16BitsValue(&x_, value);
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
 }
 
-void Cpu65816::executeLDX16Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeLDX16Bit(const Address &opCodeDataAddress) {
   x_ = system_bus_.ReadWord(opCodeDataAddress);
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(x_);
 }
 
+template <int kMode>
 void Cpu65816::executeLDX(OpCode& opCode) {
-  if (indexIs16BitWide()) {
-    executeLDX16Bit(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (indexIs16BitWide<kMode>()) {
+    executeLDX16Bit<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   } else {
-    executeLDX8Bit(opCode);
+    executeLDX8Bit<kMode>(effectiveAddress.address);
   }
 
   switch (opCode.code()) {
     case (0xA2):  // LDX Immediate
     {
-      if (indexIs16BitWide()) {
+      if (indexIs16BitWide<kMode>()) {
         program_address_.offset_ += 1;
       }
       addToProgramAddressAndCycles(2, 2);
@@ -72,7 +75,7 @@ void Cpu65816::executeLDX(OpCode& opCode) {
     }
     case (0xBE):  // LDX Absolute Indexed, Y
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -89,3 +92,5 @@ void Cpu65816::executeLDX(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeLDX);
@@ -27,31 +27,34 @@
  * This file contains implementations for all LDY OpCodes.
  */
 
-void Cpu65816::executeLDY8Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeLDY8Bit(const Address &opCodeDataAddress) {
   uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
   Binary::setLower8BitsOf16BitsValue(&y_, value);
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
 }
 
-void Cpu65816::executeLDY16Bit(OpCode& opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeLDY16Bit(const Address &opCodeDataAddress) {
   y_ = system_bus_.ReadWord(opCodeDataAddress);
   cpu_status_.updateSignAndZeroFlagFrom16BitValue(y_);
 }
 
+template <int kMode>
 void Cpu65816::executeLDY(OpCode& opCode) {
-  if (indexIs16BitWide()) {
-    executeLDY16Bit(opCode);
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (indexIs16BitWide<kMode>()) {
+    executeLDY16Bit<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   } else {
-    executeLDY8Bit(opCode);
+    executeLDY8Bit<kMode>(effectiveAddress.address);
   }
 
   switch (opCode.code()) {
     case (0xA0):  // LDY Immediate
     {
-      if (indexIs16BitWide()) {
+      if (indexIs16BitWide<kMode>()) {
         program_address_.offset_ += 1;
       }
       addToProgramAddressAndCycles(2, 2);
@@ -72,7 +75,7 @@ void Cpu65816::executeLDY(OpCode& opCode) {
     }
     case (0xBC):  // LDY Absolute Indexed, X
     {
-      if (opCodeAddressingCrossesPageBoundary(opCode)) {
+      if (effectiveAddress.crosses_page) {
         total_cycles_counter_ += 1;
       }
       addToProgramAddressAndCycles(3, 4);
@@ -89,3 +92,5 @@ void Cpu65816::executeLDY(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeLDY);
@@ -45,10 +45,10 @@
  * This file contains implementations for all LSR OpCodes.
  */
 
-void Cpu65816::executeMemoryLSR(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeMemoryLSR(const Address &opCodeDataAddress) {
 
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
     DO_LSR_8_BIT(value);
     system_bus_.StoreByte(opCodeDataAddress, value);
@@ -59,8 +59,9 @@ void Cpu65816::executeMemoryLSR(OpCode &opCode) {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeAccumulatorLSR() {
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = Binary::lower8BitsOf(a_);
     DO_LSR_8_BIT(value);
     Binary::setLower8BitsOf16BitsValue(&a_, value);
@@ -69,18 +70,21 @@ void Cpu65816::executeAccumulatorLSR() {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeLSR(OpCode &opCode) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
   switch (opCode.code()) {
   case (0x4A): // LSR Accumulator
   {
-    executeAccumulatorLSR();
+    executeAccumulatorLSR<kMode>();
     addToProgramAddressAndCycles(1, 2);
     break;
   }
   case (0x4E): // LSR Absolute
   {
-    executeMemoryLSR(opCode);
-    if (accumulatorIs16BitWide()) {
+    executeMemoryLSR<kMode>(effectiveAddress.address);
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
     addToProgramAddressAndCycles(3, 6);
@@ -88,8 +92,8 @@ void Cpu65816::executeLSR(OpCode &opCode) {
   }
   case (0x46): // LSR Direct Page
   {
-    executeMemoryLSR(opCode);
-    if (accumulatorIs16BitWide()) {
+    executeMemoryLSR<kMode>(effectiveAddress.address);
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
@@ -101,13 +105,13 @@ void Cpu65816::executeLSR(OpCode &opCode) {
   }
   case (0x5E): // LSR Absolute Indexed, X
   {
-    executeMemoryLSR(opCode);
-    if (accumulatorIs16BitWide()) {
+    executeMemoryLSR<kMode>(effectiveAddress.address);
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
 
 #ifdef EMU_65C02
-    if (!opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (!effectiveAddress.crosses_page) {
       subtractFromCycles(1);
     }
 #endif
@@ -117,8 +121,8 @@ void Cpu65816::executeLSR(OpCode &opCode) {
   }
   case (0x56): // LSR Direct Page Indexed, X
   {
-    executeMemoryLSR(opCode);
-    if (accumulatorIs16BitWide()) {
+    executeMemoryLSR<kMode>(effectiveAddress.address);
+    if (accumulatorIs16BitWide<kMode>()) {
       total_cycles_counter_ += 2;
     }
     if (Binary::lower8BitsOf(dp_) != 0) {
@@ -133,3 +137,5 @@ void Cpu65816::executeLSR(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeLSR);
@@ -17,6 +17,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include "cpu/cpu_65816.h"
 
 
@@ -26,6 +29,104 @@
  * other categories.
  */
 
+namespace {
+
+// Copies |size| bytes one at a time, upwards when |step| is 1 and downwards
+// when it is -1, the way MVN and MVP do. That only differs from memmove()
+// when the destination overlaps the part of the source still to be read,
+// which programs use to fill memory with a repeating pattern.
+void MoveBlock(uint8_t *to, const uint8_t *from, uint32_t size, int step) {
+  const uintptr_t destination = reinterpret_cast<uintptr_t>(to);
+  const uintptr_t source = reinterpret_cast<uintptr_t>(from);
+  if (step > 0 && destination > source && destination < source + size) {
+    for (uint32_t i = 0; i < size; i++)
+      to[i] = from[i];
+  } else if (step < 0 && destination < source &&
+             destination + size > source) {
+    for (uint32_t i = size; i-- > 0;)
+      to[i] = from[i];
+  } else {
+    memmove(to, from, size);
+  }
+}
+
+// Number of bytes a block move can go on for from |index| before either
+// the index wraps around or the address leaves its SystemBus page.
+uint32_t BytesBeforeBoundary(uint16_t index, uint16_t indexMask, int step) {
+  if (step > 0)
+    return std::min<uint32_t>(indexMask - index + 1,
+                              SystemBus::kPageSize -
+                                  (index & SystemBus::kPageMask));
+  return std::min<uint32_t>(index + 1, (index & SystemBus::kPageMask) + 1);
+}
+
+} // namespace
+
+template <int kMode>
+void Cpu65816::executeBlockMove(int step) {
+  // The operand is the destination bank followed by the source bank.
+  const uint16_t banks = operand16();
+  const uint8_t destinationBank = Binary::lower8BitsOf(banks);
+  const uint8_t sourceBank = Binary::higher8BitsOf(banks);
+  // With 8 bit index registers the addresses only come from their low
+  // bytes.
+  const uint16_t indexMask = indexIs8BitWide<kMode>() ? 0xFF : 0xFFFF;
+  x_ &= indexMask;
+  y_ &= indexMask;
+  db_ = destinationBank;
+
+  // The CPU moves one byte, 7 cycles, each time it executes the
+  // instruction, and leaves the PC on it until A wraps around. As many
+  // bytes as fit in the rest of the Run() budget are moved here at once,
+  // after which Run() gets to look at pending interrupts before the
+  // instruction carries on.
+  uint32_t count = 1;
+  if (total_cycles_counter_ < run_end_cycles_) {
+    count = std::min<uint64_t>(
+        (uint32_t)a_ + 1, (run_end_cycles_ - total_cycles_counter_ + 6) / 7);
+  }
+
+  while (count > 0) {
+    uint32_t size = std::min(
+        {count, BytesBeforeBoundary(x_, indexMask, step),
+         BytesBeforeBoundary(y_, indexMask, step)});
+    const uint16_t lowestSource = step > 0 ? x_ : x_ - (size - 1);
+    const uint16_t lowestDestination = step > 0 ? y_ : y_ - (size - 1);
+    const uint32_t source = Address(sourceBank, lowestSource).AsInt();
+    const uint32_t destination =
+        Address(destinationBank, lowestDestination).AsInt();
+    // Every execution fetches the instruction again, so a move over the
+    // instruction itself has to stop as soon as it changes it.
+    const uint32_t instruction = program_address_.AsInt();
+    const bool overwritesInstruction =
+        destination < instruction + 3 && destination + size > instruction;
+    const uint8_t *from = system_bus_.DirectPointer(source, size);
+    uint8_t *to = system_bus_.DirectPointer(destination, size);
+    bool stop = false;
+    if (from && to && !overwritesInstruction) {
+      system_bus_.NoteWrite(destination, size);
+      MoveBlock(to, from, size, step);
+    } else {
+      // Devices are left to see the transfer a byte at a time.
+      size = 1;
+      const Address written(destinationBank, y_);
+      system_bus_.StoreByte(written,
+                            system_bus_.ReadByte(Address(sourceBank, x_)));
+      stop = written.AsInt() - instruction < 3;
+    }
+
+    x_ = (x_ + step * (int)size) & indexMask;
+    y_ = (y_ + step * (int)size) & indexMask;
+    a_ -= size;
+    count = stop ? 0 : count - size;
+    total_cycles_counter_ += 7 * size;
+  }
+
+  if (a_ == 0xFFFF)
+    program_address_.offset_ += 3;
+}
+
+template <int kMode>
 void Cpu65816::executeMisc(OpCode& opCode) {
   switch (opCode.code()) {
     case (0xEB):  // XBA
@@ -66,54 +167,16 @@ void Cpu65816::executeMisc(OpCode& opCode) {
     }
     case (0x44):  // MVP
     {
-      Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
-      uint8_t destinationBank = system_bus_.ReadByte(addressOfOpCodeData);
-      addressOfOpCodeData.offset_ += 1;
-      uint8_t sourceBank = system_bus_.ReadByte(addressOfOpCodeData);
-
-      Address sourceAddress(sourceBank, x_);
-      Address destinationAddress(destinationBank, y_);
-
-      while (a_ != 0xFFFF) {
-        uint8_t toTransfer = system_bus_.ReadByte(sourceAddress);
-        system_bus_.StoreByte(destinationAddress, toTransfer);
-
-        sourceAddress.offset_ -= 1;
-        destinationAddress.offset_ -= 1;
-        a_--;
-
-        total_cycles_counter_ += 7;
-      }
-      db_ = destinationBank;
-
-      program_address_.offset_ += 3;
+      executeBlockMove<kMode>(-1);
       break;
     }
     case (0x54):  // MVN
     {
-      Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
-      uint8_t destinationBank = system_bus_.ReadByte(addressOfOpCodeData);
-      addressOfOpCodeData.offset_ += 1;
-      uint8_t sourceBank = system_bus_.ReadByte(addressOfOpCodeData);
-
-      Address sourceAddress(sourceBank, x_);
-      Address destinationAddress(destinationBank, y_);
-
-      while (a_ != 0xFFFF) {
-        uint8_t toTransfer = system_bus_.ReadByte(sourceAddress);
-        system_bus_.StoreByte(destinationAddress, toTransfer);
-
-        sourceAddress.offset_ += 1;
-        destinationAddress.offset_ += 1;
-        a_--;
-
-        total_cycles_counter_ += 7;
-      }
-      db_ = destinationBank;
-
-      program_address_.offset_ += 3;
+      executeBlockMove<kMode>(1);
       break;
     }
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeMisc);
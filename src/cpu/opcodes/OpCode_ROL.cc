@@ -54,10 +54,10 @@
 /**
  * This file contains implementations for all ROL OpCodes.
  */
-void Cpu65816::executeMemoryROL(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeMemoryROL(const Address &opCodeDataAddress) {
 
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
     DO_ROL_8_BIT(value);
     system_bus_.StoreByte(opCodeDataAddress, value);
@@ -68,8 +68,9 @@ void Cpu65816::executeMemoryROL(OpCode &opCode) {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeAccumulatorROL() {
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = Binary::lower8BitsOf(a_);
     DO_ROL_8_BIT(value);
     Binary::setLower8BitsOf16BitsValue(&a_, value);
@@ -80,18 +81,21 @@ void Cpu65816::executeAccumulatorROL() {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeROL(OpCode &opCode) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
   switch (opCode.code()) {
   case (0x2A): // ROL accumulator
   {
-    executeAccumulatorROL();
+    executeAccumulatorROL<kMode>();
     addToProgramAddressAndCycles(1, 2);
     break;
   }
   case (0x2E): // ROL #addr
   {
-    executeMemoryROL(opCode);
-    if (accumulatorIs8BitWide()) {
+    executeMemoryROL<kMode>(effectiveAddress.address);
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(3, 6);
     } else {
       addToProgramAddressAndCycles(3, 8);
@@ -100,9 +104,9 @@ void Cpu65816::executeROL(OpCode &opCode) {
   }
   case (0x26): // ROL Direct Page
   {
-    executeMemoryROL(opCode);
+    executeMemoryROL<kMode>(effectiveAddress.address);
     int opCycles = Binary::lower8BitsOf(dp_) != 0 ? 1 : 0;
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(2, 5 + opCycles);
     } else {
       addToProgramAddressAndCycles(2, 7 + opCycles);
@@ -111,13 +115,14 @@ void Cpu65816::executeROL(OpCode &opCode) {
   }
   case (0x3E): // ROL Absolute Indexed, X
   {
-    executeMemoryROL(opCode);
+    executeMemoryROL<kMode>(effectiveAddress.address);
 #ifdef EMU_65C02
-    short opCycles = opCodeAddressingCrossesPageBoundary(opCode) ? 0 : -1;
+    short opCycles =
+        effectiveAddress.crosses_page ? 0 : -1;
 #else
     short opCycles = 0;
 #endif
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(3, 7 + opCycles);
     } else {
       addToProgramAddressAndCycles(3, 9 + opCycles);
@@ -126,9 +131,9 @@ void Cpu65816::executeROL(OpCode &opCode) {
   }
   case (0x36): // ROL Direct Page Indexed, X
   {
-    executeMemoryROL(opCode);
+    executeMemoryROL<kMode>(effectiveAddress.address);
     int opCycles = Binary::lower8BitsOf(dp_) != 0 ? 1 : 0;
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(2, 6 + opCycles);
     } else {
       addToProgramAddressAndCycles(2, 8 + opCycles);
@@ -140,3 +145,5 @@ void Cpu65816::executeROL(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeROL);
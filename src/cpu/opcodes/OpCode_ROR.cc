@@ -54,10 +54,10 @@
 /**
  * This file contains implementations for all ROR OpCodes.
  */
-void Cpu65816::executeMemoryROR(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::executeMemoryROR(const Address &opCodeDataAddress) {
 
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = system_bus_.ReadByte(opCodeDataAddress);
     DO_ROR_8_BIT(value);
     system_bus_.StoreByte(opCodeDataAddress, value);
@@ -68,8 +68,9 @@ void Cpu65816::executeMemoryROR(OpCode &opCode) {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeAccumulatorROR() {
-  if (accumulatorIs8BitWide()) {
+  if (accumulatorIs8BitWide<kMode>()) {
     uint8_t value = Binary::lower8BitsOf(a_);
     DO_ROR_8_BIT(value);
     Binary::setLower8BitsOf16BitsValue(&a_, value);
@@ -80,18 +81,21 @@ void Cpu65816::executeAccumulatorROR() {
   }
 }
 
+template <int kMode>
 void Cpu65816::executeROR(OpCode &opCode) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
   switch (opCode.code()) {
   case (0x6A): // ROR accumulator
   {
-    executeAccumulatorROR();
+    executeAccumulatorROR<kMode>();
     addToProgramAddressAndCycles(1, 2);
     break;
   }
   case (0x6E): // ROR #addr
   {
-    executeMemoryROR(opCode);
-    if (accumulatorIs8BitWide()) {
+    executeMemoryROR<kMode>(effectiveAddress.address);
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(3, 6);
     } else {
       addToProgramAddressAndCycles(3, 8);
@@ -100,9 +104,9 @@ void Cpu65816::executeROR(OpCode &opCode) {
   }
   case (0x66): // ROR Direct Page
   {
-    executeMemoryROR(opCode);
+    executeMemoryROR<kMode>(effectiveAddress.address);
     int opCycles = Binary::lower8BitsOf(dp_) != 0 ? 1 : 0;
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(2, 5 + opCycles);
     } else {
       addToProgramAddressAndCycles(2, 7 + opCycles);
@@ -111,13 +115,14 @@ void Cpu65816::executeROR(OpCode &opCode) {
   }
   case (0x7E): // ROR Absolute Indexed, X
   {
-    executeMemoryROR(opCode);
+    executeMemoryROR<kMode>(effectiveAddress.address);
 #ifdef EMU_65C02
-    short opCycles = opCodeAddressingCrossesPageBoundary(opCode) ? 0 : -1;
+    short opCycles =
+        effectiveAddress.crosses_page ? 0 : -1;
 #else
     short opCycles = 0;
 #endif
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(3, 7 + opCycles);
     } else {
       addToProgramAddressAndCycles(3, 9 + opCycles);
@@ -126,9 +131,9 @@ void Cpu65816::executeROR(OpCode &opCode) {
   }
   case (0x76): // ROR Direct Page Indexed, X
   {
-    executeMemoryROR(opCode);
+    executeMemoryROR<kMode>(effectiveAddress.address);
     int opCycles = Binary::lower8BitsOf(dp_) != 0 ? 1 : 0;
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       addToProgramAddressAndCycles(2, 6 + opCycles);
     } else {
       addToProgramAddressAndCycles(2, 8 + opCycles);
@@ -140,3 +145,5 @@ void Cpu65816::executeROR(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeROR);
@@ -23,8 +23,8 @@
  * This file contains the implementation for all SBC OpCodes.
  */
 
-void Cpu65816::execute8BitSBC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitSBC(const Address &dataAddress) {
   uint8_t value = system_bus_.ReadByte(dataAddress);
   uint8_t accumulator = Binary::lower8BitsOf(a_);
   bool borrow = !cpu_status_.carry_flag;
@@ -60,8 +60,8 @@ void Cpu65816::execute8BitSBC(OpCode &opCode) {
   Binary::setLower8BitsOf16BitsValue(&a_, result8Bit);
 }
 
-void Cpu65816::execute16BitSBC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitSBC(const Address &dataAddress) {
   uint16_t value = system_bus_.ReadWord(dataAddress);
   uint16_t accumulator = a_;
   bool borrow = !cpu_status_.carry_flag;
@@ -97,8 +97,8 @@ void Cpu65816::execute16BitSBC(OpCode &opCode) {
   a_ = result16Bit;
 }
 
-void Cpu65816::execute8BitBCDSBC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute8BitBCDSBC(const Address &dataAddress) {
   uint8_t value = system_bus_.ReadByte(dataAddress);
   uint8_t accumulator = Binary::lower8BitsOf(a_);
 
@@ -114,8 +114,8 @@ void Cpu65816::execute8BitBCDSBC(OpCode &opCode) {
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
 }
 
-void Cpu65816::execute16BitBCDSBC(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
+template <int kMode>
+void Cpu65816::execute16BitBCDSBC(const Address &dataAddress) {
   uint16_t value = system_bus_.ReadWord(dataAddress);
   uint16_t accumulator = a_;
 
@@ -131,17 +131,20 @@ void Cpu65816::execute16BitBCDSBC(OpCode &opCode) {
   cpu_status_.updateSignAndZeroFlagFrom8BitValue(result);
 }
 
+template <int kMode>
 void Cpu65816::executeSBC(OpCode &opCode) {
-  if (accumulatorIs8BitWide()) {
+  const EffectiveAddress effectiveAddress =
+      resolveEffectiveAddress<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
     if (cpu_status_.decimal_flag)
-      execute8BitBCDSBC(opCode);
+      execute8BitBCDSBC<kMode>(effectiveAddress.address);
     else
-      execute8BitSBC(opCode);
+      execute8BitSBC<kMode>(effectiveAddress.address);
   } else {
     if (cpu_status_.decimal_flag)
-      execute16BitBCDSBC(opCode);
+      execute16BitBCDSBC<kMode>(effectiveAddress.address);
     else
-      execute16BitSBC(opCode);
+      execute16BitSBC<kMode>(effectiveAddress.address);
     total_cycles_counter_ += 1;
   }
 
@@ -155,7 +158,7 @@ void Cpu65816::executeSBC(OpCode &opCode) {
   switch (opCode.code()) {
   case (0xE9): // SBC Immediate
   {
-    if (accumulatorIs16BitWide()) {
+    if (accumulatorIs16BitWide<kMode>()) {
       program_address_.offset_ += 1;
     }
     program_address_.offset_ += 2;
@@ -206,7 +209,7 @@ void Cpu65816::executeSBC(OpCode &opCode) {
   }
   case (0xFD): // SBC Absolute Indexed, X
   {
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
 
@@ -222,7 +225,7 @@ void Cpu65816::executeSBC(OpCode &opCode) {
   }
   case (0xF9): // SBC Absolute Indexed Y
   {
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     program_address_.offset_ += 3;
@@ -234,7 +237,7 @@ void Cpu65816::executeSBC(OpCode &opCode) {
     if (Binary::lower8BitsOf(dp_) != 0) {
       total_cycles_counter_ += 1;
     }
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     program_address_.offset_ += 2;
@@ -255,7 +258,7 @@ void Cpu65816::executeSBC(OpCode &opCode) {
     if (Binary::lower8BitsOf(dp_) != 0) {
       total_cycles_counter_ += 1;
     }
-    if (opCodeAddressingCrossesPageBoundary(opCode)) {
+    if (effectiveAddress.crosses_page) {
       total_cycles_counter_ += 1;
     }
     program_address_.offset_ += 2;
@@ -288,3 +291,5 @@ void Cpu65816::executeSBC(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeSBC);
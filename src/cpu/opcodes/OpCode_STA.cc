@@ -23,9 +23,10 @@
  * This file contains the implementation for all STA OpCodes.
  */
 
+template <int kMode>
 void Cpu65816::executeSTA(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
-  if (accumulatorIs8BitWide()) {
+  Address dataAddress = getAddressOfOpCodeData<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
     system_bus_.StoreByte(dataAddress, Binary::lower8BitsOf(a_));
   } else {
     system_bus_.StoreWord(dataAddress, a_);
@@ -150,3 +151,5 @@ void Cpu65816::executeSTA(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeSTA);
@@ -25,9 +25,10 @@
  * This file contains the implementation for all STX OpCodes.
  */
 
+template <int kMode>
 void Cpu65816::executeSTX(OpCode& opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
-  if (indexIs8BitWide()) {
+  Address dataAddress = getAddressOfOpCodeData<kMode>(opCode);
+  if (indexIs8BitWide<kMode>()) {
     system_bus_.StoreByte(dataAddress, Binary::lower8BitsOf(x_));
   } else {
     system_bus_.StoreWord(dataAddress, x_);
@@ -64,3 +65,5 @@ void Cpu65816::executeSTX(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeSTX);
@@ -25,9 +25,10 @@
  * This file contains the implementation for all STY OpCodes.
  */
 
+template <int kMode>
 void Cpu65816::executeSTY(OpCode &opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
-  if (accumulatorIs8BitWide()) {
+  Address dataAddress = getAddressOfOpCodeData<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
     system_bus_.StoreByte(dataAddress, Binary::lower8BitsOf(y_));
   } else {
     system_bus_.StoreWord(dataAddress, y_);
@@ -66,3 +67,5 @@ void Cpu65816::executeSTY(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeSTY);
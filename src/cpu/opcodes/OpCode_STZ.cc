@@ -25,9 +25,10 @@
  * This file contains the implementation for all STZ OpCodes.
  */
 
+template <int kMode>
 void Cpu65816::executeSTZ(OpCode& opCode) {
-  Address dataAddress = getAddressOfOpCodeData(opCode);
-  if (accumulatorIs8BitWide()) {
+  Address dataAddress = getAddressOfOpCodeData<kMode>(opCode);
+  if (accumulatorIs8BitWide<kMode>()) {
     system_bus_.StoreByte(dataAddress, 0x00);
   } else {
     system_bus_.StoreWord(dataAddress, 0x0000);
@@ -70,3 +71,5 @@ void Cpu65816::executeSTZ(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeSTZ);
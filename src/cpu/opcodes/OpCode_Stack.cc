@@ -22,8 +22,9 @@
 /**
  * This file contains the implementation for every stack related OpCode.
  */
+template <int kMode>
 void Cpu65816::executeStack(OpCode &opCode) {
-  Address opCodeDataAddress = getAddressOfOpCodeData(opCode);
+  Address opCodeDataAddress = getAddressOfOpCodeData<kMode>(opCode);
   switch (opCode.code()) {
   case 0xF4: // PEA
   {
@@ -51,7 +52,7 @@ void Cpu65816::executeStack(OpCode &opCode) {
   }
   case (0x48): // PHA
   {
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       stack_.Push8Bit(Binary::lower8BitsOf(a_));
       addToProgramAddressAndCycles(1, 4);
     } else {
@@ -86,7 +87,7 @@ void Cpu65816::executeStack(OpCode &opCode) {
   }
   case (0xDA): // PHX
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       stack_.Push8Bit(Binary::lower8BitsOf(x_));
       addToProgramAddressAndCycles(1, 3);
     } else {
@@ -97,7 +98,7 @@ void Cpu65816::executeStack(OpCode &opCode) {
   }
   case (0x5A): // PHY
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       stack_.Push8Bit(Binary::lower8BitsOf(y_));
       addToProgramAddressAndCycles(1, 3);
     } else {
@@ -108,7 +109,7 @@ void Cpu65816::executeStack(OpCode &opCode) {
   }
   case (0x68): // PLA
   {
-    if (accumulatorIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>()) {
       Binary::setLower8BitsOf16BitsValue(&a_, stack_.Pull8Bit());
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(a_);
       addToProgramAddressAndCycles(1, 4);
@@ -136,12 +137,13 @@ void Cpu65816::executeStack(OpCode &opCode) {
   case (0x28): // PLP
   {
     cpu_status_.setRegisterValue(stack_.Pull8Bit());
+    updateOpCodeTable();
     addToProgramAddressAndCycles(1, 4);
     break;
   }
   case (0xFA): // PLX
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t value = stack_.Pull8Bit();
       Binary::setLower8BitsOf16BitsValue(&x_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
@@ -155,7 +157,7 @@ void Cpu65816::executeStack(OpCode &opCode) {
   }
   case (0x7A): // PLY
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t value = stack_.Pull8Bit();
       Binary::setLower8BitsOf16BitsValue(&y_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
@@ -172,3 +174,5 @@ void Cpu65816::executeStack(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeStack);
@@ -26,12 +26,15 @@
  * that deal directly with the status register.
  */
 
+template <int kMode>
 void Cpu65816::executeStatusReg(OpCode& opCode) {
   switch (opCode.code()) {
     case (0xC2):  // REP #const
     {
-      uint8_t value = system_bus_.ReadByte(getAddressOfOpCodeData(opCode));
+      uint8_t value =
+          system_bus_.ReadByte(getAddressOfOpCodeData<kMode>(opCode));
       cpu_status_.resetPRegister(value);
+      updateOpCodeTable();
       addToProgramAddressAndCycles(2, 3);
       break;
     }
@@ -61,13 +64,15 @@ void Cpu65816::executeStatusReg(OpCode& opCode) {
     }
     case (0xE2):  // SEP
     {
-      uint8_t value = system_bus_.ReadByte(getAddressOfOpCodeData(opCode));
+      uint8_t value =
+          system_bus_.ReadByte(getAddressOfOpCodeData<kMode>(opCode));
       if (cpu_status_.emulation_flag) {
         // In emulation mode status bits 4 and 5 are not affected
         // 0xCF = 11001111
         value &= 0xCF;
       }
       cpu_status_.setPRegister(value);
+      updateOpCodeTable();
 
       addToProgramAddressAndCycles(2, 3);
       break;
@@ -114,6 +119,8 @@ void Cpu65816::executeStatusReg(OpCode& opCode) {
         cpu_status_.index_width_flag = false;
       }
 
+      updateOpCodeTable();
+
       // New stack
       stack_ = Stack(&system_bus_);
 
@@ -123,3 +130,5 @@ void Cpu65816::executeStatusReg(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeStatusReg);
@@ -26,64 +26,69 @@
  * This file contains the implementation for TSB and TRB OpCodes
  */
 
+template <int kMode>
 void Cpu65816::execute8BitTSB(OpCode& opCode) {
-  const Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
+  const Address addressOfOpCodeData = getAddressOfOpCodeData<kMode>(opCode);
   uint8_t value = system_bus_.ReadByte(addressOfOpCodeData);
   uint8_t lowerA = Binary::lower8BitsOf(a_);
   const uint8_t result = value | lowerA;
   system_bus_.StoreByte(addressOfOpCodeData, result);
 
   if ((value & lowerA) == 0)
-    cpu_status_.zero_flag = true;
+    cpu_status_.set_zero_flag(true);
   else
-    cpu_status_.zero_flag = 0;
+    cpu_status_.set_zero_flag(false);
 }
 
+template <int kMode>
 void Cpu65816::execute16BitTSB(OpCode& opCode) {
-  const Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
+  const Address addressOfOpCodeData = getAddressOfOpCodeData<kMode>(opCode);
   uint16_t value = system_bus_.ReadWord(addressOfOpCodeData);
   const uint16_t result = value | a_;
   system_bus_.StoreWord(addressOfOpCodeData, result);
 
   if ((value & a_) == 0)
-    cpu_status_.zero_flag = true;
+    cpu_status_.set_zero_flag(true);
   else
-    cpu_status_.zero_flag = 0;
+    cpu_status_.set_zero_flag(false);
 }
 
+template <int kMode>
 void Cpu65816::execute8BitTRB(OpCode& opCode) {
-  const Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
+  const Address addressOfOpCodeData = getAddressOfOpCodeData<kMode>(opCode);
   uint8_t value = system_bus_.ReadByte(addressOfOpCodeData);
   uint8_t lowerA = Binary::lower8BitsOf(a_);
   const uint8_t result = value & ~lowerA;
   system_bus_.StoreByte(addressOfOpCodeData, result);
 
   if ((value & lowerA) == 0)
-    cpu_status_.zero_flag = true;
+    cpu_status_.set_zero_flag(true);
   else
-    cpu_status_.zero_flag = 0;
+    cpu_status_.set_zero_flag(false);
 }
 
+template <int kMode>
 void Cpu65816::execute16BitTRB(OpCode& opCode) {
-  const Address addressOfOpCodeData = getAddressOfOpCodeData(opCode);
+  const Address addressOfOpCodeData = getAddressOfOpCodeData<kMode>(opCode);
   uint16_t value = system_bus_.ReadWord(addressOfOpCodeData);
   const uint16_t result = value & ~a_;
   system_bus_.StoreWord(addressOfOpCodeData, result);
 
   if ((value & a_) == 0)
-    cpu_status_.zero_flag = true;
+    cpu_status_.set_zero_flag(true);
   else
-    cpu_status_.zero_flag = 0;
+    cpu_status_.set_zero_flag(false);
 }
 
+template <int kMode>
 void Cpu65816::executeTSBTRB(OpCode& opCode) {
   switch (opCode.code()) {
     case (0x0C):  // TSB Absolute
     {
-      if (accumulatorIs8BitWide()) {
-        execute8BitTSB(opCode);
+      if (accumulatorIs8BitWide<kMode>()) {
+        execute8BitTSB<kMode>(opCode);
       } else {
-        execute16BitTSB(opCode);
+        execute16BitTSB<kMode>(opCode);
         total_cycles_counter_ += 2;
       }
       addToProgramAddressAndCycles(3, 6);
@@ -91,10 +96,10 @@ void Cpu65816::executeTSBTRB(OpCode& opCode) {
     }
     case (0x04):  // TSB Direct Page
     {
-      if (accumulatorIs8BitWide()) {
-        execute8BitTSB(opCode);
+      if (accumulatorIs8BitWide<kMode>()) {
+        execute8BitTSB<kMode>(opCode);
       } else {
-        execute16BitTSB(opCode);
+        execute16BitTSB<kMode>(opCode);
         total_cycles_counter_ += 2;
       }
       if (Binary::lower8BitsOf(dp_) != 0) {
@@ -105,10 +110,10 @@ void Cpu65816::executeTSBTRB(OpCode& opCode) {
     }
     case (0x1C):  // TRB Absolute
     {
-      if (accumulatorIs8BitWide()) {
-        execute8BitTRB(opCode);
+      if (accumulatorIs8BitWide<kMode>()) {
+        execute8BitTRB<kMode>(opCode);
       } else {
-        execute16BitTRB(opCode);
+        execute16BitTRB<kMode>(opCode);
         total_cycles_counter_ += 2;
       }
       addToProgramAddressAndCycles(3, 6);
@@ -116,10 +121,10 @@ void Cpu65816::executeTSBTRB(OpCode& opCode) {
     }
     case (0x14):  // TRB Direct Page
     {
-      if (accumulatorIs8BitWide()) {
-        execute8BitTRB(opCode);
+      if (accumulatorIs8BitWide<kMode>()) {
+        execute8BitTRB<kMode>(opCode);
       } else {
-        execute16BitTRB(opCode);
+        execute16BitTRB<kMode>(opCode);
         total_cycles_counter_ += 2;
       }
       if (Binary::lower8BitsOf(dp_) != 0) {
@@ -131,3 +136,5 @@ void Cpu65816::executeTSBTRB(OpCode& opCode) {
     default: { LOG_UNEXPECTED_OPCODE(opCode); }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeTSBTRB);
@@ -24,12 +24,13 @@
  * These are OpCodes which transfer one register value to another.
  */
 
+template <int kMode>
 void Cpu65816::executeTransfer(OpCode &opCode) {
   switch (opCode.code()) {
   case (0xA8): // TAY
   {
-    if ((accumulatorIs8BitWide() && indexIs8BitWide()) ||
-        (accumulatorIs16BitWide() && indexIs8BitWide())) {
+    if ((accumulatorIs8BitWide<kMode>() && indexIs8BitWide<kMode>()) ||
+        (accumulatorIs16BitWide<kMode>() && indexIs8BitWide<kMode>())) {
       uint8_t lower8BitsOfA = Binary::lower8BitsOf(a_);
       Binary::setLower8BitsOf16BitsValue(&y_, lower8BitsOfA);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(lower8BitsOfA);
@@ -42,8 +43,8 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   case (0xAA): // TAX
   {
-    if ((accumulatorIs8BitWide() && indexIs8BitWide()) ||
-        (accumulatorIs16BitWide() && indexIs8BitWide())) {
+    if ((accumulatorIs8BitWide<kMode>() && indexIs8BitWide<kMode>()) ||
+        (accumulatorIs16BitWide<kMode>() && indexIs8BitWide<kMode>())) {
       uint8_t lower8BitsOfA = Binary::lower8BitsOf(a_);
       Binary::setLower8BitsOf16BitsValue(&x_, lower8BitsOfA);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(lower8BitsOfA);
@@ -71,7 +72,7 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   case (0x1B): // TCS
   {
     uint16_t currentStackPointer = stack_.stack_pointer();
-    if (cpu_status_.emulation_flag) {
+    if (kMode == kModeEmulation) {
       Binary::setLower8BitsOf16BitsValue(&currentStackPointer,
                                          Binary::lower8BitsOf(a_));
     } else {
@@ -92,7 +93,7 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   case (0xBA): // TSX
   {
     uint16_t stackPointer = stack_.stack_pointer();
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t stackPointerLower8Bits = Binary::lower8BitsOf(stackPointer);
       Binary::setLower8BitsOf16BitsValue(&x_, stackPointerLower8Bits);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(stackPointerLower8Bits);
@@ -106,15 +107,15 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   case (0x8A): // TXA
   {
-    if (accumulatorIs8BitWide() && indexIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>() && indexIs8BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(x_);
       Binary::setLower8BitsOf16BitsValue(&a_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
-    } else if (accumulatorIs8BitWide() && indexIs16BitWide()) {
+    } else if (accumulatorIs8BitWide<kMode>() && indexIs16BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(x_);
       Binary::setLower8BitsOf16BitsValue(&a_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
-    } else if (accumulatorIs16BitWide() && indexIs8BitWide()) {
+    } else if (accumulatorIs16BitWide<kMode>() && indexIs8BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(x_);
       a_ = value;
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
@@ -128,15 +129,15 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   case (0x98): // TYA
   {
-    if (accumulatorIs8BitWide() && indexIs8BitWide()) {
+    if (accumulatorIs8BitWide<kMode>() && indexIs8BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(y_);
       Binary::setLower8BitsOf16BitsValue(&a_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
-    } else if (accumulatorIs8BitWide() && indexIs16BitWide()) {
+    } else if (accumulatorIs8BitWide<kMode>() && indexIs16BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(y_);
       Binary::setLower8BitsOf16BitsValue(&a_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
-    } else if (accumulatorIs16BitWide() && indexIs8BitWide()) {
+    } else if (accumulatorIs16BitWide<kMode>() && indexIs8BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(y_);
       a_ = value;
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
@@ -150,13 +151,13 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   case (0x9A): // TXS
   {
-    if (cpu_status_.emulation_flag) {
+    if (kMode == kModeEmulation) {
       uint16_t newStackPointer = 0x100;
       newStackPointer |= Binary::lower8BitsOf(x_);
       stack_ = Stack(&system_bus_, newStackPointer);
-    } else if (!cpu_status_.emulation_flag && indexIs8BitWide()) {
+    } else if (kMode != kModeEmulation && indexIs8BitWide<kMode>()) {
       stack_ = Stack(&system_bus_, Binary::lower8BitsOf(x_));
-    } else if (!cpu_status_.emulation_flag && indexIs16BitWide()) {
+    } else if (kMode != kModeEmulation && indexIs16BitWide<kMode>()) {
       stack_ = Stack(&system_bus_, x_);
     }
     addToProgramAddressAndCycles(1, 2);
@@ -164,7 +165,7 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   case (0x9B): // TXY
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(x_);
       Binary::setLower8BitsOf16BitsValue(&y_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
@@ -177,7 +178,7 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   case (0xBB): // TYX
   {
-    if (indexIs8BitWide()) {
+    if (indexIs8BitWide<kMode>()) {
       uint8_t value = Binary::lower8BitsOf(y_);
       Binary::setLower8BitsOf16BitsValue(&x_, value);
       cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
@@ -194,3 +195,5 @@ void Cpu65816::executeTransfer(OpCode &opCode) {
   }
   }
 }
+
+INSTANTIATE_FOR_CPU_MODES(executeTransfer);
@@ -30,23 +30,23 @@ Stack::Stack(SystemBus *systemBus, uint16_t stack_pointer)
     : system_bus_(systemBus), stack_address_(0x00, stack_pointer) {
 }
 
-void Stack::Push8Bit(uint8_t value) {
+void Stack::SlowPush8Bit(uint8_t value) {
   system_bus_->StoreByte(stack_address_, value);
   stack_address_.offset_ -= sizeof(uint8_t);
 }
 
-void Stack::Push16Bit(uint16_t value) {
+void Stack::SlowPush16Bit(uint16_t value) {
   system_bus_->StoreWord(stack_address_ - 1, value);
   stack_address_.offset_ -= sizeof(uint16_t);
 }
 
-uint8_t Stack::Pull8Bit() {
+uint8_t Stack::SlowPull8Bit() {
   stack_address_.offset_ += sizeof(uint8_t);
   uint8_t v = system_bus_->ReadByte(stack_address_);
   return v;
 }
 
-uint16_t Stack::Pull16Bit() {
+uint16_t Stack::SlowPull16Bit() {
   stack_address_.offset_++;
   uint16_t v = system_bus_->ReadWord(stack_address_);
   stack_address_.offset_++;
@@ -32,19 +32,63 @@ class Stack {
   explicit Stack(SystemBus* system_bus_);
   Stack(SystemBus*, uint16_t stack_pointer);
 
-  void Push8Bit(uint8_t value);
-  void Push16Bit(uint16_t value);
+  // The stack nearly always lives in RAM, so pushes and pulls go straight
+  // to memory through window_ and only fall back to the bus at page edges
+  // or when the stack is somewhere else.
+  void Push8Bit(uint8_t value) {
+    const uint16_t sp = stack_address_.offset_;
+    if (uint8_t* mem = window_.Get(*system_bus_, sp, 1)) {
+      system_bus_->NoteWrite(sp, 1);
+      *mem = value;
+      stack_address_.offset_ = sp - 1;
+      return;
+    }
+    SlowPush8Bit(value);
+  }
+  void Push16Bit(uint16_t value) {
+    const uint16_t sp = stack_address_.offset_;
+    uint8_t* mem;
+    if (sp != 0 && (mem = window_.Get(*system_bus_, sp - 1, 2))) {
+      system_bus_->NoteWrite(sp - 1, 2);
+      mem[0] = value;
+      mem[1] = value >> 8;
+      stack_address_.offset_ = sp - 2;
+      return;
+    }
+    SlowPush16Bit(value);
+  }
 
-  uint8_t Pull8Bit();
-  uint16_t Pull16Bit();
+  uint8_t Pull8Bit() {
+    const uint16_t sp = stack_address_.offset_ + 1;
+    if (const uint8_t* mem = window_.Get(*system_bus_, sp, 1)) {
+      stack_address_.offset_ = sp;
+      return *mem;
+    }
+    return SlowPull8Bit();
+  }
+  uint16_t Pull16Bit() {
+    const uint16_t sp = stack_address_.offset_ + 1;
+    const uint8_t* mem;
+    if (sp != 0xFFFF && (mem = window_.Get(*system_bus_, sp, 2))) {
+      stack_address_.offset_ = sp + 1;
+      return mem[0] | (mem[1] << 8);
+    }
+    return SlowPull16Bit();
+  }
 
   uint16_t stack_pointer() const;
 
   std::string Peek(size_t num);
 
 private:
+  void SlowPush8Bit(uint8_t value);
+  void SlowPush16Bit(uint16_t value);
+  uint8_t SlowPull8Bit();
+  uint16_t SlowPull16Bit();
+
   SystemBus* system_bus_;
   Address stack_address_;
+  PageWindow window_;
 };
 
 #endif
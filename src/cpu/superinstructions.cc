@@ -0,0 +1,78 @@
+#include "cpu/cpu_65816.h"
+
+void Cpu65816::executeSuperinstruction() {
+  switch (static_cast<Superinstruction>(micro_op_->dispatch -
+                                        MicroOp::kSuperinstructionDispatch)) {
+  case Superinstruction::kCountBranch:
+    executeCountBranch();
+    break;
+  case Superinstruction::kCompareBranch:
+    executeCompareBranch();
+    break;
+  case Superinstruction::kLoadStore:
+    executeLoadStore();
+    break;
+  case Superinstruction::kModifyBranch:
+    executeModifyBranch();
+    break;
+  }
+}
+
+bool Cpu65816::enterSecondInstruction() {
+  if (total_cycles_counter_ >= run_end_cycles_ ||
+      events_pending_.load(std::memory_order_relaxed) ||
+      !block_cache_.IsValid(*block_))
+    return false;
+  micro_op_ = &block_->ops[block_pos_++];
+  return true;
+}
+
+void Cpu65816::executeCountBranch() {
+  const uint8_t code = micro_op_->op_code->code();
+  uint16_t &index = (code == 0xCA || code == 0xE8) ? x_ : y_;
+  const int step = (code == 0xE8 || code == 0xC8) ? 1 : -1;
+  if (indexIs8BitWide()) {
+    const uint8_t value = Binary::lower8BitsOf(index) + step;
+    Binary::setLower8BitsOf16BitsValue(&index, value);
+    cpu_status_.updateSignAndZeroFlagFrom8BitValue(value);
+  } else {
+    index += step;
+    cpu_status_.updateSignAndZeroFlagFrom16BitValue(index);
+  }
+  addToProgramAddressAndCycles(1, 2);
+  if (enterSecondInstruction())
+    micro_op_->op_code->execute(*this);
+}
+
+void Cpu65816::executeCompareBranch() {
+  const uint8_t code = micro_op_->op_code->code();
+  const uint16_t value = code == 0xC9 ? a_ : code == 0xE0 ? x_ : y_;
+  const bool narrow =
+      code == 0xC9 ? accumulatorIs8BitWide() : indexIs8BitWide();
+  if (narrow) {
+    const uint8_t operand = micro_op_->operand;
+    const uint8_t lower = Binary::lower8BitsOf(value);
+    cpu_status_.updateSignAndZeroFlagFrom8BitValue(lower - operand);
+    cpu_status_.carry_flag = lower >= operand;
+    addToProgramAddressAndCycles(2, 2);
+  } else {
+    const uint16_t operand = micro_op_->operand;
+    cpu_status_.updateSignAndZeroFlagFrom16BitValue(value - operand);
+    cpu_status_.carry_flag = value >= operand;
+    addToProgramAddressAndCycles(3, 3);
+  }
+  if (enterSecondInstruction())
+    micro_op_->op_code->execute(*this);
+}
+
+void Cpu65816::executeLoadStore() {
+  micro_op_->op_code->execute(*this);
+  if (enterSecondInstruction())
+    micro_op_->op_code->execute(*this);
+}
+
+void Cpu65816::executeModifyBranch() {
+  micro_op_->op_code->execute(*this);
+  if (enterSecondInstruction())
+    micro_op_->op_code->execute(*this);
+}
@@ -21,21 +21,82 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 void SystemBus::RegisterDevice(SystemBusDevice *device) {
+  map_generation_++;
   devices_.push_back({device});
   std::vector<SystemBusDevice::MemoryRegion> handled_regions =
       device->GetMemoryRegions();
   std::copy(handled_regions.begin(), handled_regions.end(),
             std::inserter(memory_regions_, memory_regions_.end()));
+
+  // Pages wholly inside a memory region point straight at its memory. Earlier
+  // regions take precedence, as they do in the region search.
+  for (const auto &r : handled_regions) {
+    uint32_t last_page =
+        std::min(r.end_address >> kPageBits, kNumPages - 1);
+    for (uint32_t i = r.start_address >> kPageBits; i <= last_page; i++) {
+      Page &page = pages_[i];
+      if (page.mem)
+        continue;
+      uint32_t page_start = i << kPageBits;
+      if (!page.partial && r.start_address <= page_start &&
+          r.end_address >= page_start + kPageMask) {
+        page.mem = r.mem + (page_start - r.start_address);
+      } else {
+        page.partial = true;
+      }
+    }
+  }
+
+  std::vector<SystemBusDevice::AddressRange> decoded_ranges;
+  if (!device->GetDecodedRanges(&decoded_ranges)) {
+    for (Page &page : pages_)
+      page.ask_devices = true;
+    return;
+  }
+  // Pages wholly inside a decoded range dispatch straight to the device,
+  // unless an earlier device may decode them: that one takes precedence.
+  for (const auto &r : decoded_ranges) {
+    uint32_t last_page =
+        std::min(r.end_address >> kPageBits, kNumPages - 1);
+    for (uint32_t i = r.start_address >> kPageBits; i <= last_page; i++) {
+      Page &page = pages_[i];
+      if (page.device)
+        continue;
+      uint32_t page_start = i << kPageBits;
+      Address decoded_address;
+      if (!page.ask_devices && r.start_address <= page_start &&
+          r.end_address >= page_start + kPageMask &&
+          device->DecodeAddress(Address(page_start), decoded_address)) {
+        page.device = device;
+        page.device_base = decoded_address.AsInt();
+      } else {
+        page.ask_devices = true;
+      }
+    }
+  }
+}
+
+void SystemBus::InvalidateCodePages(uint32_t address, uint32_t size) {
+  for (uint32_t i = 0; i < size; i += 1 << kCodePageBits) {
+    const uint32_t page =
+        ((address + i) >> kCodePageBits) & (kNumCodePages - 1);
+    if (code_page_watched_[page])
+      InvalidateCodePage(page);
+  }
+  const uint32_t last =
+      ((address + size - 1) >> kCodePageBits) & (kNumCodePages - 1);
+  if (code_page_watched_[last])
+    InvalidateCodePage(last);
 }
 
 void SystemBus::StoreByte(const Address &addr, uint8_t v) {
-  SystemBusDevice::MemoryRegion mem_region;
   const uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    mem_region.mem[offset] = v;
+  NoteWrite(address, 1);
+  if (uint8_t *mem = DirectPointer(address, 1)) {
+    *mem = v;
     return;
   }
 
@@ -48,11 +109,14 @@ void SystemBus::StoreByte(const Address &addr, uint8_t v) {
 }
 
 void SystemBus::StoreWord(const Address &addr, uint16_t v) {
-  SystemBusDevice::MemoryRegion mem_region;
   const uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    *(uint16_t *)(&mem_region.mem[offset]) = v;
+  NoteWrite(address, 2);
+  if (uint8_t *mem = DirectPointer(address, 2)) {
+    *(uint16_t *)mem = v;
+    return;
+  }
+  if (RunsOutOfRam(address)) {
+    StoreSplit(address, v, 2);
     return;
   }
 
@@ -75,11 +139,14 @@ void SystemBus::StoreWord(const Address &addr, uint16_t v) {
 }
 
 void SystemBus::StoreLong(const Address &addr, uint32_t v) {
-  SystemBusDevice::MemoryRegion mem_region;
   const uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    *(uint32_t *)(&mem_region.mem[offset]) = v;
+  NoteWrite(address, 4);
+  if (uint8_t *mem = DirectPointer(address, 4)) {
+    *(uint32_t *)mem = v;
+    return;
+  }
+  if (RunsOutOfRam(address)) {
+    StoreSplit(address, v, 4);
     return;
   }
 
@@ -92,21 +159,14 @@ void SystemBus::StoreLong(const Address &addr, uint32_t v) {
         (uint8_t)((v & 0x00ff0000) >> 16),
         (uint8_t)((v & 0xff000000) >> 24),
     };
-    // TODO optimize with &address
-    device->StoreByte(decoded_address, bytes[0]);
-    device->StoreByte(decoded_address.WithOffset(1), bytes[1]);
-    device->StoreByte(decoded_address.WithOffset(2), bytes[2]);
-    device->StoreByte(decoded_address.WithOffset(3), bytes[3]);
+    device->StoreBlock(decoded_address, bytes, sizeof(bytes));
   }
 }
 
 uint8_t SystemBus::ReadByte(const Address &addr) {
-  SystemBusDevice::MemoryRegion mem_region;
   const uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    return mem_region.mem[offset];
-  }
+  if (const uint8_t *mem = DirectPointer(address, 1))
+    return *mem;
 
   Address decoded_address;
   SystemBusDevice *device = DeviceForAddress(addr, decoded_address);
@@ -117,12 +177,11 @@ uint8_t SystemBus::ReadByte(const Address &addr) {
 }
 
 uint16_t SystemBus::ReadWord(const Address &addr) {
-  SystemBusDevice::MemoryRegion mem_region;
   const uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    return *(uint16_t *)(&mem_region.mem[offset]);
-  }
+  if (const uint8_t *mem = DirectPointer(address, 2))
+    return *(const uint16_t *)mem;
+  if (RunsOutOfRam(address))
+    return ReadSplit(address, 2);
 
   Address decoded_address;
   SystemBusDevice *device = DeviceForAddress(addr, decoded_address);
@@ -145,39 +204,91 @@ uint16_t SystemBus::ReadWord(const Address &addr) {
 }
 
 uint32_t SystemBus::ReadLong(const Address &addr) {
-  SystemBusDevice::MemoryRegion mem_region;
   const uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    return *(uint32_t *)(&mem_region.mem[offset]);
-  }
+  if (const uint8_t *mem = DirectPointer(address, 4))
+    return *(const uint32_t *)mem;
+  if (RunsOutOfRam(address))
+    return ReadSplit(address, 4);
 
   Address decoded_address;
   SystemBusDevice *device = DeviceForAddress(addr, decoded_address);
   if (device) {
-    uint8_t bytes[]{
-        device->ReadByte(decoded_address),
-        device->ReadByte(decoded_address.WithOffset(1)),
-        device->ReadByte(decoded_address.WithOffset(2)),
-        device->ReadByte(decoded_address.WithOffset(3)),
-    };
+    uint8_t bytes[4];
+    device->ReadBlock(decoded_address, bytes, sizeof(bytes));
     return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | bytes[3] << 24;
   }
   return 0;
 }
 
-Address SystemBus::ReadAddressAt(const Address &addr) {
-  SystemBusDevice::MemoryRegion mem_region;
+uint32_t SystemBus::RunLength(uint32_t address, uint32_t size) const {
+  uint32_t length = std::min(size, kPageSize - (address & kPageMask));
+  const uint32_t first = address >> kPageBits;
+  const Page &page = pages_[first];
+  if (!page.device)
+    return length;
+  // Take in the following pages the same device decodes on from where this
+  // one ends, short of the end of the address space.
+  for (uint32_t next = first + 1; length < size && next < kNumPages; next++) {
+    if (pages_[next].device != page.device ||
+        pages_[next].device_base !=
+            page.device_base + ((next - first) << kPageBits)) {
+      break;
+    }
+    length += std::min(size - length, kPageSize);
+  }
+  return length;
+}
+
+void SystemBus::StoreBlock(const Address &addr, const uint8_t *data,
+                           uint32_t size) {
   uint32_t address = addr.AsInt();
-  if (MemoryRegionforAddress(address, &mem_region)) {
-    uint32_t offset = address - mem_region.start_address;
-    struct addr_store {
-      uint32_t value : 24;
-    };
-    addr_store *addr24 =
-        reinterpret_cast<struct addr_store *>(&mem_region.mem[offset]);
-    return Address(addr24->value);
+  while (size > 0) {
+    address &= (kNumPages << kPageBits) - 1;
+    const Page &page = pages_[address >> kPageBits];
+    const uint32_t length = RunLength(address, size);
+    NoteWrite(address, length);
+    if (page.mem) {
+      memcpy(page.mem + (address & kPageMask), data, length);
+    } else if (page.device) {
+      page.device->StoreBlock(
+          Address(page.device_base + (address & kPageMask)), data, length);
+    } else {
+      for (uint32_t i = 0; i < length; i++)
+        StoreByte(Address(address + i), data[i]);
+    }
+    address += length;
+    data += length;
+    size -= length;
   }
+}
+
+void SystemBus::ReadBlock(const Address &addr, uint8_t *data, uint32_t size) {
+  uint32_t address = addr.AsInt();
+  while (size > 0) {
+    address &= (kNumPages << kPageBits) - 1;
+    const Page &page = pages_[address >> kPageBits];
+    const uint32_t length = RunLength(address, size);
+    if (page.mem) {
+      memcpy(data, page.mem + (address & kPageMask), length);
+    } else if (page.device) {
+      page.device->ReadBlock(
+          Address(page.device_base + (address & kPageMask)), data, length);
+    } else {
+      for (uint32_t i = 0; i < length; i++)
+        data[i] = ReadByte(Address(address + i));
+    }
+    address += length;
+    data += length;
+    size -= length;
+  }
+}
+
+Address SystemBus::ReadAddressAt(const Address &addr) {
+  uint32_t address = addr.AsInt();
+  if (const uint8_t *mem = DirectPointer(address, 3))
+    return Address(mem[0] | mem[1] << 8 | mem[2] << 16);
+  if (RunsOutOfRam(address))
+    return Address(ReadSplit(address, 3));
 
   Address decoded_address{0x00, 0x0000};
   SystemBusDevice *device = DeviceForAddress(addr, decoded_address);
@@ -204,8 +315,57 @@ Address SystemBus::ReadAddressAt(const Address &addr) {
   return decoded_address;
 }
 
+uint8_t *SystemBus::SlowDirectPointer(uint32_t address, uint32_t size) const {
+  const uint32_t page_num = (address >> kPageBits) & (kNumPages - 1);
+  const Page &page = pages_[page_num];
+  if (page.mem) {
+    // The access runs into the next page, which is only direct if both pages
+    // are backed by the same block of host memory.
+    if (page_num + 1 < kNumPages &&
+        pages_[page_num + 1].mem == page.mem + kPageSize) {
+      return page.mem + (address & kPageMask);
+    }
+    return nullptr;
+  }
+  if (page.partial) {
+    SystemBusDevice::MemoryRegion mem_region;
+    // The whole access has to fit in the region, or it would run off the end
+    // of the region's memory.
+    if (MemoryRegionforAddress(address, &mem_region) &&
+        address + size - 1 <= mem_region.end_address) {
+      return mem_region.mem + (address - mem_region.start_address);
+    }
+  }
+  return nullptr;
+}
+
+bool SystemBus::RunsOutOfRam(uint32_t address) const {
+  // Only asked once DirectPointer() has failed for the whole access.
+  return DirectPointer(address, 1) != nullptr;
+}
+
+uint32_t SystemBus::ReadSplit(uint32_t address, uint32_t size) {
+  uint32_t v = 0;
+  for (uint32_t i = 0; i < size; i++)
+    v |= ReadByte(Address(address + i)) << (i * 8);
+  return v;
+}
+
+void SystemBus::StoreSplit(uint32_t address, uint32_t v, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++)
+    StoreByte(Address(address + i), (v >> (i * 8)) & 0xFF);
+}
+
 SystemBusDevice *SystemBus::DeviceForAddress(const Address &address,
                                              Address &decoded_address) const {
+  const uint32_t addr = address.AsInt();
+  const Page &page = pages_[addr >> kPageBits];
+  if (page.device) {
+    decoded_address = Address(page.device_base + (addr & kPageMask));
+    return page.device;
+  }
+  if (!page.ask_devices)
+    return nullptr;
   for (SystemBusDevice *device : devices_) {
     if (device->DecodeAddress(address, decoded_address)) {
       return device;
@@ -216,8 +376,8 @@ SystemBusDevice *SystemBus::DeviceForAddress(const Address &address,
 
 bool SystemBus::MemoryRegionforAddress(
     uint32_t address, SystemBusDevice::MemoryRegion *region) const {
-  // Currently O(N), so lots of regions could be non-optimal. Currently not
-  // worth binary type search.
+  // Only used for pages which are partially covered by memory regions; the
+  // page table answers everything else.
   for (const auto &r : memory_regions_) {
     if (address >= r.start_address && address <= r.end_address) {
       *region = r;
@@ -29,6 +29,17 @@
 
 class SystemBus {
 public:
+  // The 24-bit address space is decoded through a flat table of 4k pages.
+  static constexpr uint32_t kPageBits = 12;
+  static constexpr uint32_t kPageSize = 1 << kPageBits;
+  static constexpr uint32_t kPageMask = kPageSize - 1;
+  static constexpr uint32_t kNumPages = (1 << 24) >> kPageBits;
+
+  // Writes to code decoded by the CPU are tracked in finer grained pages, so
+  // that data living next to code does not keep throwing decoded blocks away.
+  static constexpr uint32_t kCodePageBits = 8;
+  static constexpr uint32_t kNumCodePages = (1 << 24) >> kCodePageBits;
+
   virtual ~SystemBus() = default;
 
   void RegisterDevice(SystemBusDevice *device);
@@ -40,12 +51,126 @@ public:
   uint32_t ReadLong(const Address &addr);
   Address ReadAddressAt(const Address &addr);
 
+  // Copy 'size' bytes from 'addr' on, split at page boundaries. RAM pages are
+  // copied with memcpy and each run of pages a device decodes entirely goes
+  // through its block hooks in one call; anything else is done a byte at a
+  // time.
+  void StoreBlock(const Address &addr, const uint8_t *data, uint32_t size);
+  void ReadBlock(const Address &addr, uint8_t *data, uint32_t size);
+
+  // Returns a host pointer to 'size' bytes of RAM at 'address', or nullptr if
+  // any of them are not plain RAM.
+  inline uint8_t *DirectPointer(uint32_t address, uint32_t size) const {
+    const Page &page = pages_[(address >> kPageBits) & (kNumPages - 1)];
+    const uint32_t offset = address & kPageMask;
+    if (page.mem && offset + size <= kPageSize)
+      return page.mem + offset;
+    return SlowDirectPointer(address, size);
+  }
+
+  // Bumped whenever the memory map changes, invalidating host pointers
+  // obtained from DirectPointer().
+  uint32_t map_generation() const { return map_generation_; }
+
+  // Returns the write generation of the code page holding 'address'. The
+  // page is watched from then on: the next write to it bumps the generation.
+  uint32_t WatchCodePage(uint32_t address) {
+    const uint32_t page = (address >> kCodePageBits) & (kNumCodePages - 1);
+    code_page_watched_[page] = true;
+    return code_page_generation_[page];
+  }
+  uint32_t code_page_generation(uint32_t address) const {
+    return code_page_generation_[(address >> kCodePageBits) &
+                                 (kNumCodePages - 1)];
+  }
+
+  // Records a write to 'size' bytes at 'address'. Called for every store made
+  // through the bus; anything modifying RAM behind the bus's back (loaders,
+  // DMA) has to call it too.
+  inline void NoteWrite(uint32_t address, uint32_t size) {
+    const uint32_t first = (address >> kCodePageBits) & (kNumCodePages - 1);
+    const uint32_t last =
+        ((address + size - 1) >> kCodePageBits) & (kNumCodePages - 1);
+    if (first == last) {
+      if (code_page_watched_[first])
+        InvalidateCodePage(first);
+      return;
+    }
+    InvalidateCodePages(address, size);
+  }
+
 private:
+  friend class Dynarec;
+
+  struct Page {
+    // Host memory for the start of the page, if the page is entirely RAM.
+    uint8_t *mem = nullptr;
+    // Set when memory regions only partially cover the page, in which case
+    // the regions have to be searched.
+    bool partial = false;
+    // The device which decodes the entire page, and what it decodes the start
+    // of the page to.
+    SystemBusDevice *device = nullptr;
+    uint32_t device_base = 0;
+    // Set when devices may decode part of the page, in which case they have
+    // to be asked in turn.
+    bool ask_devices = false;
+  };
+
+  uint8_t *SlowDirectPointer(uint32_t address, uint32_t size) const;
+
+  void InvalidateCodePage(uint32_t page) {
+    code_page_watched_[page] = false;
+    code_page_generation_[page]++;
+  }
+  void InvalidateCodePages(uint32_t address, uint32_t size);
+
+  // Accesses which start in RAM but run past it, into a page backed by
+  // different memory or by a device or off the end of a memory region, are
+  // done a byte at a time.
+  bool RunsOutOfRam(uint32_t address) const;
+  uint32_t ReadSplit(uint32_t address, uint32_t size);
+  void StoreSplit(uint32_t address, uint32_t v, uint32_t size);
+  // Bytes from 'address' on, up to 'size', which a block access can take in
+  // one go: the rest of the page, or of the run of pages one device decodes
+  // contiguously.
+  uint32_t RunLength(uint32_t address, uint32_t size) const;
   SystemBusDevice *DeviceForAddress(const Address &, Address &) const;
   bool MemoryRegionforAddress(uint32_t address,
                               SystemBusDevice::MemoryRegion *region) const;
   std::vector<SystemBusDevice::MemoryRegion> memory_regions_;
   std::vector<SystemBusDevice *> devices_;
+  Page pages_[kNumPages];
+  uint32_t map_generation_ = 0;
+  uint32_t code_page_generation_[kNumCodePages] = {};
+  bool code_page_watched_[kNumCodePages] = {};
+};
+
+// Host pointer to the RAM page around an address that gets hit over and
+// over, like the stack or the direct page. The page is only looked up again
+// when the address moves to another page or the memory map changes.
+class PageWindow {
+public:
+  // Returns a pointer to 'size' bytes at 'address', or nullptr if they are
+  // not all in one RAM page.
+  uint8_t *Get(const SystemBus &bus, uint32_t address, uint32_t size) {
+    const uint32_t page = address >> SystemBus::kPageBits;
+    if (page != page_ || generation_ != bus.map_generation()) {
+      page_ = page;
+      generation_ = bus.map_generation();
+      mem_ = bus.DirectPointer(page << SystemBus::kPageBits,
+                               SystemBus::kPageSize);
+    }
+    const uint32_t offset = address & SystemBus::kPageMask;
+    if (!mem_ || offset + size > SystemBus::kPageSize)
+      return nullptr;
+    return mem_ + offset;
+  }
+
+private:
+  uint32_t page_ = ~0u;
+  uint32_t generation_ = 0;
+  uint8_t *mem_ = nullptr;
 };
 
 #endif
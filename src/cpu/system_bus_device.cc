@@ -70,6 +70,18 @@ size_t Address::Size(const Address &begin, const Address &end) {
 
 uint32_t Address::AsInt() const { return (bank_ << 16) | offset_; }
 
+void SystemBusDevice::StoreBlock(const Address &addr, const uint8_t *data,
+                                 uint32_t size) {
+  for (uint32_t i = 0; i < size; i++)
+    StoreByte(Address(addr.AsInt() + i), data[i]);
+}
+
+void SystemBusDevice::ReadBlock(const Address &addr, uint8_t *data,
+                                uint32_t size) {
+  for (uint32_t i = 0; i < size; i++)
+    data[i] = ReadByte(Address(addr.AsInt() + i));
+}
+
 std::ostream &operator<<(std::ostream &out, const Address &addr) {
   out << "0x" << std::hex << (int)addr.bank_ << ":" << std::hex << std::setw(4)
       << std::setfill('0') << addr.offset_;
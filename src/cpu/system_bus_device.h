@@ -87,6 +87,11 @@ public:
     uint8_t *mem;
   };
 
+  struct AddressRange {
+    uint32_t start_address;
+    uint32_t end_address;
+  };
+
   virtual ~SystemBusDevice() = default;
 
   /**
@@ -95,6 +100,17 @@ public:
    */
   virtual std::vector<MemoryRegion> GetMemoryRegions() { return {}; };
 
+  /**
+   * Fill 'ranges' with the address ranges this device decodes, so that the
+   * bus can find it from its page table instead of asking every device in
+   * turn. A range has to decode linearly, to consecutive decoded addresses.
+   * Devices which return false may decode anything, and are asked through
+   * DecodeAddress about every access the page table doesn't answer.
+   */
+  virtual bool GetDecodedRanges(std::vector<AddressRange> *ranges) {
+    return false;
+  };
+
   /**
     Stores one byte to the real address represented by the specified virtual
     address. That is: maps the virtual address to the real one and stores one
@@ -113,6 +129,16 @@ public:
    */
   virtual uint8_t ReadByte(const Address &, uint8_t **physical_address = 0) = 0;
 
+  /**
+    Bulk versions of StoreByte and ReadByte for 'size' bytes from the
+    specified, already decoded, address on. The bus uses them for long
+    accesses to a device and for block copies over pages the device decodes
+    entirely. Devices which can do better than a byte at a time override
+    these.
+   */
+  virtual void StoreBlock(const Address &, const uint8_t *data, uint32_t size);
+  virtual void ReadBlock(const Address &, uint8_t *data, uint32_t size);
+
   /**
     Returns true if the address was decoded successfully by this device.
    */
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bus/ram_device.h"
+#include "cpu/system_bus.h"
+
+TEST(SystemBusTest, WordAcrossUnrelatedPages) {
+  RAMDevice low(Address(0x0, 0x0), Address(0x0, 0x0fff));
+  RAMDevice high(Address(0x0, 0x1000), Address(0x0, 0x1fff));
+  SystemBus bus;
+  bus.RegisterDevice(&low);
+  bus.RegisterDevice(&high);
+  bus.StoreLong(Address(0x0, 0x0ffe), 0xdeadbeef);
+  EXPECT_EQ(bus.ReadByte(Address(0x0, 0x0fff)), 0xbe);
+  EXPECT_EQ(bus.ReadByte(Address(0x0, 0x1000)), 0xad);
+  EXPECT_EQ(bus.ReadWord(Address(0x0, 0x0fff)), 0xadbe);
+  EXPECT_EQ(bus.ReadLong(Address(0x0, 0x0ffe)), 0xdeadbeef);
+  EXPECT_EQ(high.region().mem[0], 0xad);
+}
+
+TEST(SystemBusTest, PartialPage) {
+  RAMDevice memory(Address(0x0, 0x0200), Address(0x0, 0x12ff));
+  SystemBus bus;
+  bus.RegisterDevice(&memory);
+  bus.StoreWord(Address(0x0, 0x0200), 0xcafe);
+  bus.StoreWord(Address(0x0, 0x12fe), 0xbeef);
+  EXPECT_EQ(memory.region().mem[0], 0xfe);
+  EXPECT_EQ(bus.ReadWord(Address(0x0, 0x12fe)), 0xbeef);
+  EXPECT_EQ(bus.ReadByte(Address(0x0, 0x0100)), 0);
+  EXPECT_EQ(bus.DirectPointer(0x1300, 1), nullptr);
+}
+
+namespace {
+
+// Memory region backed by a larger buffer, so accesses which run off the end
+// of the region would read the guard bytes after it.
+class GuardedMemory : public SystemBusDevice {
+public:
+  GuardedMemory(uint32_t start, uint32_t end)
+      : buffer_(end - start + 1 + 0x100, 0xa5),
+        region_{start, end, buffer_.data()} {
+    std::fill(buffer_.begin(), buffer_.begin() + (end - start + 1), 0);
+  }
+
+  std::vector<MemoryRegion> GetMemoryRegions() override { return {region_}; }
+  void StoreByte(const Address &, uint8_t, uint8_t **) override {}
+  uint8_t ReadByte(const Address &, uint8_t **) override { return 0; }
+  bool DecodeAddress(const Address &, Address &) override { return false; }
+
+  uint8_t *mem() { return region_.mem; }
+
+private:
+  std::vector<uint8_t> buffer_;
+  MemoryRegion region_;
+};
+
+} // namespace
+
+TEST(SystemBusTest, Blocks) {
+  // Whole pages, a partially covered page and unmapped space.
+  GuardedMemory memory(0x0, 0x12ff);
+  SystemBus bus;
+  bus.RegisterDevice(&memory);
+  uint8_t data[0x1400];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = i * 7;
+  bus.StoreBlock(Address(0x0, 0x0), data, sizeof(data));
+  EXPECT_EQ(memcmp(memory.mem(), data, 0x1300), 0);
+  for (size_t i = 0x1300; i < 0x1400; i++)
+    ASSERT_EQ(memory.mem()[i], 0xa5) << i;
+
+  uint8_t read[0x1400];
+  bus.ReadBlock(Address(0x0, 0x0), read, sizeof(read));
+  EXPECT_EQ(memcmp(read, data, 0x1300), 0);
+  for (size_t i = 0x1300; i < sizeof(read); i++)
+    ASSERT_EQ(read[i], 0) << i;
+  EXPECT_EQ(bus.ReadLong(Address(0x0, 0x12fe)),
+            data[0x12fe] | data[0x12ff] << 8);
+  EXPECT_EQ(bus.ReadWord(Address(0x0, 0x12ff)), data[0x12ff]);
+  EXPECT_EQ(bus.DirectPointer(0x12fe, 4), nullptr);
+
+  bus.StoreLong(Address(0x0, 0x12fe), 0xdeadbeef);
+  EXPECT_EQ(memory.mem()[0x12ff], 0xbe);
+  EXPECT_EQ(memory.mem()[0x1300], 0xa5);
+}
+
+namespace {
+
+// Registers over whole pages, which counts how often it is asked to decode.
+class Registers : public SystemBusDevice {
+public:
+  Registers(uint32_t start, uint32_t end, uint32_t base)
+      : start_(start), end_(end), base_(base), regs_(end - start + 1) {}
+
+  bool GetDecodedRanges(std::vector<AddressRange> *ranges) override {
+    *ranges = {{start_, end_}};
+    return true;
+  }
+  void StoreByte(const Address &addr, uint8_t v, uint8_t **) override {
+    regs_.at(addr.AsInt() - base_) = v;
+  }
+  uint8_t ReadByte(const Address &addr, uint8_t **) override {
+    return regs_.at(addr.AsInt() - base_);
+  }
+  void StoreBlock(const Address &addr, const uint8_t *data,
+                  uint32_t size) override {
+    blocks_++;
+    SystemBusDevice::StoreBlock(addr, data, size);
+  }
+  void ReadBlock(const Address &addr, uint8_t *data, uint32_t size) override {
+    blocks_++;
+    SystemBusDevice::ReadBlock(addr, data, size);
+  }
+  bool DecodeAddress(const Address &addr, Address &decoded) override {
+    decodes_++;
+    if (addr.AsInt() < start_ || addr.AsInt() > end_)
+      return false;
+    decoded = Address(addr.AsInt() - start_ + base_);
+    return true;
+  }
+
+  std::vector<uint8_t> &regs() { return regs_; }
+  int decodes() const { return decodes_; }
+  int blocks() const { return blocks_; }
+
+private:
+  uint32_t start_;
+  uint32_t end_;
+  uint32_t base_;
+  std::vector<uint8_t> regs_;
+  int decodes_ = 0;
+  int blocks_ = 0;
+};
+
+} // namespace
+
+TEST(SystemBusTest, DevicePages) {
+  RAMDevice memory(Address(0x0, 0x0), Address(0x0, 0xffff));
+  Registers regs(0x21000, 0x22fff, 0x400);
+  // Only covers part of its first page, so that page has to ask.
+  Registers partial(0x30800, 0x31fff, 0x0);
+  SystemBus bus;
+  bus.RegisterDevice(&memory);
+  bus.RegisterDevice(&regs);
+  bus.RegisterDevice(&partial);
+  const int regs_decodes = regs.decodes();
+  const int partial_decodes = partial.decodes();
+
+  bus.StoreByte(Address(0x2, 0x1000), 0x12);
+  bus.StoreWord(Address(0x2, 0x2ffe), 0x3456);
+  EXPECT_EQ(regs.regs()[0], 0x12);
+  EXPECT_EQ(regs.regs()[0x1ffe], 0x56);
+  EXPECT_EQ(regs.regs()[0x1fff], 0x34);
+  EXPECT_EQ(bus.ReadLong(Address(0x2, 0x1000)), 0x12u);
+  EXPECT_EQ(bus.ReadByte(Address(0x2, 0x3000)), 0);
+  // Neither found through DecodeAddress.
+  EXPECT_EQ(regs.decodes(), regs_decodes);
+  EXPECT_EQ(partial.decodes(), partial_decodes);
+
+  bus.StoreByte(Address(0x3, 0x0800), 0x78);
+  bus.StoreByte(Address(0x3, 0x1000), 0x9a);
+  EXPECT_EQ(partial.regs()[0], 0x78);
+  EXPECT_EQ(partial.regs()[0x800], 0x9a);
+  EXPECT_EQ(partial.decodes(), partial_decodes + 1);
+}
+
+TEST(SystemBusTest, DeviceBlocks) {
+  Registers regs(0x21000, 0x22fff, 0x400);
+  SystemBus bus;
+  bus.RegisterDevice(&regs);
+  uint8_t data[0x1800];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = i * 7;
+  // Across both of the device's pages in one call.
+  bus.StoreBlock(Address(0x2, 0x1800), data, sizeof(data));
+  EXPECT_EQ(regs.blocks(), 1);
+  EXPECT_EQ(memcmp(regs.regs().data() + 0x800, data, 0x1800), 0);
+
+  uint8_t read[0x2000];
+  bus.ReadBlock(Address(0x2, 0x1000), read, sizeof(read));
+  EXPECT_EQ(regs.blocks(), 2);
+  EXPECT_EQ(memcmp(read + 0x800, data, 0x1800), 0);
+}
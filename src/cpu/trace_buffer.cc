@@ -0,0 +1,237 @@
+#include "cpu/trace_buffer.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include <glog/logging.h>
+
+namespace {
+
+// Records streamed or dumped per write().
+constexpr uint64_t kChunkRecords = 128;
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+  size_t power = 1;
+  while (power < n)
+    power <<= 1;
+  return power;
+}
+
+bool WriteAll(int fd, const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    const ssize_t written = write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool WriteHeader(int fd) {
+  TraceFileHeader header;
+  memcpy(header.magic, TraceFileHeader::kMagic, sizeof(header.magic));
+  header.version = TraceFileHeader::kVersion;
+  header.record_size = sizeof(TraceRecord);
+  return WriteAll(fd, &header, sizeof(header));
+}
+
+int OpenForWriting(const std::string &path) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    LOG(ERROR) << "Cannot open " << path << ": " << strerror(errno);
+  return fd;
+}
+
+// The buffer registered by DumpOnCrash(), taken by whichever crash path gets
+// to it first.
+std::atomic<const TraceBuffer *> crash_buffer{nullptr};
+char crash_path[4096];
+
+void DumpCrashTrace() {
+  const TraceBuffer *buffer = crash_buffer.exchange(nullptr);
+  if (!buffer)
+    return;
+  const int fd = open(crash_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return;
+  buffer->DumpTo(fd);
+  close(fd);
+}
+
+void OnFatalSignal(int signal_number) {
+  DumpCrashTrace();
+  // Carry on dying the way we would have without the handler.
+  signal(signal_number, SIG_DFL);
+  raise(signal_number);
+}
+
+[[noreturn]] void OnCheckFailure() {
+  DumpCrashTrace();
+  abort();
+}
+
+} // namespace
+
+TraceBuffer::TraceBuffer(size_t capacity)
+    : mask_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 1)) - 1),
+      words_(new std::atomic<uint64_t>[(mask_ + 1) * kRecordWords]) {}
+
+TraceBuffer::~TraceBuffer() {
+  StopStreaming();
+  const TraceBuffer *self = this;
+  crash_buffer.compare_exchange_strong(self, nullptr);
+}
+
+uint64_t TraceBuffer::CopyOut(uint64_t begin, uint64_t end,
+                              TraceRecord *out) const {
+  for (uint64_t i = begin; i < end; i++) {
+    const std::atomic<uint64_t> *slot = &words_[(i & mask_) * kRecordWords];
+    uint64_t words[kRecordWords];
+    for (int w = 0; w < kRecordWords; w++)
+      words[w] = slot[w].load(std::memory_order_relaxed);
+    memcpy(&out[i - begin], words, sizeof(TraceRecord));
+  }
+  // Any record a full buffer older than one the producer has started
+  // writing may have been overwritten while it was copied.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t claimed = claimed_.load(std::memory_order_relaxed);
+  const uint64_t oldest_intact =
+      claimed > capacity() ? claimed - capacity() : 0;
+  if (oldest_intact <= begin)
+    return 0;
+  return std::min(oldest_intact, end) - begin;
+}
+
+std::vector<TraceRecord> TraceBuffer::Last(size_t count) const {
+  const uint64_t end = recorded();
+  const uint64_t available = std::min<uint64_t>(end, capacity());
+  const uint64_t begin = end - std::min<uint64_t>(count, available);
+  std::vector<TraceRecord> records(end - begin);
+  const uint64_t lost = CopyOut(begin, end, records.data());
+  records.erase(records.begin(), records.begin() + lost);
+  return records;
+}
+
+bool TraceBuffer::DumpTo(int fd) const {
+  if (!WriteHeader(fd))
+    return false;
+  const uint64_t end = recorded();
+  uint64_t begin = end > capacity() ? end - capacity() : 0;
+  TraceRecord chunk[kChunkRecords];
+  while (begin < end) {
+    const uint64_t count = std::min(end - begin, kChunkRecords);
+    const uint64_t lost = CopyOut(begin, begin + count, chunk);
+    if (!WriteAll(fd, chunk + lost, (count - lost) * sizeof(TraceRecord)))
+      return false;
+    begin += count;
+  }
+  return true;
+}
+
+bool TraceBuffer::Dump(const std::string &path) const {
+  const int fd = OpenForWriting(path);
+  if (fd < 0)
+    return false;
+  const bool ok = DumpTo(fd);
+  if (!ok)
+    LOG(ERROR) << "Writing " << path << " failed: " << strerror(errno);
+  close(fd);
+  return ok;
+}
+
+void TraceBuffer::DumpOnCrash(const std::string &path) {
+  snprintf(crash_path, sizeof(crash_path), "%s", path.c_str());
+  crash_buffer.store(this);
+  google::InstallFailureFunction(&OnCheckFailure);
+  for (int signal_number : {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT})
+    signal(signal_number, OnFatalSignal);
+}
+
+bool TraceBuffer::StartStreaming(const std::string &path) {
+  StopStreaming();
+  const int fd = OpenForWriting(path);
+  if (fd < 0)
+    return false;
+  if (!WriteHeader(fd)) {
+    LOG(ERROR) << "Writing " << path << " failed: " << strerror(errno);
+    close(fd);
+    return false;
+  }
+  streaming_.store(true, std::memory_order_release);
+  streamer_ = std::thread(&TraceBuffer::Stream, this, fd, recorded());
+  return true;
+}
+
+void TraceBuffer::StopStreaming() {
+  if (!streamer_.joinable())
+    return;
+  streaming_.store(false, std::memory_order_release);
+  streamer_.join();
+  if (dropped() > 0)
+    LOG(WARNING) << "Trace streaming fell behind, " << dropped()
+                 << " records were lost";
+}
+
+void TraceBuffer::Stream(int fd, uint64_t next) {
+  std::vector<TraceRecord> chunk(kChunkRecords);
+  for (;;) {
+    // Drain whatever was appended before being asked to stop.
+    const bool stopping = !streaming_.load(std::memory_order_acquire);
+    const uint64_t end = recorded();
+    if (end - next > capacity()) {
+      dropped_.fetch_add(end - capacity() - next, std::memory_order_relaxed);
+      next = end - capacity();
+    }
+    if (next == end) {
+      if (stopping)
+        break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    const uint64_t count = std::min(end - next, kChunkRecords);
+    const uint64_t lost = CopyOut(next, next + count, chunk.data());
+    dropped_.fetch_add(lost, std::memory_order_relaxed);
+    if (!WriteAll(fd, chunk.data() + lost,
+                  (count - lost) * sizeof(TraceRecord))) {
+      LOG(ERROR) << "Writing the trace failed: " << strerror(errno);
+      break;
+    }
+    next += count;
+  }
+  close(fd);
+}
+
+// static
+bool TraceBuffer::ReadFile(const std::string &path,
+                           std::vector<TraceRecord> *records) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    LOG(ERROR) << "Cannot open " << path;
+    return false;
+  }
+  TraceFileHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      memcmp(header.magic, TraceFileHeader::kMagic, sizeof(header.magic)) ||
+      header.version != TraceFileHeader::kVersion ||
+      header.record_size != sizeof(TraceRecord)) {
+    LOG(ERROR) << path << " is not a trace file";
+    return false;
+  }
+  records->clear();
+  TraceRecord record;
+  while (in.read(reinterpret_cast<char *>(&record), sizeof(record)))
+    records->push_back(record);
+  return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The state of the CPU just before it executed one instruction. Fixed size
+// and plain old data, so trace files are simply arrays of them.
+struct TraceRecord {
+  uint64_t cycles;
+  // 24-bit address of the opcode.
+  uint32_t program_address;
+  uint16_t a;
+  uint16_t x;
+  uint16_t y;
+  uint16_t sp;
+  uint16_t dp;
+  uint8_t op_code;
+  uint8_t db;
+  uint8_t p;
+  uint8_t emulation;
+};
+static_assert(sizeof(TraceRecord) == 32, "trace files depend on the layout");
+
+// Starts every trace file, followed by the records, oldest first.
+struct TraceFileHeader {
+  static constexpr char kMagic[8] = {'C', '2', '5', '6', 'T', 'R', 'C', '\0'};
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+};
+
+// Lock-free ring buffer of the most recently executed instructions.
+//
+// Only the thread running the CPU appends. The newest records can be dumped
+// post-mortem, or a background thread can stream them to a file while the
+// CPU runs; if it falls a whole buffer behind, the overwritten records are
+// counted in dropped() instead. Trace files are turned back into text by
+// the c256_trace_decode tool.
+class TraceBuffer {
+public:
+  static constexpr size_t kDefaultCapacity = 1 << 20;
+
+  // |capacity| is rounded up to a power of two.
+  explicit TraceBuffer(size_t capacity = kDefaultCapacity);
+  ~TraceBuffer();
+
+  TraceBuffer(const TraceBuffer &) = delete;
+  TraceBuffer &operator=(const TraceBuffer &) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  void Append(const TraceRecord &record) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    // Tell readers the slot is about to change before changing it.
+    claimed_.store(head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t words[kRecordWords];
+    memcpy(words, &record, sizeof(record));
+    std::atomic<uint64_t> *slot = &words_[(head & mask_) * kRecordWords];
+    for (int i = 0; i < kRecordWords; i++)
+      slot[i].store(words[i], std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // Number of records appended so far.
+  uint64_t recorded() const { return head_.load(std::memory_order_acquire); }
+
+  // Returns up to |count| of the newest records, oldest first. Only exact
+  // while the CPU is stopped.
+  std::vector<TraceRecord> Last(size_t count) const;
+
+  // Writes a trace file of everything still in the buffer. Neither
+  // allocates nor locks, so it is safe to call from a crash handler.
+  bool DumpTo(int fd) const;
+  bool Dump(const std::string &path) const;
+
+  // Dumps the buffer to |path| when the process dies from a fatal signal or
+  // a failed CHECK. Only one buffer can be registered at a time.
+  void DumpOnCrash(const std::string &path);
+
+  // Starts a thread appending records to the trace file at |path| as they
+  // are produced, until StopStreaming().
+  bool StartStreaming(const std::string &path);
+  void StopStreaming();
+
+  // Records overwritten before the streaming thread got to them.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // Reads a trace file written by Dump() or StartStreaming().
+  static bool ReadFile(const std::string &path,
+                       std::vector<TraceRecord> *records);
+
+private:
+  static constexpr int kRecordWords = sizeof(TraceRecord) / sizeof(uint64_t);
+
+  // Copies the records numbered [begin, end) into |out|, returning how many
+  // of them at the start were overwritten while copying and are garbage.
+  uint64_t CopyOut(uint64_t begin, uint64_t end, TraceRecord *out) const;
+  // Writes records from number |next| onwards to |fd|.
+  void Stream(int fd, uint64_t next);
+
+  const size_t mask_;
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  // Records published so far, and records whose slot is being written.
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> claimed_{0};
+
+  std::thread streamer_;
+  std::atomic<bool> streaming_{false};
+  std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The legacy core is built into a library of its own that only exports
+// what is declared here: it and WDC65C816 each bring their own SystemBus.
+#define LOCKSTEP_EXPORT __attribute__((visibility("default")))
+
+// One of the two 65816 cores c256_lockstep runs side by side, each on its
+// own copy of the memory image.
+class LockstepCore {
+public:
+  struct Registers {
+    uint32_t program_address;
+    uint16_t a, x, y;
+    // NVMXDIZC, with M and X set in emulation mode.
+    uint8_t p;
+    bool emulation;
+    uint64_t cycles;
+
+    bool wide_accumulator() const { return !(p & 0x20); }
+    bool wide_index() const { return !(p & 0x10); }
+  };
+
+  struct Write {
+    uint32_t address;
+    uint8_t value;
+  };
+
+  virtual ~LockstepCore() = default;
+
+  // Executes one instruction. Returns false if the core couldn't.
+  virtual bool Step() = 0;
+
+  virtual Registers registers() const = 0;
+
+  // The memory image, which is as big as the one the core was made with.
+  virtual const uint8_t *memory() const = 0;
+
+  // Memory written by the last Step(), for cores that can tell.
+  virtual const std::vector<Write> &writes() const = 0;
+};
+
+inline uint8_t MakeStatusRegister(bool n, bool v, bool m, bool x, bool d,
+                                  bool i, bool z, bool c, bool emulation) {
+  return n << 7 | v << 6 | (m || emulation) << 5 | (x || emulation) << 4 |
+         d << 3 | i << 2 | z << 1 | c;
+}
+
+// Both cores copy |image| and start from its reset vector.
+LOCKSTEP_EXPORT std::unique_ptr<LockstepCore>
+MakeLegacyCore(const uint8_t *image, size_t size);
+std::unique_ptr<LockstepCore> MakeReferenceCore(const uint8_t *image,
+                                                size_t size);
+
+// Disassembles the instruction at |address| of |memory|, using the legacy
+// core's opcode table.
+LOCKSTEP_EXPORT std::string DisassembleAt(const uint8_t *memory, size_t size,
+                                          uint32_t address,
+                                          const LockstepCore::Registers &);
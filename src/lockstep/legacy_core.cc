@@ -0,0 +1,79 @@
+// The Cpu65816 half of c256_lockstep.
+
+#include <cstring>
+
+#include "bus/ram_device.h"
+#include "cpu/cpu_65816.h"
+#include "cpu/disassembler.h"
+#include "lockstep/core.h"
+
+namespace {
+
+class LegacyCore : public LockstepCore {
+public:
+  LegacyCore(const uint8_t *image, size_t size)
+      : memory_(Address(0, 0), Address((size - 1) >> 16, (size - 1) & 0xFFFF)) {
+    bus_.RegisterDevice(&memory_);
+    memcpy(memory_.region().mem, image, size);
+    cpu_ = std::make_unique<Cpu65816>(bus_, &emulation_interrupts_,
+                                      &native_interrupts_);
+    cpu_->SetRESPin(false);
+  }
+
+  // Goes through Run() rather than ExecuteNextInstruction(), so decoded
+  // blocks and superinstructions get checked too.
+  bool Step() override { return cpu_->Run(1) > 0; }
+
+  Registers registers() const override {
+    const CpuStatus &status = *cpu_->cpu_status();
+    Registers registers;
+    registers.program_address = cpu_->program_address().AsInt();
+    registers.a = cpu_->a();
+    registers.x = cpu_->x();
+    registers.y = cpu_->y();
+    registers.p = MakeStatusRegister(
+        status.sign_flag(), status.overflow_flag,
+        status.accumulator_width_flag, status.index_width_flag,
+        status.decimal_flag, status.interrupt_disable_flag,
+        status.zero_flag(), status.carry_flag, status.emulation_flag);
+    registers.emulation = status.emulation_flag;
+    registers.cycles = cpu_->total_cycles_counter();
+    return registers;
+  }
+
+  const uint8_t *memory() const override { return memory_.region().mem; }
+
+  // The fast paths write RAM directly, so there is no cheap way of telling.
+  const std::vector<Write> &writes() const override { return no_writes_; }
+
+private:
+  RAMDevice memory_;
+  SystemBus bus_;
+  EmulationModeInterrupts emulation_interrupts_{0xfff4, 0xfff8, 0xfff8,
+                                                0xfffa, 0xfffc, 0xfffe};
+  NativeModeInterrupts native_interrupts_{0xffe4, 0xffe6, 0xffe8,
+                                          0xffea, 0xfffc, 0xffee};
+  std::unique_ptr<Cpu65816> cpu_;
+  const std::vector<Write> no_writes_;
+};
+
+} // namespace
+
+std::unique_ptr<LockstepCore> MakeLegacyCore(const uint8_t *image,
+                                             size_t size) {
+  return std::make_unique<LegacyCore>(image, size);
+}
+
+std::string DisassembleAt(const uint8_t *memory, size_t size,
+                          uint32_t address,
+                          const LockstepCore::Registers &registers) {
+  uint8_t bytes[4] = {};
+  for (uint32_t i = 0; i < 4; i++) {
+    // Operands wrap around within the bank, like the program counter.
+    const uint32_t at = (address & 0xFF0000) | ((address + i) & 0xFFFF);
+    if (at < size)
+      bytes[i] = memory[at];
+  }
+  return Disassemble(bytes, address, registers.wide_accumulator(),
+                     registers.wide_index());
+}
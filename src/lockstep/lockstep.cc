@@ -0,0 +1,261 @@
+// Runs the legacy Cpu65816 core and the WDC65C816 core the emulator uses in
+// lockstep on identical memory images, comparing registers, flags and
+// memory after every instruction. Stops at the first divergence and prints
+// the instructions leading up to it.
+//
+// usage: c256_lockstep [--kernel_bin=<file>] [--seed=N --runs=N]
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "lockstep/core.h"
+
+DEFINE_string(kernel_bin, "",
+              "kernel .bin file to run instead of random instruction streams");
+DEFINE_uint64(seed, 1, "seed of the first random instruction stream");
+DEFINE_uint64(runs, 1, "number of random instruction streams to try");
+DEFINE_uint64(steps, 1000000, "instructions to run each stream for");
+DEFINE_int32(banks, 0x20, "64k banks of RAM each core gets");
+DEFINE_uint64(memory_compare_interval, 64,
+              "instructions between comparisons of the whole memory images");
+DEFINE_bool(compare_cycles, false, "also compare cycle counts");
+DEFINE_int32(history, 16, "instructions to print before a divergence");
+
+namespace {
+
+constexpr uint32_t kRandomStreamStart = 0x1000;
+
+struct Executed {
+  LockstepCore::Registers before;
+  std::string instruction;
+};
+
+std::string FormatRegisters(const LockstepCore::Registers &r) {
+  char text[128];
+  snprintf(text, sizeof(text),
+           "PC=%02x:%04x A=%04x X=%04x Y=%04x P=%02x%s CYC=%" PRIu64,
+           r.program_address >> 16, r.program_address & 0xFFFF, r.a, r.x, r.y,
+           r.p, r.emulation ? " E" : "", r.cycles);
+  return text;
+}
+
+// Describes how |legacy| differs from |reference|, or returns "".
+std::string CompareRegisters(const LockstepCore::Registers &reference,
+                             const LockstepCore::Registers &legacy) {
+  std::string differences;
+  auto compare = [&differences](const char *name, uint32_t reference_value,
+                                uint32_t legacy_value) {
+    if (reference_value == legacy_value)
+      return;
+    char text[64];
+    snprintf(text, sizeof(text), " %s (%x vs %x)", name, reference_value,
+             legacy_value);
+    differences += text;
+  };
+  compare("PC", reference.program_address, legacy.program_address);
+  compare("A", reference.a, legacy.a);
+  // The high byte of 8-bit index registers is always zero on a real 65816,
+  // but neither core is obliged to keep it that way internally.
+  const uint16_t index_mask = reference.wide_index() ? 0xFFFF : 0xFF;
+  compare("X", reference.x & index_mask, legacy.x & index_mask);
+  compare("Y", reference.y & index_mask, legacy.y & index_mask);
+  compare("P", reference.p, legacy.p);
+  compare("E", reference.emulation, legacy.emulation);
+  if (FLAGS_compare_cycles)
+    compare("cycles", reference.cycles, legacy.cycles);
+  return differences;
+}
+
+std::string CompareMemory(const LockstepCore &reference,
+                          const LockstepCore &legacy, size_t size) {
+  std::string differences;
+  int shown = 0;
+  for (uint32_t address = 0; address < size; address++) {
+    const uint8_t reference_value = reference.memory()[address];
+    const uint8_t legacy_value = legacy.memory()[address];
+    if (reference_value == legacy_value)
+      continue;
+    if (shown++ == 8) {
+      differences += " ...";
+      break;
+    }
+    char text[64];
+    snprintf(text, sizeof(text), " %02x:%04x (%02x vs %02x)", address >> 16,
+             address & 0xFFFF, reference_value, legacy_value);
+    differences += text;
+  }
+  return differences;
+}
+
+// Checks the bytes the reference core says it just wrote, which catches
+// most memory divergences without comparing the whole images.
+std::string CompareWrites(const LockstepCore &reference,
+                          const LockstepCore &legacy) {
+  std::string differences;
+  for (const LockstepCore::Write &write : reference.writes()) {
+    const uint8_t legacy_value = legacy.memory()[write.address];
+    if (legacy_value == write.value)
+      continue;
+    char text[64];
+    snprintf(text, sizeof(text), " %02x:%04x (%02x vs %02x)",
+             write.address >> 16, write.address & 0xFFFF, write.value,
+             legacy_value);
+    differences += text;
+  }
+  return differences;
+}
+
+void ReportDivergence(const std::string &what, uint64_t step,
+                      const std::deque<Executed> &history,
+                      const LockstepCore &reference,
+                      const LockstepCore &legacy) {
+  printf("Cores diverged at instruction %" PRIu64 ":%s\n", step,
+         what.c_str());
+  for (size_t i = 0; i < history.size(); i++) {
+    const Executed &executed = history[i];
+    printf("%s %02x:%04x %-16s %s\n", i + 1 == history.size() ? ">" : " ",
+           executed.before.program_address >> 16,
+           executed.before.program_address & 0xFFFF,
+           executed.instruction.c_str(),
+           FormatRegisters(executed.before).c_str());
+  }
+  printf("reference: %s\n", FormatRegisters(reference.registers()).c_str());
+  printf("legacy:    %s\n", FormatRegisters(legacy.registers()).c_str());
+}
+
+// Returns false if the cores diverged.
+bool RunLockstep(const std::vector<uint8_t> &image) {
+  std::unique_ptr<LockstepCore> reference =
+      MakeReferenceCore(image.data(), image.size());
+  std::unique_ptr<LockstepCore> legacy =
+      MakeLegacyCore(image.data(), image.size());
+
+  std::deque<Executed> history;
+  std::string differences =
+      CompareRegisters(reference->registers(), legacy->registers());
+  if (!differences.empty()) {
+    ReportDivergence(" after reset" + differences, 0, history, *reference,
+                     *legacy);
+    return false;
+  }
+
+  for (uint64_t step = 0; step < FLAGS_steps; step++) {
+    const LockstepCore::Registers before = reference->registers();
+    history.push_back({before, DisassembleAt(reference->memory(), image.size(),
+                                             before.program_address, before)});
+    if (history.size() > static_cast<size_t>(std::max(FLAGS_history, 1)))
+      history.pop_front();
+
+    const bool reference_stepped = reference->Step();
+    const bool legacy_stepped = legacy->Step();
+    if (!reference_stepped && !legacy_stepped) {
+      printf("Both cores stopped after %" PRIu64 " instructions\n", step);
+      break;
+    }
+    if (reference_stepped != legacy_stepped) {
+      differences = legacy_stepped ? " only the legacy core executed it"
+                                   : " only the reference core executed it";
+    } else {
+      differences =
+          CompareRegisters(reference->registers(), legacy->registers());
+      if (!differences.empty())
+        differences = " registers" + differences;
+    }
+    if (differences.empty()) {
+      differences = CompareWrites(*reference, *legacy);
+      if (differences.empty() &&
+          (step + 1) % std::max<uint64_t>(FLAGS_memory_compare_interval, 1) ==
+              0)
+        differences = CompareMemory(*reference, *legacy, image.size());
+      if (!differences.empty())
+        differences = " memory" + differences;
+    }
+    if (!differences.empty()) {
+      ReportDivergence(differences, step, history, *reference, *legacy);
+      return false;
+    }
+  }
+
+  differences = CompareMemory(*reference, *legacy, image.size());
+  if (!differences.empty()) {
+    ReportDivergence(" memory at the end" + differences, FLAGS_steps, history,
+                     *reference, *legacy);
+    return false;
+  }
+  return true;
+}
+
+// Random bytes, with the reset vector pointing into them. The other vectors
+// are left random too; whatever the stream makes of them is part of the
+// test.
+std::vector<uint8_t> RandomImage(uint64_t seed, size_t size) {
+  std::mt19937_64 random(seed);
+  std::vector<uint8_t> image(size);
+  for (uint8_t &byte : image) {
+    byte = random();
+    // STP and WAI would only stop both cores, ending the run early.
+    if (byte == 0xDB || byte == 0xCB)
+      byte = 0xEA;
+  }
+  image[0xFFFC] = kRandomStreamStart & 0xFF;
+  image[0xFFFD] = kRandomStreamStart >> 8;
+  return image;
+}
+
+bool LoadKernelImage(const std::string &path, size_t size,
+                     std::vector<uint8_t> *image) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    LOG(ERROR) << "Cannot open " << path;
+    return false;
+  }
+  const std::vector<uint8_t> kernel((std::istreambuf_iterator<char>(in)),
+                                    std::istreambuf_iterator<char>());
+  // Loaded into flash at $18:0000, which GAVIN copies to bank 0 at boot.
+  constexpr uint32_t kFlashAddress = 0x180000;
+  if (kernel.empty() || kFlashAddress + kernel.size() > size) {
+    LOG(ERROR) << path << " doesn't fit in " << FLAGS_banks << " banks";
+    return false;
+  }
+  image->assign(size, 0);
+  std::copy(kernel.begin(), kernel.end(), image->begin() + kFlashAddress);
+  std::copy_n(image->begin() + kFlashAddress, 0x10000, image->begin());
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  google::ParseCommandLineFlags(&argc, &argv, false);
+
+  const size_t size = static_cast<size_t>(std::clamp(FLAGS_banks, 1, 0x100))
+                      << 16;
+  if (!FLAGS_kernel_bin.empty()) {
+    std::vector<uint8_t> image;
+    if (!LoadKernelImage(FLAGS_kernel_bin, size, &image))
+      return 2;
+    return RunLockstep(image) ? 0 : 1;
+  }
+
+  for (uint64_t seed = FLAGS_seed; seed < FLAGS_seed + FLAGS_runs; seed++) {
+    if (!RunLockstep(RandomImage(seed, size))) {
+      printf("(seed %" PRIu64 ")\n", seed);
+      return 1;
+    }
+  }
+  printf("No divergence in %" PRIu64 " streams of %" PRIu64
+         " instructions\n",
+         FLAGS_runs, FLAGS_steps);
+  return 0;
+}
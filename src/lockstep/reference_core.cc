@@ -0,0 +1,119 @@
+// The WDC65C816 half of c256_lockstep.
+
+#include <limits>
+
+#include "cpu/65816/cpu_65c816.h"
+#include "lockstep/core.h"
+
+namespace {
+
+// Flat RAM the size of the image, the rest of the address space reading as
+// zero. Every page is an I/O page so that each access goes through the
+// callbacks, which is how writes get logged.
+class LoggingBus : public SystemBus {
+public:
+  LoggingBus(const uint8_t *image, size_t size) : ram_(image, image + size) {
+    Init(12, 24, pages);
+    for (Page &p : pages) {
+      p.ptr = 0;
+      p.flags = 0;
+      p.io_mask = 0;
+      p.io_eq = 0;
+      p.cycles_per_access = 1;
+    }
+    io_devices.context = this;
+    io_devices.read = &IoRead;
+    io_devices.write = &IoWrite;
+    io_devices.is_io_device_address = &IsIoDeviceAddress;
+    io_devices.irq_taken = [](void *, uint32_t) {};
+  }
+
+  const uint8_t *ram() const { return ram_.data(); }
+  const std::vector<LockstepCore::Write> &writes() const { return writes_; }
+  void ClearWrites() { writes_.clear(); }
+
+private:
+  static bool IsIoDeviceAddress(void *context, cpuaddr_t addr) {
+    return true;
+  }
+  static void IoRead(void *context, cpuaddr_t addr, uint8_t *data,
+                     uint32_t size) {
+    LoggingBus *self = (LoggingBus *)context;
+    for (uint32_t i = 0; i < size; i++) {
+      const uint32_t at = (addr + i) & 0xFFFFFF;
+      data[i] = at < self->ram_.size() ? self->ram_[at] : 0;
+    }
+  }
+  static void IoWrite(void *context, cpuaddr_t addr, const uint8_t *data,
+                      uint32_t size) {
+    LoggingBus *self = (LoggingBus *)context;
+    for (uint32_t i = 0; i < size; i++) {
+      const uint32_t at = (addr + i) & 0xFFFFFF;
+      if (at >= self->ram_.size())
+        continue;
+      self->ram_[at] = data[i];
+      self->writes_.push_back({at, data[i]});
+    }
+  }
+
+  Page pages[4096];
+  std::vector<uint8_t> ram_;
+  std::vector<LockstepCore::Write> writes_;
+};
+
+class ReferenceCore : public LockstepCore {
+public:
+  ReferenceCore(const uint8_t *image, size_t size)
+      : bus_(image, size), cpu_(&bus_) {
+    cpu_.PowerOn();
+    cpu_.cpu_state.cycle = 0;
+    events_.Start(&cpu_.cpu_state.event_cycle, cpu_.cpu_state.cycle_stop);
+  }
+
+  bool Step() override {
+    bus_.ClearWrites();
+    const auto start = cpu_.cpu_state.cycle;
+    // Stops again once an instruction has gone by, the same way
+    // System::Stop() does.
+    cpu_.cpu_state.cycle_stop =
+        std::numeric_limits<decltype(cpu_.cpu_state.cycle_stop)>::max();
+    events_.Schedule(start + 1, [this]() { cpu_.cpu_state.cycle_stop = 0; });
+    cpu_.Emulate(&events_);
+    return cpu_.cpu_state.cycle != start;
+  }
+
+  Registers registers() const override {
+    const auto &cpu_state = cpu_.cpu_state;
+    Registers registers;
+    registers.program_address = cpu_.program_address() & 0xFFFFFF;
+    registers.a = cpu_.a();
+    registers.x = cpu_.x();
+    registers.y = cpu_.y();
+    registers.p = MakeStatusRegister(
+        cpu_state.is_negative(), cpu_state.is_overflow(), !cpu_.mode_long_a,
+        !cpu_.mode_long_xy, cpu_state.is_decimal(),
+        !cpu_state.interrupts_enabled(), cpu_state.is_zero(),
+        cpu_state.is_carry(), cpu_.mode_emulation);
+    registers.emulation = cpu_.mode_emulation;
+    registers.cycles = cpu_state.cycle;
+    return registers;
+  }
+
+  const uint8_t *memory() const override { return bus_.ram(); }
+
+  const std::vector<Write> &writes() const override {
+    return bus_.writes();
+  }
+
+private:
+  LoggingBus bus_;
+  WDC65C816 cpu_;
+  EventQueue events_;
+};
+
+} // namespace
+
+std::unique_ptr<LockstepCore> MakeReferenceCore(const uint8_t *image,
+                                                size_t size) {
+  return std::make_unique<ReferenceCore>(image, size);
+}
@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include "bus/automation.h"
 #include "bus/system.h"
@@ -12,6 +13,8 @@ DEFINE_bool(profile, false, "enable CPU performance profiling");
 DEFINE_bool(automation, false, "enable Lua automation / debug scripting");
 DEFINE_string(kernel_hex, "", "Location of kernel .hex file");
 DEFINE_string(kernel_bin, "", "Location of kernel .bin file");
+DEFINE_string(flash_bin, "", "System flash .bin image, mapped at $F00000");
+DEFINE_string(user_flash_bin, "", "User flash .bin image, mapped at $F80000");
 DEFINE_string(script, "", "Lua script to run on start (automation only)");
 DEFINE_string(program_hex, "", "Program HEX file to load (optional)");
 
@@ -23,12 +26,26 @@ int main(int argc, char *argv[]) {
   LOG(INFO) << "Good morning.";
 
   System system;
-  if (!FLAGS_kernel_hex.empty())
+  if (!FLAGS_flash_bin.empty()) system.MapFlash(FLAGS_flash_bin, 0xF00000);
+  if (!FLAGS_user_flash_bin.empty())
+    system.MapFlash(FLAGS_user_flash_bin, 0xF80000);
+
+  const bool kernel_in_flash =
+      !FLAGS_flash_bin.empty() &&
+      (FLAGS_kernel_bin.empty() || FLAGS_kernel_bin == FLAGS_flash_bin);
+  if (!FLAGS_kernel_hex.empty()) {
     system.LoadHex(FLAGS_kernel_hex);
-  else if (!FLAGS_kernel_bin.empty())
+  } else if (kernel_in_flash) {
+    // As GAVIN does, copy the kernel out of the flash already mapped, rather
+    // than loading the file again.
+    std::vector<uint8_t> kernel(0x80000);
+    system.ReadBlock(0xF00000, kernel.data(), kernel.size());
+    system.WriteBlock(0x180000, kernel.data(), kernel.size());
+  } else if (!FLAGS_kernel_bin.empty()) {
     system.LoadBin(FLAGS_kernel_bin, 0x180000);
-  else
+  } else {
     LOG(FATAL) << "No kernel";
+  }
 
   if (!FLAGS_program_hex.empty()) system.LoadHex(FLAGS_program_hex);
 
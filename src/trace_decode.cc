@@ -0,0 +1,30 @@
+// Turns trace files written by TraceBuffer into one line of text per
+// instruction.
+//
+// usage: c256_trace_decode <trace file>
+
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "cpu/cpu_65816.h"
+#include "cpu/trace_buffer.h"
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+    return 2;
+  }
+  std::vector<TraceRecord> records;
+  if (!TraceBuffer::ReadFile(argv[1], &records))
+    return 1;
+
+  for (const TraceRecord &r : records) {
+    printf("%012" PRIu64 " %02x:%04x %s (%02x) A=%04x X=%04x Y=%04x "
+           "S=%04x D=%04x DB=%02x P=%02x%s\n",
+           r.cycles, r.program_address >> 16, r.program_address & 0xFFFF,
+           Cpu65816::DescribeOpCode(r.op_code).name(), r.op_code, r.a, r.x,
+           r.y, r.sp, r.dp, r.db, r.p, r.emulation ? " E" : "");
+  }
+  return 0;
+}